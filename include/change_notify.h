@@ -0,0 +1,74 @@
+#ifndef CHANGE_NOTIFY_H
+#define CHANGE_NOTIFY_H
+
+#include <Arduino.h>
+
+// Report-by-Exception Change Notifications
+// Instead of polling CMD_GET_STATUS on every node, the host subscribes once
+// (CMD_SUBSCRIBE, usually broadcast) and then repeatedly broadcasts
+// CMD_POLL_CHANGES. Only nodes with something to report answer, each in its
+// device ID slot (see RS485_REPLY_SLOT_US), so bus traffic follows the rate
+// of change instead of the node count. A node with no changes still answers
+// once per heartbeat interval so the host can tell it is alive.
+//
+// Output paths mark what changed in a dirty mask; a notification carries
+// only the dirty fields and clears them. Notifications are numbered, so a
+// host that sees a gap in the sequence should re-read the full state
+// (CMD_GET_TELEMETRY). Subscriptions are not persistent: a node that
+// rebooted stops answering until the host subscribes again.
+//
+// Notification: [seq][dirty mask] followed, in bit order, by
+//   CHANGE_SIG1..3: [mode 'v'/'c'][setpoint, centi-units u16 big endian]
+//   CHANGE_RELAYS:  [relay bitmap]
+//   CHANGE_WAVE:    [flags (TELEMETRY_WAVE_*)][mode][period, tenths of s u16]
+// A heartbeat is a notification with an empty mask. On the bus the
+// notification is packed 6 bits per byte (packRS485Payload()) so setpoint
+// or sequence bytes equal to 0x55/0xAA cannot end or restart the reply;
+// the largest one (16 bytes, 22 packed) fits in one reply slot.
+
+// Dirty mask bits
+#define CHANGE_SIG1 0x01
+#define CHANGE_SIG2 0x02
+#define CHANGE_SIG3 0x04
+#define CHANGE_RELAYS 0x08
+#define CHANGE_WAVE 0x10
+#define CHANGE_ALL 0x1F
+
+#define CHANGE_NOTIFY_MAX_SIZE 16
+#define CHANGE_HEARTBEAT_DEFAULT_S 10
+
+/**
+ * Record that part of the reported state changed
+ * Safe from any task on either core.
+ * @param bits CHANGE_* bits
+ */
+void markStateChanged(uint8_t bits);
+
+/**
+ * Mark a signal's mode or setpoint as changed
+ * @param sig Signal number (1-3)
+ */
+void markSignalChanged(uint8_t sig);
+
+/**
+ * Subscribe to change notifications
+ * Marks all subscribed state dirty so the first poll reports a full image.
+ * @param mask CHANGE_* bits to report, 0 to unsubscribe
+ * @param heartbeatS Heartbeat interval in seconds, 0 for none
+ */
+void subscribeChanges(uint8_t mask, uint8_t heartbeatS);
+
+/**
+ * Build the notification for a poll, if one is due
+ * Clears the reported dirty bits and advances the sequence number.
+ * @param out Output buffer of CHANGE_NOTIFY_MAX_SIZE bytes
+ * @return Notification length, 0 if there is nothing to send
+ */
+uint8_t buildChangeNotification(uint8_t* out);
+
+/**
+ * Print subscription state to the USB serial port
+ */
+void printChangeNotifyStatus();
+
+#endif // CHANGE_NOTIFY_H
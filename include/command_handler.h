@@ -11,12 +11,48 @@
 void initCommandHandler();
 
 /**
- * Process serial input commands
- *
- * Called in `loop()` to receive and process commands.
- * @param command Complete command string input by user
+ * Parse "SIG,MODE" and set the signal mode
+ * @param params Parameters, tokenized in place
+ */
+void parseModeCommand(char* params);
+
+/**
+ * Parse "SIG,VALUE" and set the signal value
+ * @param params Parameters, tokenized in place
+ */
+void parseValueCommand(char* params);
+
+/**
+ * Set signal mode with output protection
+ * Zeroes the output that is being switched away from, then moves the relays.
+ * @param sig Signal number (1-3)
+ * @param mode 'v' for voltage, 'c' for current
+ * @return true on success, false on invalid arguments
+ */
+bool setSignalMode(uint8_t sig, char mode);
+
+/**
+ * Set signal output value in the signal's current mode
+ * @param sig Signal number (1-3)
+ * @param value Voltage (0-10V) or current (0-25mA)
+ * @return true on success, false on invalid arguments
+ */
+bool setSignalValue(uint8_t sig, float value);
+
+/**
+ * Write a signal's output in its current mode, clamped to the mode's range
+ * Quiet variant of setSignalValue() for periodic writers; output engine only.
+ * @param sig Signal number (1-3)
+ * @param value Voltage (V) or current (mA)
+ */
+void writeSignalOutput(uint8_t sig, float value);
+
+/**
+ * Get the value last written to the signal's DAC in its current mode
+ * Covers every output path (commands, waveform, stream, RS-485).
+ * @param sig Signal number (1-3)
+ * @return Output value, 0 for invalid signal numbers
  */
-void parseModeCommand(String params);
-void parseValueCommand(String params);
+float getSignalValue(uint8_t sig);
 
 #endif // COMMAND_HANDLER_H
@@ -0,0 +1,132 @@
+#ifndef COMMAND_REGISTRY_H
+#define COMMAND_REGISTRY_H
+
+#include <Arduino.h>
+
+// Command Registry
+// Compile-time table describing every command of a protocol: opcode, handler,
+// accepted payload length and behaviour flags. Lookup by opcode is a single
+// index into a dense 256-entry table built at compile time, and payload
+// length checks are shared instead of repeated in every handler.
+// Used by the RS-485 protocol; other front ends (USB text, Modbus) can build
+// their own table or look up RS-485 commands by name.
+
+// Command flags
+#define CMD_FLAG_MUTATES_OUTPUTS 0x01      // Changes DAC or relay outputs
+#define CMD_FLAG_SAFE_DURING_WAVEFORM 0x02 // Allowed while a sine wave is running
+#define CMD_FLAG_NO_ACK 0x04               // Never followed by an ACK frame
+
+// Command handler signature
+typedef bool (*CommandHandlerFn)(const uint8_t* data, uint8_t length);
+
+// Command descriptor
+struct CommandSpec {
+    uint8_t opcode;           // Command type byte
+    const char* name;         // Lower-case name for text front ends
+    CommandHandlerFn handler; // Handler function
+    uint8_t minLength;        // Minimum payload length
+    uint8_t maxLength;        // Maximum payload length
+    uint8_t flags;            // CMD_FLAG_* bits
+};
+
+// Result of validating a command against its descriptor
+enum CommandCheck {
+    CMD_CHECK_OK,
+    CMD_CHECK_UNKNOWN,        // No descriptor for this opcode
+    CMD_CHECK_BAD_LENGTH,     // Payload length outside [minLength, maxLength]
+    CMD_CHECK_BUSY            // Would fight a running waveform
+};
+
+/**
+ * Validate a command before dispatch
+ * @param spec Descriptor returned by CommandTable::find()
+ * @param length Payload length
+ * @param waveformActive true if a waveform is currently driving outputs
+ * @return CMD_CHECK_OK if the handler may run
+ */
+inline CommandCheck checkCommand(const CommandSpec* spec, uint8_t length, bool waveformActive) {
+    if (!spec) {
+        return CMD_CHECK_UNKNOWN;
+    }
+    if (length < spec->minLength || length > spec->maxLength) {
+        return CMD_CHECK_BAD_LENGTH;
+    }
+    if (waveformActive && (spec->flags & CMD_FLAG_MUTATES_OUTPUTS) &&
+        !(spec->flags & CMD_FLAG_SAFE_DURING_WAVEFORM)) {
+        return CMD_CHECK_BUSY;
+    }
+    return CMD_CHECK_OK;
+}
+
+/**
+ * Check that no opcode is registered twice (for static_assert)
+ */
+template <size_t N>
+constexpr bool hasUniqueOpcodes(const CommandSpec (&specs)[N]) {
+    for (size_t i = 0; i < N; i++) {
+        for (size_t j = i + 1; j < N; j++) {
+            if (specs[i].opcode == specs[j].opcode) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Dense opcode-indexed command table
+ * Constructed as a constexpr object so both the descriptors and the index
+ * live in flash.
+ */
+template <size_t N>
+class CommandTable {
+public:
+    constexpr CommandTable(const CommandSpec (&specs)[N]) : specs_(), index_() {
+        for (size_t i = 0; i < N; i++) {
+            specs_[i] = specs[i];
+            index_[specs[i].opcode] = (uint8_t)(i + 1);
+        }
+    }
+
+    /**
+     * Find a command by opcode
+     * @param opcode Command type byte
+     * @return Descriptor, or nullptr if the opcode is not registered
+     */
+    const CommandSpec* find(uint8_t opcode) const {
+        uint8_t slot = index_[opcode];
+        return slot ? &specs_[slot - 1] : nullptr;
+    }
+
+    /**
+     * Find a command by name (case-insensitive)
+     * @param name Command name
+     * @return Descriptor, or nullptr if no command has that name
+     */
+    const CommandSpec* findByName(const char* name) const {
+        for (size_t i = 0; i < N; i++) {
+            if (strcasecmp(specs_[i].name, name) == 0) {
+                return &specs_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Get a descriptor's position in the table (for per-command arrays)
+     * @param spec Descriptor returned by find()
+     * @return Index in [0, size())
+     */
+    size_t indexOf(const CommandSpec* spec) const {
+        return (size_t)(spec - specs_);
+    }
+
+    constexpr size_t size() const { return N; }
+    const CommandSpec& operator[](size_t i) const { return specs_[i]; }
+
+private:
+    CommandSpec specs_[N];
+    uint8_t index_[256];
+};
+
+#endif // COMMAND_REGISTRY_H
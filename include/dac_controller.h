@@ -17,6 +17,16 @@ public:
      * @return Returns true on success, false on failure
      */
     bool setVoltage(float voltage, uint8_t channel = 0);
+
+    /**
+     * Get the voltage last written to a channel
+     * @param channel Output channel (0 or 1)
+     * @return Voltage (V)
+     */
+    float getVoltage(uint8_t channel = 0) const { return _voltage[channel & 1]; }
+
+private:
+    volatile float _voltage[2] = {0.0f, 0.0f};
 };
 
 // GP8313 class definition: for current output
@@ -27,9 +37,18 @@ public:
 
     /**
      * Set current output
-     * @param current Target output current (unit: mA), range 0-25mA
+     * @param current Target output current (unit: uA), range 0-25000uA
      */
-    void setDACOutElectricCurrent(uint16_t current) { setDACOutVoltage(current); }
+    void setDACOutElectricCurrent(uint16_t current);
+
+    /**
+     * Get the current last written
+     * @return Current (mA)
+     */
+    float getCurrent() const { return _current; }
+
+private:
+    volatile float _current = 0.0f;
 };
 
 // Global DAC instance declarations
@@ -0,0 +1,99 @@
+#ifndef DEBUG_LOG_H
+#define DEBUG_LOG_H
+
+#include <Arduino.h>
+
+// Deferred Debug Logging
+// LOG_* macros format the message into a lock-free ring and return; a
+// low-priority task writes the ring to the USB serial port. Hot paths (DAC
+// writes, relay switching, RS-485 frames, waveform ticks) never block on the
+// debug port. When the ring is full, messages are dropped and counted.
+//
+// Messages above LOG_LEVEL or outside LOG_CATEGORIES are removed at compile
+// time, format strings included. Both can be set from build_flags, e.g.
+//   -DLOG_LEVEL=LOG_LEVEL_WARN -DLOG_CATEGORIES=LOG_CAT_RS485
+// The runtime level and category mask (USB "log" command) filter further.
+//
+// Interactive command replies (help, list, ...) still use Serial directly.
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Categories (bit mask)
+#define LOG_CAT_SYSTEM 0x01
+#define LOG_CAT_DAC 0x02
+#define LOG_CAT_RELAY 0x04
+#define LOG_CAT_RS485 0x08
+#define LOG_CAT_MODBUS 0x10
+#define LOG_CAT_WAVE 0x20
+#define LOG_CAT_STREAM 0x40
+#define LOG_CAT_ALL 0x7F
+
+#ifndef LOG_CATEGORIES
+#define LOG_CATEGORIES LOG_CAT_ALL
+#endif
+
+#define LOG_RING_SIZE 64          // Messages held until drained (power of two)
+#define LOG_MESSAGE_MAX 96        // Characters per message, longer ones are cut
+#define LOG_DRAIN_INTERVAL_MS 10
+#define LOG_TASK_PRIORITY 1
+#define LOG_TASK_STACK 3072
+
+#define LOG_AT(level, category, ...) \
+    do { \
+        if ((level) <= LOG_LEVEL && ((category) & LOG_CATEGORIES)) { \
+            logWrite((level), (category), __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_ERROR(category, ...) LOG_AT(LOG_LEVEL_ERROR, category, __VA_ARGS__)
+#define LOG_WARN(category, ...) LOG_AT(LOG_LEVEL_WARN, category, __VA_ARGS__)
+#define LOG_INFO(category, ...) LOG_AT(LOG_LEVEL_INFO, category, __VA_ARGS__)
+#define LOG_DEBUG(category, ...) LOG_AT(LOG_LEVEL_DEBUG, category, __VA_ARGS__)
+
+/**
+ * Start the log drain task
+ * Messages logged earlier are held in the ring until it runs.
+ */
+void initDebugLog();
+
+/**
+ * Queue one message (use the LOG_* macros instead)
+ * Safe from any task on either core; never blocks.
+ * @param level LOG_LEVEL_*
+ * @param category LOG_CAT_*
+ * @param format printf format, without trailing newline
+ */
+void logWrite(uint8_t level, uint8_t category, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+/**
+ * Set the runtime level (messages above it are discarded)
+ * @param level LOG_LEVEL_NONE to LOG_LEVEL_DEBUG
+ */
+void setLogLevel(uint8_t level);
+
+/**
+ * Set the runtime category mask
+ * @param mask LOG_CAT_* bits
+ */
+void setLogCategories(uint8_t mask);
+
+/**
+ * Get number of messages dropped because the ring was full
+ * @return Dropped message count
+ */
+uint32_t getLogDroppedCount();
+
+/**
+ * Print log settings and counters to the USB serial port
+ */
+void printLogStatus();
+
+#endif // DEBUG_LOG_H
@@ -0,0 +1,120 @@
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Binary Event Trace
+// A flight recorder for timing problems: each trace point stores a micros()
+// timestamp, an event ID and two small arguments in a fixed ring, oldest
+// records being overwritten. Recording is a flag test, one atomic increment
+// and an 8 byte store, so hooks can stay in the RS-485, DAC, relay and
+// waveform paths permanently. Build with -DEVENT_TRACE=0 to remove them.
+//
+// Records are read back over USB ("trace" prints CSV: seq,t_us,event,arg8,arg16)
+// or over RS-485 (CMD_GET_TRACE, see rs485_command_handler.h). Sequence
+// numbers let a host tool stitch chunks together and spot overwritten gaps.
+// A record being dumped while it is rewritten can come out torn; freeze
+// the trace first when that matters.
+
+#ifndef EVENT_TRACE
+#define EVENT_TRACE 1
+#endif
+
+#define TRACE_RING_SIZE 256        // Records (power of two), 8 bytes each
+
+// Event IDs (arguments in brackets)
+#define TRACE_FRAME_RX 0x01        // Frame queued for this node [opcode][payload length]
+#define TRACE_FRAME_DROP 0x02      // Frame discarded [TRACE_DROP_*][opcode]
+#define TRACE_REPLY_TX 0x03        // Reply written to the bus [opcode][payload length]
+#define TRACE_CMD_BEGIN 0x10       // Handler started [opcode][queue wait us]
+#define TRACE_CMD_END 0x11         // Handler returned [opcode][1 = success]
+#define TRACE_DAC_VOLTAGE 0x20     // GP8413 write [I2C address << 1 | channel][DAC code]
+#define TRACE_DAC_CURRENT 0x21     // GP8313 write [I2C address][current, uA]
+#define TRACE_RELAY 0x30           // Relay switched [relay 1-6][state]
+#define TRACE_TICK_BEGIN 0x40      // Output engine tick [missed ticks][timer latency us]
+#define TRACE_TICK_END 0x41        // Output engine tick done [0][run time us]
+
+// TRACE_FRAME_DROP reasons
+#define TRACE_DROP_FRAMING 1
+#define TRACE_DROP_TOO_LONG 2
+#define TRACE_DROP_QUEUE_FULL 3
+
+struct TraceRecord {
+    uint32_t timestamp;   // micros()
+    uint8_t event;
+    uint8_t arg8;
+    uint16_t arg16;
+};
+
+extern TraceRecord traceRing[TRACE_RING_SIZE];
+extern std::atomic<uint32_t> traceHead;   // Sequence number of the next record
+extern volatile bool traceEnabled;
+
+/**
+ * Record one trace event
+ * Safe from any task on either core and from interrupts.
+ * @param event TRACE_* event ID
+ * @param arg8 First argument
+ * @param arg16 Second argument (saturate or truncate before passing)
+ */
+static inline void traceEvent(uint8_t event, uint8_t arg8 = 0, uint16_t arg16 = 0) {
+#if EVENT_TRACE
+    if (!traceEnabled) {
+        return;
+    }
+    uint32_t seq = traceHead.fetch_add(1, std::memory_order_relaxed);
+    TraceRecord& record = traceRing[seq % TRACE_RING_SIZE];
+    record.timestamp = micros();
+    record.event = event;
+    record.arg8 = arg8;
+    record.arg16 = arg16;
+#else
+    (void)event;
+    (void)arg8;
+    (void)arg16;
+#endif
+}
+
+/**
+ * Clamp a microsecond interval into a 16-bit trace argument
+ */
+static inline uint16_t traceClampUs(uint32_t us) {
+    return us > 0xFFFF ? 0xFFFF : (uint16_t)us;
+}
+
+/**
+ * Start or stop recording (the ring keeps its contents)
+ * @param enabled true to record
+ */
+void setTraceEnabled(bool enabled);
+
+/**
+ * Discard all records and restart the sequence at 0
+ */
+void clearTrace();
+
+/**
+ * Copy records out of the ring
+ * Records older than the ring holds are skipped: the first copied record
+ * is the later of from and the oldest retained one.
+ * @param from Sequence number of the first wanted record
+ * @param out Destination
+ * @param maxCount Capacity of out
+ * @param first Receives the sequence number of out[0]
+ * @return Number of records copied
+ */
+uint16_t readTrace(uint32_t from, TraceRecord* out, uint16_t maxCount, uint32_t* first);
+
+/**
+ * Get the sequence number the next record will receive
+ */
+uint32_t getTraceHead();
+
+/**
+ * Print the retained records as CSV to the USB serial port
+ * Recording is paused while printing so the dump is consistent.
+ */
+void dumpTrace();
+
+#endif // EVENT_TRACE_H
@@ -0,0 +1,93 @@
+#ifndef MODBUS_DIAGNOSTICS_H
+#define MODBUS_DIAGNOSTICS_H
+
+#include <Arduino.h>
+
+// Modbus Diagnostics
+// Traffic counters kept around the ModbusRTU instance, readable by any master
+// through FC08 (Diagnostics) and a block of input registers.
+//
+// FC08 sub-functions answered (data field = counter, low 16 bits):
+//   0x00 Return query data             0x0B Bus message count
+//   0x01 Restart communications        0x0C Bus communication error (CRC) count
+//        (clears the counters)         0x0D Bus exception error count
+//   0x02 Return diagnostic register    0x0E Server message count
+//   0x0A Clear counters                0x0F Server no response count
+//                                      0x10 Server NAK count (always 0)
+//                                      0x11 Server busy count (always 0)
+// Other sub-functions are answered with an illegal function exception.
+//
+// Input registers (FC04), 32-bit counters as high word, low word:
+//   0xF040-0xF041      Bus messages (every frame seen on the segment)
+//   0xF042-0xF043      Frames failing the CRC check (any address)
+//   0xF044-0xF045      Exception responses sent
+//   0xF046-0xF047      Server messages (requests addressed to this slave)
+//   0xF048-0xF049      Requests left unanswered (broadcasts)
+//   0xF04A             Requests per second over the last second
+//   0xF04B             Average turnaround (us)
+//   0xF04C             Worst turnaround (us)
+//   0xF04D             Last turnaround (us)
+//   0xF050 + 2*i       Requests with function code i (see diagFunctionCodes)
+//                      FC 1, 2, 3, 4, 5, 6, 8, 15, 16, 22, 23, then all others
+
+#define MB_DIAG_BASE 0xF040
+#define MB_DIAG_FC_BASE (MB_DIAG_BASE + 0x10)
+#define MB_DIAG_FC_SLOTS 12
+#define MB_DIAG_IREG_COUNT (0x10 + 2 * MB_DIAG_FC_SLOTS)
+#define MB_DIAG_RATE_WINDOW_MS 1000
+
+// Diagnostic counters
+struct ModbusDiagnostics {
+    uint32_t busMessages;      // Frames seen on the bus, any address
+    uint32_t crcErrors;        // Frames dropped by the CRC check (any address)
+    uint32_t exceptions;       // Exception responses sent
+    uint32_t serverMessages;   // Frames for this slave (including broadcasts)
+    uint32_t noResponse;       // Requests not answered (broadcasts)
+    uint32_t functionCodes[MB_DIAG_FC_SLOTS]; // Requests per function code
+    uint16_t requestsPerSecond;
+};
+
+/**
+ * Register the raw frame hook and the diagnostics input registers
+ * Call after mb.begin(), with the Modbus lock held or before the task starts.
+ */
+void initModbusDiagnostics();
+
+/**
+ * Count the end of a frame on the line
+ * Called from the UART RX timeout event, once per frame.
+ */
+void noteModbusFrameEnd();
+
+/**
+ * Start accounting for one mb.task() poll (Modbus task)
+ */
+void beginModbusDiagnosticsPoll();
+
+/**
+ * Account for the frame handled by mb.task(), if any (Modbus task)
+ */
+void endModbusDiagnosticsPoll();
+
+/**
+ * Record a request answered without exception (Modbus task)
+ */
+void recordModbusSuccess();
+
+/**
+ * Get diagnostic counters
+ * @return Counters (updated by the Modbus task)
+ */
+const ModbusDiagnostics* getModbusDiagnostics();
+
+/**
+ * Clear all diagnostic counters
+ */
+void resetModbusDiagnostics();
+
+/**
+ * Print diagnostic counters to the USB serial port
+ */
+void printModbusDiagnostics();
+
+#endif // MODBUS_DIAGNOSTICS_H
@@ -0,0 +1,67 @@
+#ifndef MODBUS_GENERATOR_H
+#define MODBUS_GENERATOR_H
+
+#include <Arduino.h>
+
+// Modbus Register Generators
+// Make register bank entries change over time so the simulated slave looks
+// like a live field instrument. All generators are advanced from one periodic
+// tick and stage the new value in the register bank, which publishes it
+// between master transactions.
+//   counter <rate>                     Add <rate> per second (energy/flow totals)
+//   ramp <min> <max> <period_s>        Sawtooth from min to max, then restart
+//   sine <center> <amplitude> <period_s>
+//   noise <center> <amplitude>         Uniform random in center +/- amplitude
+
+#define MB_GENERATOR_MAX 64       // Maximum number of active generators
+#define MB_GENERATOR_TICK_MS 100  // Update period
+
+// Generator kinds
+enum ModbusGeneratorKind {
+    GEN_NONE,
+    GEN_COUNTER,
+    GEN_RAMP,
+    GEN_SINE,
+    GEN_NOISE
+};
+
+/**
+ * Initialize register generators (none active)
+ */
+void initModbusGenerators();
+
+/**
+ * Attach a generator to a register bank entry (replaces any existing one)
+ * @param address Register bank entry address
+ * @param kind Generator kind
+ * @param p1 counter: rate/s, ramp: min, sine/noise: center
+ * @param p2 ramp: max, sine/noise: amplitude
+ * @param p3 ramp/sine: period in seconds
+ * @return true on success
+ */
+bool setModbusGenerator(uint16_t address, ModbusGeneratorKind kind, float p1, float p2, float p3);
+
+/**
+ * Detach the generator from an entry
+ * @param address Register bank entry address
+ * @return true if a generator was removed
+ */
+bool clearModbusGenerator(uint16_t address);
+
+/**
+ * Advance all generators (call this in main loop)
+ */
+void updateModbusGenerators();
+
+/**
+ * Print active generators to the USB serial port
+ */
+void listModbusGenerators();
+
+/**
+ * Parse "<addr> <kind> [params...]" or "<addr> off" or "list"
+ * @param input Command text after "gen "
+ */
+void parseModbusGeneratorCommand(char* input);
+
+#endif // MODBUS_GENERATOR_H
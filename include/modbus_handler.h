@@ -4,36 +4,86 @@
 #include <ModbusRTU.h>
 
 // Modbus configuration
-#define SLAVE_ID 0x01       // Device Address but maybe in the future we can make variations?
 #define BAUDRATE 19200      // Serial Bit Rate
 #define PARITY SERIAL_8E1   // 8 data bits, Even parity, 1 stop bit
 #define MODBUS_TX_PIN 17    // GPIO 17 for Modbus TX
 #define MODBUS_RX_PIN 16    // GPIO 16 for Modbus RX
 #define TXEN_PIN -1         // Not used in RS-232 or USB-Serial
 
-// Maximum number of registers supported
-const int numRegisters = 4;
+// Slave address
+// The address is the configurable base plus the jumper ID (calculateDeviceID()),
+// so a segment of identically flashed modules needs no per-unit setup. An
+// explicit address stored in NVS overrides this. Both live in NVS namespace "modbus".
+#define MODBUS_ADDRESS_BASE_DEFAULT 1
+#define MODBUS_ADDRESS_MAX 247
 
-// Data type enumeration
-enum DataType {
-    TYPE_U64,
-    TYPE_FLOAT,
-    TYPE_INT16
-}; // Construct our data type, as I checked the excel only found these 3
+// Modbus task
+// The slave runs in its own task, woken by UART RX events, so inter-frame
+// timing and turnaround do not depend on the comms task or the debug port.
+#define MODBUS_TASK_CORE 0
+#define MODBUS_TASK_PRIORITY 3      // Above the comms task (2)
+#define MODBUS_TASK_STACK 4096
+#define MODBUS_IDLE_POLL_MS 10      // Wake-up interval without RX events
+#define MODBUS_RX_TIMEOUT_SYMBOLS 2 // UART RX event after 2 silent characters
+#define MODBUS_RX_TIMEOUT_US (MODBUS_RX_TIMEOUT_SYMBOLS * 11 * 1000000UL / BAUDRATE)
+#define MODBUS_TURNAROUND_BUDGET_US 5000
+#define MODBUS_CONTROL_QUEUE_SIZE 16 // Output changes waiting for the comms task
 
-// Global variables
-extern uint16_t regAddresses[numRegisters];  // Register addresses
-extern char regTypes[numRegisters];          // Data types
-extern uint64_t u64Values[numRegisters];     // U64 data
-extern float floatValues[numRegisters];      // Float data
-extern int16_t int16Values[numRegisters];    // Int16 data
-extern bool dataReady[numRegisters];         // Data ready status
+// Live control register map
+// Holding registers (read/write, FC03/FC06/FC16), applied as soon as written:
+//   0xF000 + 2*(n-1)   Channel n mode: 0 = voltage, 1 = current       (n = 1-3)
+//   0xF001 + 2*(n-1)   Channel n setpoint: centivolts or centi-mA
+//   0xF006             Relay bitmap: bit r-1 = relay r (1-6)
+//   0xF010             Waveform mode: 0 = voltage, 1 = current, 2 = digital
+//   0xF011             Waveform signal (1-3)
+//   0xF012             Waveform center (centi-units)
+//   0xF013             Waveform amplitude (centi-units)
+//   0xF014             Waveform period (0.1 s, 10-600)
+//   0xF015             Waveform control: write 1 = start with 0xF010-0xF014, 0 = stop
+//                      (last in the block so one FC16 write sets parameters then starts)
+//   0xF020             Address base: slave address = base + jumper ID. Written as a
+//                      broadcast (address 0) it re-addresses the whole segment at once
+//   0xF021             Address override: 1-247, or 0 = use base + jumper ID
+//                      (address changes take effect after the response and are saved)
+// Input registers (read-only, FC04), evaluated at read time:
+//   0xF000 + 2*(n-1)   Channel n mode: 0 = voltage, 1 = current
+//   0xF001 + 2*(n-1)   Channel n output value (centi-units)
+//   0xF006             Relay bitmap
+//   0xF007             Waveform active (0/1)
+//   0xF008             RS-485 device ID
+//   0xF009-0xF00A      Uptime in seconds (high word, low word)
+//   0xF00B             Current slave address
+//   0xF040-0xF067      Traffic diagnostics (see modbus_diagnostics.h)
+#define MB_CTRL_BASE 0xF000
+#define MB_CTRL_CHANNEL_MODE(n) (MB_CTRL_BASE + 2 * ((n) - 1))
+#define MB_CTRL_CHANNEL_SETPOINT(n) (MB_CTRL_BASE + 2 * ((n) - 1) + 1)
+#define MB_CTRL_RELAYS (MB_CTRL_BASE + 0x06)
+#define MB_CTRL_WAVE_MODE (MB_CTRL_BASE + 0x10)
+#define MB_CTRL_WAVE_SIGNAL (MB_CTRL_BASE + 0x11)
+#define MB_CTRL_WAVE_CENTER (MB_CTRL_BASE + 0x12)
+#define MB_CTRL_WAVE_AMPLITUDE (MB_CTRL_BASE + 0x13)
+#define MB_CTRL_WAVE_PERIOD (MB_CTRL_BASE + 0x14)
+#define MB_CTRL_WAVE_CONTROL (MB_CTRL_BASE + 0x15)
+#define MB_STATUS_WAVE_ACTIVE (MB_CTRL_BASE + 0x07)
+#define MB_STATUS_DEVICE_ID (MB_CTRL_BASE + 0x08)
+#define MB_STATUS_UPTIME (MB_CTRL_BASE + 0x09)
+#define MB_STATUS_SLAVE_ADDRESS (MB_CTRL_BASE + 0x0B)
+#define MB_CTRL_ADDRESS_BASE (MB_CTRL_BASE + 0x20)
+#define MB_CTRL_ADDRESS_OVERRIDE (MB_CTRL_BASE + 0x21)
+#define MB_STATUS_IREG_COUNT 12
 
 // Modbus instance
+// Access from outside the Modbus task must hold lockModbus()
 extern ModbusRTU mb;
 
-// Configuration status
-extern bool configDone;
+// Turnaround statistics (end of request frame to response)
+struct ModbusTimingStats {
+    uint32_t requests;     // Requests answered
+    uint64_t totalUs;      // Sum of turnaround times
+    uint32_t maxUs;        // Worst turnaround
+    uint32_t lastUs;       // Most recent turnaround
+    uint32_t overBudget;   // Requests over MODBUS_TURNAROUND_BUDGET_US
+};
 
 // Utility functions
 uint16_t lowWord(uint32_t dword);
@@ -42,12 +92,45 @@ uint16_t highWord(uint32_t dword);
 // Initialize Modbus
 void initModbus();
 
-// Process input command
-void processInput(String input);
+// Slave address
+uint8_t getModbusSlaveAddress();
+bool setModbusAddressBase(uint8_t base);          // Saved to NVS, applied immediately
+bool setModbusAddressOverride(uint8_t address);   // 0 = back to base + jumper ID
 
-// Process different data types (commented out as per original code)
-// void processU64(uint16_t regn, uint64_t data);
-// void processFloat(uint16_t regn, float data);
-// void processInt16(uint16_t regn, int16_t data);
+// Register the live control/status map and its callbacks
+void initModbusControlMap();
+
+// Apply output changes written by the master (comms task "modbus_ctl" job)
+void applyModbusControlActions();
+
+// Recursive lock around the Modbus register storage
+void lockModbus();
+void unlockModbus();
+
+// Turnaround statistics
+const ModbusTimingStats* getModbusTimingStats();
+void resetModbusTimingStats();
+void recordModbusRequestServed();                 // Also for requests answered from the raw hook
+
+// Process input command (register bank configuration)
+//   <addr>,<type>,<value>          Define or update one register
+//                                  (<type> may carry a word order: F/CDAB, I/DCBA, ...)
+//   <reg>,<addr>,<type>,<value>    Same, legacy form (<reg> is ignored)
+//   load <addr>:<type>:<value>;... Replace the bank with a whole device profile
+//                                  (end a line with '\' to continue the profile
+//                                  on the next load line)
+//   del <addr>                     Remove one register
+//   clear                          Remove all registers (and a partly sent load)
+//   list                           Print the bank
+//   profile save|load|delete <n>   Manage profiles stored in flash
+//   profile default [<n>]          Select (or clear) the profile loaded at boot
+//   profile list                   Print stored profiles
+//   gen <addr> <kind> [params]     Attach a time-varying generator (see modbus_generator.h)
+//   timing [reset]                 Print (and reset) turnaround statistics
+//   diag [reset]                   Print (and reset) traffic diagnostics
+//   address                        Print the slave address and how it was derived
+//   address base <n>               Set the address base (address = base + jumper ID)
+//   address set <n> | auto         Set or clear a fixed address
+void processInput(char* input);
 
 #endif // MODBUS_HANDLER_H
@@ -0,0 +1,62 @@
+#ifndef MODBUS_PROFILE_H
+#define MODBUS_PROFILE_H
+
+#include <Arduino.h>
+
+// Modbus Device Profiles
+// Named register bank images stored on LittleFS as /profiles/<name>.bin so a
+// simulated slave is restored at boot without replaying USB commands.
+// The name of the profile to load at boot is kept in NVS.
+//
+// File format (little endian):
+//   [magic "MBP2"][count u16]
+//   count x [address u16][type u8][order u8 (MB_ORDER_*)]
+//           [value: 2 bytes 'S', 4 bytes 'F' or 'U', 8 bytes 'I']
+//   [crc16 u16] (CRC-16/MODBUS over everything before it)
+//
+// Version 1 files ("MBP1") are still loaded. Their records have no order
+// byte (ABCD is used) and no 'U' type; their 'I' records, 8 bytes in the
+// file but served as 2 registers, load as 'U' so the layout is unchanged.
+// Profiles are always saved as version 2.
+
+#define MB_PROFILE_NAME_MAX 15    // Longest profile name
+
+/**
+ * Mount the profile filesystem and load the default profile, if any
+ */
+void initModbusProfiles();
+
+/**
+ * Save the current register bank as a named profile
+ * @param name Profile name (letters, digits, '_' and '-')
+ * @return true on success
+ */
+bool saveModbusProfile(const char* name);
+
+/**
+ * Replace the register bank with a named profile
+ * @param name Profile name
+ * @return true on success
+ */
+bool loadModbusProfile(const char* name);
+
+/**
+ * Delete a named profile
+ * @param name Profile name
+ * @return true if the profile existed
+ */
+bool deleteModbusProfile(const char* name);
+
+/**
+ * Print stored profiles to the USB serial port
+ */
+void listModbusProfiles();
+
+/**
+ * Select the profile loaded at boot
+ * @param name Profile name, or an empty string for none
+ * @return false if the name is invalid
+ */
+bool setDefaultModbusProfile(const char* name);
+
+#endif // MODBUS_PROFILE_H
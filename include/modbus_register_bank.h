@@ -0,0 +1,180 @@
+#ifndef MODBUS_REGISTER_BANK_H
+#define MODBUS_REGISTER_BANK_H
+
+#include <Arduino.h>
+#include <ModbusRTU.h>
+
+// Modbus Register Bank
+// Typed holding-register image for simulating field devices. Entries live in
+// one preallocated array kept sorted by address, so lookup is a binary search
+// and every entry can be defined or updated on its own.
+// Types: 'I' = U64 (4 words), 'U' = U32 (2 words), 'F' = Float (2 words), 'S' = Int16 (1 word)
+//
+// Values are double buffered: producers write the entry (back buffer) and
+// mark it dirty, and the Modbus task copies dirty entries into the published
+// value (front buffer) between master transactions, so a master never reads
+// half of an old value and half of a new one.
+//
+// Bank addresses are not registered with the library, whose register list is
+// searched linearly on every access. FC03, FC06, FC16 and FC22 requests below
+// MB_CTRL_BASE are answered from the bank by the raw-frame hook instead.
+
+#define MB_BANK_CAPACITY 1024      // Maximum number of typed entries
+
+// Word/byte order on the wire, named after a 32-bit value ABCD (A = MSB)
+enum ModbusWordOrder : uint8_t {
+    MB_ORDER_ABCD = 0,  // Big-endian words, big-endian bytes (Modbus default)
+    MB_ORDER_CDAB = 1,  // Little-endian words, big-endian bytes
+    MB_ORDER_BADC = 2,  // Big-endian words, swapped bytes
+    MB_ORDER_DCBA = 3   // Little-endian words, swapped bytes
+};
+
+// Register bank entry
+struct ModbusRegisterEntry {
+    uint16_t address;  // First holding register
+    char type;         // 'I', 'U', 'F' or 'S'
+    uint8_t words;     // Holding registers occupied
+    uint8_t order;     // ModbusWordOrder
+    volatile bool dirty; // Value changed since last published
+    uint64_t raw;      // Value bits (float bits for 'F', sign-extended for 'S')
+    uint64_t front;    // Value bits published to the master
+};
+
+/**
+ * Initialize register bank (empty)
+ */
+void initRegisterBank();
+
+/**
+ * Get number of holding registers used by a type
+ * @param type 'I', 'U', 'F' or 'S'
+ * @return Word count, 0 for unknown types
+ */
+uint8_t registerTypeWords(char type);
+
+/**
+ * Parse a word order name
+ * @param text "ABCD", "CDAB", "BADC" or "DCBA" (case-insensitive)
+ * @param order Parsed order
+ * @return true if the name is valid
+ */
+bool parseWordOrder(const char* text, uint8_t* order);
+
+/**
+ * Get the name of a word order
+ * @param order ModbusWordOrder
+ * @return "ABCD", "CDAB", "BADC" or "DCBA"
+ */
+const char* wordOrderName(uint8_t order);
+
+/**
+ * Define a register or update an existing one
+ * A new address must not overlap an existing entry; an existing address may
+ * only be updated with the same type. Call with the Modbus lock held.
+ * @param address First holding register address
+ * @param type 'I', 'U', 'F' or 'S'
+ * @param raw Value bits
+ * @param order Word/byte order (ModbusWordOrder)
+ * @return true on success
+ */
+bool defineRegister(uint16_t address, char type, uint64_t raw, uint8_t order = MB_ORDER_ABCD);
+
+/**
+ * Parse a text value for a register type
+ * @param type 'I', 'U', 'F' or 'S'
+ * @param text Value text
+ * @param raw Parsed value bits
+ * @return true if the type is valid and the text is a number of that type
+ */
+bool parseRegisterValue(char type, const char* text, uint64_t* raw);
+
+/**
+ * Find the entry at an address
+ * @param address First holding register address
+ * @return Entry, or nullptr if no entry starts at that address
+ */
+ModbusRegisterEntry* findRegister(uint16_t address);
+
+/**
+ * Remove the entry at an address
+ * @param address First holding register address
+ * @return true if an entry was removed
+ */
+bool removeRegister(uint16_t address);
+
+/**
+ * Remove every entry
+ */
+void clearRegisterBank();
+
+/**
+ * Get number of entries
+ * @return Entry count
+ */
+uint16_t getRegisterCount();
+
+/**
+ * Get entry by position (ascending address order)
+ * @param index Position (0 to getRegisterCount()-1)
+ * @return Entry, or nullptr if out of range
+ */
+ModbusRegisterEntry* getRegisterEntry(uint16_t index);
+
+/**
+ * Copy an entry by position with a consistent value
+ * Safe against concurrent value updates from the Modbus task; the bank's
+ * layout only changes on the console task, which is the caller.
+ * @param index Position (0 to getRegisterCount()-1)
+ * @param out Receives the entry
+ * @return false if out of range
+ */
+bool copyRegisterEntry(uint16_t index, ModbusRegisterEntry* out);
+
+/**
+ * Decode an entry's value as a number
+ * @param entry Entry to read
+ * @return Value
+ */
+double getRegisterNumber(const ModbusRegisterEntry* entry);
+
+/**
+ * Set an entry's value from a number, saturating to the type's range
+ * The value reaches the master at the next snapshot swap; no lock is needed.
+ * @param entry Entry to update
+ * @param value New value
+ */
+void setRegisterNumber(ModbusRegisterEntry* entry, double value);
+
+/**
+ * Set an entry's value bits
+ * The value reaches the master at the next snapshot swap; no lock is needed.
+ * @param entry Entry to update
+ * @param raw New value bits
+ */
+void setRegisterRaw(ModbusRegisterEntry* entry, uint64_t raw);
+
+/**
+ * Encode an entry's value into holding register words in its word order
+ * @param entry Entry to encode
+ * @param words Output, entry->words values
+ */
+void encodeRegisterWords(const ModbusRegisterEntry* entry, uint16_t* words);
+
+/**
+ * Publish changed entries to the master
+ * Called by the Modbus task between transactions with the Modbus lock held.
+ * @return Number of entries published
+ */
+uint16_t commitRegisterBank();
+
+/**
+ * Answer a holding register request from the bank (Modbus task, raw hook)
+ * @param pdu Request PDU, function code first
+ * @param length PDU length
+ * @param broadcast Request sent to address 0 (applied, not answered)
+ * @return EX_PASSTHROUGH if the request is not for the bank, EX_SUCCESS if it
+ *         was answered, otherwise the exception code to send
+ */
+Modbus::ResultCode serveRegisterBankRequest(uint8_t* pdu, uint8_t length, bool broadcast);
+
+#endif // MODBUS_REGISTER_BANK_H
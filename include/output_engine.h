@@ -0,0 +1,102 @@
+#ifndef OUTPUT_ENGINE_H
+#define OUTPUT_ENGINE_H
+
+#include <Arduino.h>
+
+// Output Engine
+// The waveform generator, setpoint stream and all DAC/relay output changes
+// run in one task pinned to core 1, woken by a hardware timer. USB, RS-485
+// and Modbus handling run on core 0, so bursts of serial traffic do not
+// delay waveform ticks.
+//
+// Cross-core rules:
+//   - Output functions (setSignalMode/Value, setVoltage/CurrentOutput,
+//     start/stopSineWave, pushStreamSetpoints, configureSetpointStream)
+//     called from core 0 are posted to the engine through a lock-free ring
+//     and executed on its next tick. The engine side never blocks.
+//   - State the engine publishes (signal values and modes, waveform active)
+//     is read by other tasks as single aligned words.
+
+#define OUTPUT_ENGINE_CORE 1
+#define OUTPUT_ENGINE_PRIORITY 10        // Above the comms (2) and Modbus (3) tasks
+#define OUTPUT_ENGINE_STACK 4096
+#define OUTPUT_ENGINE_TIMER 0            // Hardware timer number
+#define OUTPUT_ENGINE_PERIOD_US 1000     // Tick period (1 kHz)
+#define OUTPUT_COMMAND_RING_SIZE 32      // Posted commands (power of two)
+#define OUTPUT_JITTER_BUCKETS 6          // Latency histogram: <10, <25, <50, <100, <250, >=250 us
+
+// Posted output operations
+enum OutputCommandType : uint8_t {
+    OUT_CMD_SIGNAL_MODE,
+    OUT_CMD_SIGNAL_VALUE,
+    OUT_CMD_VOLTAGE,
+    OUT_CMD_CURRENT,
+    OUT_CMD_RELAY,
+    OUT_CMD_SINE_START,
+    OUT_CMD_SINE_STOP,
+    OUT_CMD_STREAM_PACKET,
+    OUT_CMD_STREAM_CONFIG
+};
+
+struct OutputCommand {
+    OutputCommandType type;
+    union {
+        struct { uint8_t sig; char mode; } signalMode;
+        struct { uint8_t sig; float value; } signalValue;
+        float level;  // OUT_CMD_VOLTAGE / OUT_CMD_CURRENT
+        struct { uint8_t number; bool state; } relay;
+        struct { float amplitude; float period; float center; uint8_t signal; char mode; } sine;
+        struct { uint16_t sequence; uint8_t channelMask; uint16_t values[3]; } stream;
+        struct { uint32_t periodUs; uint8_t prefill; } streamConfig;
+    };
+};
+
+// Tick timing statistics
+struct OutputEngineStats {
+    uint32_t ticks;          // Ticks executed
+    uint32_t missedTicks;    // Timer periods that passed without a tick
+    uint32_t maxLatencyUs;   // Worst timer interrupt to tick start delay
+    uint64_t totalLatencyUs; // Sum of tick start delays
+    uint32_t maxJitterUs;    // Worst deviation of the tick interval from the period
+    uint32_t maxRunUs;       // Worst tick execution time
+    uint32_t commands;       // Posted commands executed
+    uint32_t commandOverflow; // Commands rejected because the ring was full
+    uint32_t latencyHistogram[OUTPUT_JITTER_BUCKETS];
+};
+
+/**
+ * Start the output engine task and its timer
+ * Call at the end of setup(); output functions run directly until then.
+ */
+void initOutputEngine();
+
+/**
+ * Check whether output functions may touch the hardware directly
+ * @return true before the engine starts, or when called from the engine task
+ */
+bool isOutputEngineContext();
+
+/**
+ * Post an output operation to the engine (any task on core 0)
+ * @param command Operation to run on the next tick
+ * @return true if queued
+ */
+bool postOutputCommand(const OutputCommand& command);
+
+/**
+ * Get tick timing statistics
+ * @return Statistics (updated by the engine task)
+ */
+const OutputEngineStats* getOutputEngineStats();
+
+/**
+ * Clear tick timing statistics
+ */
+void resetOutputEngineStats();
+
+/**
+ * Print tick timing statistics to the USB serial port
+ */
+void printOutputEngineStats();
+
+#endif // OUTPUT_ENGINE_H
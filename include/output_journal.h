@@ -0,0 +1,64 @@
+#ifndef OUTPUT_JOURNAL_H
+#define OUTPUT_JOURNAL_H
+
+#include <Arduino.h>
+
+// Output State Journal
+// Keeps the last settled output configuration (signal modes and setpoints,
+// relays, running sine wave) in NVS so setup() can put it back on the
+// outputs within milliseconds of a reset, before the comms stack starts.
+//
+// Records rotate over JOURNAL_SLOTS keys with a sequence number and CRC;
+// the newest valid one wins at boot, so a write torn by a brownout falls
+// back to the previous state. NVS already levels wear across its pages;
+// rotating keys keeps an intact copy while a new one is written, and the
+// settle/minimum-interval rules below bound the write rate when a host
+// changes setpoints continuously. Setpoint stream and waveform samples are
+// not journaled, only the configuration they run from: while either drives
+// the outputs, the setpoints journaled before it are kept.
+
+#define JOURNAL_NAMESPACE "journal"
+#define JOURNAL_SLOTS 4
+#define JOURNAL_CHECK_INTERVAL_MS 500   // Comms job period
+#define JOURNAL_SETTLE_MS 1000          // State must be unchanged this long
+#define JOURNAL_MIN_INTERVAL_MS 10000   // Between two writes
+#define JOURNAL_RESTORE_WAVEFORM 1      // Restart a sine wave that was running
+
+// Journaled output state
+struct OutputSnapshot {
+    char modes[3];            // 'v' or 'c' per signal
+    uint8_t relays;           // Bit n = relay n + 1
+    float values[3];          // Setpoint per signal (V or mA)
+    uint8_t waveActive;
+    char waveMode;            // 'v', 'c' or 'd'
+    uint8_t reserved[2];
+    float waveAmplitude;
+    float wavePeriod;         // Seconds
+    float waveCenter;
+};
+
+/**
+ * Restore the newest valid journal record onto the outputs
+ * Call from setup() after the DAC and relay init, before the output engine
+ * starts. Without a record all signals are put in voltage mode.
+ * @return true if a record was restored
+ */
+bool restoreOutputJournal();
+
+/**
+ * Register the journal job (comms task, after initScheduler())
+ */
+void initOutputJournal();
+
+/**
+ * Erase all journal records
+ * The next boot uses defaults unless the outputs change again before it.
+ */
+void clearOutputJournal();
+
+/**
+ * Print journal state to the USB serial port
+ */
+void printOutputJournal();
+
+#endif // OUTPUT_JOURNAL_H
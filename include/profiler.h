@@ -0,0 +1,92 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+
+// Stage Profiler
+// Scoped zones timed with the CPU cycle counter. Each zone keeps call count,
+// min/max/total and a fixed log-linear histogram (four buckets per octave,
+// so percentiles are within 19%) from which p99 is read. A zone must only
+// be entered from one task, since the cycle counter is per core and the
+// statistics are not locked; readers may see a sample half applied.
+// Build with -DPROFILER=0 to remove the zones.
+
+#ifndef PROFILER
+#define PROFILER 1
+#endif
+
+// Zones
+enum ProfileZone : uint8_t {
+    PROFILE_USB = 0,          // USB command parsing (comms task)
+    PROFILE_RS485,            // RS-485 receive and command execution (comms task)
+    PROFILE_MODBUS_CTL,       // Modbus control actions (comms task)
+    PROFILE_GENERATORS,       // Modbus register generators (comms task)
+    PROFILE_TELEMETRY,        // Telemetry frames to the USB subscriber (comms task)
+    PROFILE_MODBUS_POLL,      // mb.task() (Modbus task)
+    PROFILE_STREAM,           // Setpoint stream playback (output engine)
+    PROFILE_WAVE,             // updateSineWave() (output engine)
+    PROFILE_ZONE_COUNT
+};
+
+#define PROFILE_SUB_BUCKETS 4
+#define PROFILE_HIST_BUCKETS 124  // Covers the full 32-bit cycle range
+
+// Zone summary, all times in CPU cycles
+struct ProfileSummary {
+    uint32_t count;
+    uint32_t minCycles;
+    uint32_t avgCycles;
+    uint32_t maxCycles;
+    uint32_t p99Cycles;       // Upper bound of the bucket holding the 99th percentile
+};
+
+/**
+ * Add one sample to a zone
+ * @param zone Zone ID
+ * @param cycles Elapsed CPU cycles
+ */
+void profileRecord(uint8_t zone, uint32_t cycles);
+
+// Times the enclosing scope into a zone
+class ProfileScope {
+public:
+    explicit ProfileScope(uint8_t zone) : _zone(zone), _start(ESP.getCycleCount()) {}
+    ~ProfileScope() { profileRecord(_zone, ESP.getCycleCount() - _start); }
+
+private:
+    uint8_t _zone;
+    uint32_t _start;
+};
+
+#if PROFILER
+#define PROFILE_ZONE(zone) ProfileScope profileScope_##zone(zone)
+#else
+#define PROFILE_ZONE(zone) do {} while (0)
+#endif
+
+/**
+ * Get a zone name
+ * @param zone Zone ID
+ * @return Name, or nullptr for an unknown zone
+ */
+const char* getProfileZoneName(uint8_t zone);
+
+/**
+ * Summarize a zone
+ * @param zone Zone ID
+ * @param summary Receives the summary
+ * @return false for an unknown zone
+ */
+bool getProfileSummary(uint8_t zone, ProfileSummary* summary);
+
+/**
+ * Clear all zones
+ */
+void resetProfiler();
+
+/**
+ * Print all zones (microseconds) to the USB serial port
+ */
+void printProfiler();
+
+#endif // PROFILER_H
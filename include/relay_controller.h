@@ -25,6 +25,7 @@ void setRelayMode(uint8_t channel, char mode);
 
 /**
  * Set relay state
+ * Called from another task, the change is posted to the output engine.
  * @param relayNumber Relay number (1-6)
  * @param state true for ON, false for OFF
  */
@@ -2,16 +2,28 @@
 #define RS485_COMMAND_HANDLER_H
 
 #include "rs485_serial.h"
+#include "command_registry.h"
 
 // Command types
 #define CMD_PING 0x01
 #define CMD_GET_DEVICE_ID 0x02
+#define CMD_SET_GROUPS 0x03
+#define CMD_GET_GROUPS 0x04
 #define CMD_SET_VOLTAGE 0x10
 #define CMD_SET_CURRENT 0x11
 #define CMD_SET_RELAY 0x20
 #define CMD_GET_STATUS 0x30
+#define CMD_GET_STATS 0x31
+#define CMD_GET_TRACE 0x32
+#define CMD_GET_PROFILE 0x33
+#define CMD_GET_TELEMETRY 0x34
 #define CMD_SINE_WAVE 0x40
 #define CMD_STOP_SINE 0x41
+#define CMD_STREAM_SETPOINTS 0x50
+#define CMD_STREAM_STATS 0x51
+#define CMD_STREAM_CONFIG 0x52
+#define CMD_SUBSCRIBE 0x60
+#define CMD_POLL_CHANGES 0x61
 
 // Response codes
 #define RESP_SUCCESS 0x01
@@ -19,6 +31,16 @@
 #define RESP_INVALID_COMMAND 0x02
 #define RESP_INVALID_PARAMETER 0x03
 
+// Statistics (CMD_GET_STATS)
+#define STATS_SELECT_LINK 0x00    // Selector for link counters; any other value is an opcode
+#define STATS_FLAG_RESET 0x01     // Reset all statistics after reporting
+#define RS485_LATENCY_BUCKETS 8   // <250, <500, <1000, <2000, <5000, <10000, <20000, >=20000 us
+
+// Event trace readout (CMD_GET_TRACE)
+#define TRACE_FLAG_FREEZE 0x01       // Stop recording before reading
+#define TRACE_FLAG_RESTART 0x02      // Clear and resume recording after reading
+#define TRACE_RECORDS_PER_REPLY 3
+
 /**
  * Initialize RS-485 command handler
  */
@@ -26,10 +48,25 @@ void initRS485CommandHandler();
 
 /**
  * Process RS-485 commands and execute corresponding actions
- * @return true if a command was processed
+ * Drains the command queue so pipelined frames are all executed in order.
+ * @return true if at least one command was processed
  */
 bool handleRS485Commands();
 
+/**
+ * Look up an RS-485 command descriptor
+ * @param opcode Command type byte
+ * @return Descriptor, or nullptr if the opcode is not registered
+ */
+const CommandSpec* findRS485Command(uint8_t opcode);
+
+/**
+ * Look up an RS-485 command descriptor by name
+ * @param name Command name (case-insensitive)
+ * @return Descriptor, or nullptr if no command has that name
+ */
+const CommandSpec* findRS485CommandByName(const char* name);
+
 /**
  * Execute a specific command
  * @param command Pointer to the command structure
@@ -53,6 +90,24 @@ bool handlePingCommand(const uint8_t* data, uint8_t length);
  */
 bool handleGetDeviceIDCommand(const uint8_t* data, uint8_t length);
 
+/**
+ * Handle set groups command
+ * Data: [mask_high][mask_low], stored in NVS
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleSetGroupsCommand(const uint8_t* data, uint8_t length);
+
+/**
+ * Handle get groups command
+ * Response: [mask_high][mask_low]
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleGetGroupsCommand(const uint8_t* data, uint8_t length);
+
 /**
  * Handle set voltage command
  * @param data Command data
@@ -85,6 +140,51 @@ bool handleSetRelayCommand(const uint8_t* data, uint8_t length);
  */
 bool handleGetStatusCommand(const uint8_t* data, uint8_t length);
 
+/**
+ * Handle get stats command
+ * Data: [] or [selector] or [selector][flags]
+ * Response for selector 0x00 (link):
+ *   [0x00][bytes][frames][rejected][not_for_me][overflow][dropped] (uint32 big endian)
+ * Response for selector = opcode (latency from end of frame to start of reply):
+ *   [opcode][count u32][max_us u32][bucket0..7 u16] (big endian, buckets saturate)
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleGetStatsCommand(const uint8_t* data, uint8_t length);
+
+/**
+ * Handle get trace command
+ * Data: [from_high][from_low] or [from_high][from_low][flags]
+ * Response: [head_high][head_low][first_high][first_low][count]
+ *           then count records of [t_us u32][event][arg8][arg16 u16] (big endian)
+ * Sequence numbers are the low 16 bits; read until first + count == head.
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleGetTraceCommand(const uint8_t* data, uint8_t length);
+
+/**
+ * Handle get profile command
+ * Data: [zone] or [zone][flags]; flags as for CMD_GET_STATS (STATS_FLAG_RESET
+ * clears all zones after reporting). Zone IDs are ProfileZone values.
+ * Response: [zone][cpu_mhz u16][count][min][avg][max][p99] (uint32 big endian, cycles)
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleGetProfileCommand(const uint8_t* data, uint8_t length);
+
+/**
+ * Handle get telemetry command
+ * Response: packed telemetry frame (see telemetry.h)
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleGetTelemetryCommand(const uint8_t* data, uint8_t length);
+
 /**
  * Handle sine wave command
  * @param data Command data
@@ -101,4 +201,51 @@ bool handleSineWaveCommand(const uint8_t* data, uint8_t length);
  */
 bool handleStopSineCommand(const uint8_t* data, uint8_t length);
 
+/**
+ * Handle stream setpoints command (never acknowledged)
+ * Data: [seq_high][seq_low][channel_mask][value_high][value_low]...
+ * One value per set mask bit, in channel order, in centi-units
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleStreamSetpointsCommand(const uint8_t* data, uint8_t length);
+
+/**
+ * Handle stream stats command
+ * Data: [] or [reset]; reset=1 clears the counters after reporting
+ * Response: received, applied, lost, late, overflow, underrun (uint32 big endian each)
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleStreamStatsCommand(const uint8_t* data, uint8_t length);
+
+/**
+ * Handle stream config command
+ * Data: [period_us_high][period_us_low][prefill]
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleStreamConfigCommand(const uint8_t* data, uint8_t length);
+
+/**
+ * Handle subscribe command
+ * Data: [mask] or [mask][heartbeat_s]; mask of CHANGE_* bits, 0 unsubscribes
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleSubscribeCommand(const uint8_t* data, uint8_t length);
+
+/**
+ * Handle poll changes command (usually broadcast, never acknowledged)
+ * Response, only when a change or heartbeat is due: packed notification (see change_notify.h)
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handlePollChangesCommand(const uint8_t* data, uint8_t length);
+
 #endif // RS485_COMMAND_HANDLER_H 
\ No newline at end of file
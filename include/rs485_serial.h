@@ -14,6 +14,46 @@
 // Buffer sizes
 #define RS485_BUFFER_SIZE 64      // Receive buffer size
 #define RS485_MAX_COMMAND_LENGTH 32
+#define RS485_COMMAND_QUEUE_SIZE 8 // Parsed commands held between read bursts
+#define RS485_SLOTTED_REPLIES 4   // Multicast replies held back until their slot
+
+// Line timing: 8E1 is 11 bits per character (573 us at 19200 baud)
+#define RS485_CHAR_US ((11UL * 1000000UL + RS485_BAUDRATE - 1) / RS485_BAUDRATE)
+#define RS485_RX_TIMEOUT_SYMBOLS 1 // Idle characters before the UART raises an RX event
+
+// Addressing - DEVICE_ID byte of a frame
+// 0x00-0x1F: single device (jumper ID)
+// 0xE0-0xEF: group 0-15, accepted when the group bit is set in the group mask
+// 0xFF:      broadcast to all devices
+#define RS485_BROADCAST_ID 0xFF
+#define RS485_GROUP_BASE 0xE0
+#define RS485_GROUP_COUNT 16
+
+// COMMAND byte bit 7 suppresses every reply to that frame (opcode is bits 0-6)
+#define RS485_NO_REPLY_FLAG 0x80
+
+// Frames are not escaped, so binary reply payloads (telemetry, change
+// notifications) are packed 6 bits per byte, each byte 0xC0 | bits, and can
+// never contain the 0xAA/0x55 delimiters. The bits are taken high first;
+// n bytes take RS485_PACKED_SIZE(n) bytes on the wire, the last one padded
+// with zero bits.
+#define RS485_PACKED_MARK 0xC0
+#define RS485_PACKED_SIZE(n) (((n) * 4 + 2) / 3)
+
+// Longest reply payload: a packed telemetry frame
+#define RS485_MAX_REPLY_DATA 40
+
+// Replies to broadcast/group frames are sent in slots ordered by device ID,
+// starting at the end of the request frame. A slot holds the longest reply
+// any command can give (a data frame with a full payload plus its ACK frame)
+// and a turnaround margin: 30.1 ms at 19200 baud, ~960 ms for a 32-node sweep.
+#define RS485_MAX_REPLY_BYTES (RS485_MAX_REPLY_DATA + 4 + 5)
+#define RS485_REPLY_TURNAROUND_US 2000
+#define RS485_REPLY_SLOT_US (RS485_MAX_REPLY_BYTES * RS485_CHAR_US + RS485_REPLY_TURNAROUND_US)
+
+// RS485Command.flags
+#define RS485_FLAG_MULTICAST 0x01 // Addressed to a group or broadcast
+#define RS485_FLAG_NO_REPLY 0x02  // Sender asked for no reply
 
 // Command structure
 struct RS485Command {
@@ -21,20 +61,67 @@ struct RS485Command {
     uint8_t commandType;          // Command type
     uint8_t data[RS485_MAX_COMMAND_LENGTH - 2]; // Command data
     uint8_t length;               // Total command length
+    uint8_t flags;                // RS485_FLAG_* addressing/reply flags
+    uint32_t timestamp;           // micros() at the end of the frame on the line
+    uint32_t replyTimestamp;      // micros() when the first reply started (0 = none yet)
     bool valid;                   // Command validity flag
 };
 
+// Link statistics
+struct RS485LinkStats {
+    uint32_t bytesReceived;       // Raw bytes read from the bus
+    uint32_t framesReceived;      // Complete frames (start..end byte)
+    uint32_t rejected;            // Framing errors: start byte mid-frame, runs of bytes outside a frame
+    uint32_t notForMe;            // Frames addressed to another device/group
+    uint32_t overflow;            // Frames too long for the buffer or a command slot
+    uint32_t dropped;             // Commands lost because the queue was full
+};
+
 /**
  * Initialize RS-485 serial communication
  */
 void initRS485Serial();
 
+/**
+ * Call a function whenever the RS-485 UART receives data
+ * The callback runs in the UART event task, not in the comms task. The RX
+ * event is also when frame end times are taken, see RS485Command.timestamp.
+ * @param callback Function to call
+ */
+void onRS485Receive(void (*callback)());
+
 /**
  * Process incoming RS-485 commands from work mode interface
- * @return true if a valid command was received
+ * Every complete frame addressed to this device is queued in arrival order.
+ * @return true if at least one valid command was queued
  */
 bool processRS485Commands();
 
+/**
+ * Take the oldest queued command and make it the current command
+ * The current command is returned by getLastCommand() and is the one
+ * sendAckResponse()/sendDataResponse() reply to.
+ * @return true if a command was dequeued
+ */
+bool dequeueRS485Command();
+
+/**
+ * Get number of commands waiting in the queue
+ * @return Queued command count
+ */
+uint8_t getRS485QueuedCount();
+
+/**
+ * Get link statistics
+ * @return Pointer to the link counters
+ */
+const RS485LinkStats* getRS485LinkStats();
+
+/**
+ * Reset link statistics
+ */
+void resetRS485LinkStats();
+
 /**
  * Send response via RS-485 work mode interface
  * @param deviceID Target device ID
@@ -45,8 +132,8 @@ bool processRS485Commands();
 void sendRS485Response(uint8_t deviceID, uint8_t commandType, const uint8_t* data, uint8_t length);
 
 /**
- * Get the last received command
- * @return Pointer to the last received command
+ * Get the current command (the one most recently dequeued)
+ * @return Pointer to the current command
  */
 RS485Command* getLastCommand();
 
@@ -68,17 +155,63 @@ void setDeviceID(uint8_t id);
  */
 uint8_t getCurrentDeviceID();
 
+/**
+ * Set group membership mask (bit n = member of group address 0xE0 + n)
+ * @param mask Group membership bitmask
+ * @param persist true to store the mask in NVS
+ */
+void setRS485GroupMask(uint16_t mask, bool persist);
+
+/**
+ * Get group membership mask
+ * @return Group membership bitmask
+ */
+uint16_t getRS485GroupMask();
+
+/**
+ * Send slotted replies whose transmit slot has arrived
+ * Called from processRS485Commands(), so it runs on every RS-485 job release.
+ */
+void serviceRS485Transmit();
+
+/**
+ * Time until the next queued slotted reply is due
+ * @return Microseconds to wait (0 if due now), or UINT32_MAX if none is queued
+ */
+uint32_t getRS485TransmitWaitUs();
+
 /**
  * Send acknowledgment response via RS-485
+ * Replies to the current command: suppressed for no-reply frames and
+ * deferred to this device's slot for broadcast/group frames.
  * @param success true for success, false for error
  */
 void sendAckResponse(bool success);
 
 /**
  * Send data response via RS-485
+ * Follows the same reply rules as sendAckResponse().
  * @param data Data to send
  * @param length Data length
  */
 void sendDataResponse(const uint8_t* data, uint8_t length);
 
+/**
+ * Pack binary reply data so it cannot contain frame delimiters
+ * @param data Bytes to pack
+ * @param length Byte count
+ * @param out Output buffer of RS485_PACKED_SIZE(length) bytes
+ * @return Packed length
+ */
+uint8_t packRS485Payload(const uint8_t* data, uint8_t length, uint8_t* out);
+
+/**
+ * Unpack reply data packed by packRS485Payload() (host side)
+ * @param data Packed bytes
+ * @param length Packed byte count
+ * @param out Output buffer of length * 3 / 4 bytes
+ * @return Unpacked length, or 0 if a byte lacks RS485_PACKED_MARK
+ */
+uint8_t unpackRS485Payload(const uint8_t* data, uint8_t length, uint8_t* out);
+
 #endif // RS485_SERIAL_H 
\ No newline at end of file
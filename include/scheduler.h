@@ -0,0 +1,95 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+// Cooperative Deadline Scheduler
+// Runs the main loop's jobs from one task. Each job has a period, a relative
+// deadline and a priority; it is released periodically, when signalled by an
+// I/O event, or both. The highest priority released job runs first (earliest
+// deadline breaks ties) and the task blocks until the next release or event
+// instead of polling on a fixed delay.
+// A job that finishes after its deadline, or misses whole periods, is counted
+// as an overrun.
+
+#define SCHEDULER_MAX_JOBS 12
+#define SCHEDULER_EVENT_ONLY 0   // Period for jobs that only run when signalled
+
+// Job function
+typedef void (*SchedulerJobFn)();
+
+// Per-job statistics
+struct SchedulerJobStats {
+    const char* name;
+    uint32_t periodUs;      // 0 = event only
+    uint32_t deadlineUs;    // Relative to release
+    uint8_t priority;       // Higher runs first
+    uint32_t runs;          // Completed runs
+    uint32_t overruns;      // Runs finished after their deadline
+    uint32_t skipped;       // Periodic releases missed entirely
+    uint32_t maxLatencyUs;  // Worst release to start delay
+    uint32_t maxRunUs;      // Worst execution time
+    uint64_t totalRunUs;    // Sum of execution times
+};
+
+/**
+ * Initialize the scheduler for the calling task
+ * Event signals wake this task, so call it from the task that runs runScheduler().
+ */
+void initScheduler();
+
+/**
+ * Add a job
+ * @param name Job name (static string)
+ * @param fn Job function
+ * @param periodUs Release period, or SCHEDULER_EVENT_ONLY
+ * @param deadlineUs Deadline relative to release
+ * @param priority Higher value runs first
+ * @return Job ID, or -1 if the table is full
+ */
+int8_t addSchedulerJob(const char* name, SchedulerJobFn fn, uint32_t periodUs, uint32_t deadlineUs, uint8_t priority);
+
+/**
+ * Release a job now (safe from other tasks and UART event callbacks)
+ * @param id Job ID from addSchedulerJob()
+ */
+void signalSchedulerJob(int8_t id);
+
+/**
+ * Change a job's period (scheduler task only)
+ * The next periodic release is one new period from now.
+ * @param id Job ID from addSchedulerJob()
+ * @param periodUs Release period, or SCHEDULER_EVENT_ONLY
+ */
+void setSchedulerJobPeriod(int8_t id, uint32_t periodUs);
+
+/**
+ * Run the most urgent released job, or sleep until the next release or event
+ * (call this in main loop)
+ */
+void runScheduler();
+
+/**
+ * Get job statistics
+ * @param id Job ID
+ * @return Statistics, or nullptr for an invalid ID
+ */
+const SchedulerJobStats* getSchedulerJobStats(int8_t id);
+
+/**
+ * Get number of jobs
+ * @return Job count
+ */
+uint8_t getSchedulerJobCount();
+
+/**
+ * Clear all job statistics
+ */
+void resetSchedulerStats();
+
+/**
+ * Print job statistics to the USB serial port
+ */
+void printSchedulerStats();
+
+#endif // SCHEDULER_H
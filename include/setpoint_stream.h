@@ -0,0 +1,87 @@
+#ifndef SETPOINT_STREAM_H
+#define SETPOINT_STREAM_H
+
+#include <Arduino.h>
+
+// Setpoint Streaming
+// High-rate periodic setpoints for hardware-in-the-loop use. The host sends
+// sequence-numbered packets without waiting for acks; packets are reordered
+// in a small jitter buffer and applied on a local timer.
+// Values use the channel's current mode (signalModes): centivolts or centi-mA.
+//
+// RS-485 frames are not escaped, so a 0x55 or 0xAA data byte would end or
+// restart the frame. The sequence and values are therefore 12-bit fields sent
+// as two 6-bit groups, high first, each byte 0xC0 | bits (0xC0-0xFF).
+// The channel mask byte is sent as 0xC0 | mask the same way.
+
+#define STREAM_BUFFER_SIZE 8            // Jitter buffer depth (packets)
+#define STREAM_DEFAULT_PERIOD_US 5000   // Apply period (200 Hz)
+#define STREAM_DEFAULT_PREFILL 2        // Packets buffered before playback starts
+#define STREAM_TIMEOUT_MS 500           // Idle time after which the stream re-primes
+#define STREAM_RESYNC_DISTANCE 64       // Sequence jump treated as a restarted sender
+#define STREAM_SEQUENCE_MASK 0x0FFF     // Sequence numbers are 12 bits
+#define STREAM_VALUE_MAX 0x0FFF         // Largest encodable value (40.95 units)
+#define STREAM_GROUP_MARK 0xC0          // Marker bits of every encoded payload byte
+
+// Stream counters, reported by CMD_STREAM_STATS
+struct StreamStats {
+    uint32_t received;   // Packets accepted into the jitter buffer
+    uint32_t applied;    // Packets applied to the outputs
+    uint32_t lost;       // Sequence numbers that never arrived
+    uint32_t late;       // Packets that arrived after their slot (or duplicates)
+    uint32_t overflow;   // Packets discarded because the buffer was full
+    uint32_t underrun;   // Ticks with no packet to apply (last value held)
+};
+
+/**
+ * Initialize setpoint stream
+ */
+void initSetpointStream();
+
+/**
+ * Queue a setpoint packet
+ * @param sequence Packet sequence number (wraps at STREAM_SEQUENCE_MASK)
+ * @param channelMask Bit n set = packet carries a value for channel n+1
+ * @param values Raw values (centi-units) for each set bit, in channel order
+ * @return true if the packet was buffered (or posted to the output engine)
+ */
+bool pushStreamSetpoints(uint16_t sequence, uint8_t channelMask, const uint16_t* values);
+
+/**
+ * Decode one 12-bit field sent as two 6-bit groups (0xC0 | bits, high first)
+ * @param bytes Two encoded bytes
+ * @param out Receives the value
+ * @return false if a byte lacks the 0xC0 marker
+ */
+bool decodeStreamField(const uint8_t* bytes, uint16_t* out);
+
+/**
+ * Apply buffered setpoints that are due (called by the output engine each tick)
+ */
+void updateSetpointStream();
+
+/**
+ * Check whether the stream is playing (prefill reached, not timed out)
+ * @return true while streamed setpoints drive the outputs
+ */
+bool isSetpointStreamActive();
+
+/**
+ * Configure playback timing
+ * @param periodUs Apply period in microseconds
+ * @param prefill Packets buffered before playback starts (1-STREAM_BUFFER_SIZE)
+ */
+void configureSetpointStream(uint32_t periodUs, uint8_t prefill);
+
+/**
+ * Get stream counters
+ * @return Pointer to the stream counters
+ */
+const StreamStats* getStreamStats();
+
+/**
+ * Reset stream counters
+ */
+void resetStreamStats();
+
+#endif // SETPOINT_STREAM_H
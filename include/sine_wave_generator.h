@@ -33,7 +33,7 @@ void startSineWave(float amplitude, float period, float center, uint8_t signal,
 void stopSineWave();
 
 /**
- * Update sine wave output (call this in main loop)
+ * Update sine wave output (called by the output engine each tick)
  */
 void updateSineWave();
 
@@ -48,11 +48,35 @@ void getSineWaveStatus();
  */
 bool isSineWaveActive();
 
+/**
+ * Get the mode of the current (or last) sine wave
+ * @return 'v', 'c' or 'd'
+ */
+char getSineWaveMode();
+
+/**
+ * Get the period of the current (or last) sine wave
+ * @return Period in seconds
+ */
+float getSineWavePeriod();
+
+/**
+ * Get the amplitude of the current (or last) sine wave
+ * @return Peak amplitude from center
+ */
+float getSineWaveAmplitude();
+
+/**
+ * Get the center of the current (or last) sine wave
+ * @return Center point
+ */
+float getSineWaveCenter();
+
 /**
  * Parse sine wave commands
  * Format: SINE START/STOP/STATUS [amplitude] [period] [signal] [mode]
  */
-void parseSineWaveCommand(String input);
+void parseSineWaveCommand(char* input);
 
 // Command examples:
 // SINE START 5.0 2.0 5.0 1 V    // Start 5V amplitude, 2s period, center 5V, signal 1, voltage mode (output: 0-10V)
@@ -0,0 +1,63 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+
+// Binary Telemetry Frame
+// One fixed 30 byte snapshot of the module state, replacing the periodic
+// text status report. It is returned by CMD_GET_TELEMETRY over RS-485, and
+// streamed to the USB port at a configurable rate when a host subscribes
+// ("telemetry rate <ms>"), framed like an RS-485 reply:
+//   [0xAA][device ID][CMD_GET_TELEMETRY][packed frame][0x55]
+// On both links the frame is packed 6 bits per byte (packRS485Payload(),
+// 40 bytes) so values such as 0x55 or 0xAA cannot end or restart the frame.
+//
+// Frame layout (multi-byte fields big endian):
+//   [0]      TELEMETRY_VERSION
+//   [1]      device ID
+//   [2..5]   uptime, seconds
+//   [6..14]  per signal 1-3: [mode 'v'/'c'][setpoint, centivolts or centi-mA u16]
+//   [15]     waveform flags (TELEMETRY_WAVE_*)
+//   [16]     waveform mode ('v', 'c', 'd')
+//   [17..18] waveform period, tenths of a second
+//   [19]     relay bitmap (bit n = relay n + 1)
+//   [20..29] error counters u16, saturating: RS-485 (framing, overflow, queue
+//            full), Modbus (CRC, exceptions), output engine (missed ticks,
+//            command overflow), setpoint stream (lost, underrun), log drops
+
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_FRAME_SIZE 30
+#define TELEMETRY_WAVE_ACTIVE 0x01
+#define TELEMETRY_MIN_INTERVAL_MS 50     // Fastest USB subscription rate
+
+/**
+ * Build a telemetry frame
+ * @param frame Output buffer of TELEMETRY_FRAME_SIZE bytes
+ * @return Frame length
+ */
+uint8_t buildTelemetryFrame(uint8_t* frame);
+
+/**
+ * Set up the telemetry job (comms task, after initScheduler())
+ */
+void initTelemetry();
+
+/**
+ * Set the USB subscription rate
+ * @param intervalMs Interval between frames, 0 to stop
+ * @return false if the interval is below TELEMETRY_MIN_INTERVAL_MS
+ */
+bool setTelemetryInterval(uint32_t intervalMs);
+
+/**
+ * Get the USB subscription rate
+ * @return Interval in milliseconds, 0 when not subscribed
+ */
+uint32_t getTelemetryInterval();
+
+/**
+ * Print the current frame decoded as text (on request)
+ */
+void printTelemetry();
+
+#endif // TELEMETRY_H
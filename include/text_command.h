@@ -0,0 +1,96 @@
+#ifndef TEXT_COMMAND_H
+#define TEXT_COMMAND_H
+
+#include <Arduino.h>
+
+// Text Command Front End
+// Allocation-free building blocks shared by every text command parser:
+// - a line assembler that collects bytes from a stream into a fixed buffer
+//   and never waits for the rest of a partial line,
+// - an in-place tokenizer (tokens are NUL-terminated inside the line),
+// - strict numeric parsers that reject trailing garbage and do not go
+//   through strtod, which allocates in newlib.
+
+#define TEXT_LINE_MAX 192         // Longest accepted line, including the terminator
+#define TEXT_SEPARATORS " \t"     // Default token separators
+
+// Line assembler state
+struct LineAssembler {
+    char line[TEXT_LINE_MAX];
+    uint16_t length;
+    bool overflow;                // Current line is too long and is being skipped
+};
+
+// Result of assembleLine()
+enum LineStatus {
+    LINE_PENDING,                 // No complete line yet
+    LINE_READY,                   // assembler->line holds a trimmed line
+    LINE_TOO_LONG                 // A line longer than the buffer was discarded
+};
+
+// Tokenizer position inside a line
+struct TextCursor {
+    char* pos;
+};
+
+/**
+ * Collect bytes already received on a stream
+ * Returns as soon as a line ends or no more bytes are buffered, so a slow
+ * typist never blocks the caller. At most one line is returned per call;
+ * call again while the stream has data. The line stays valid until the next call.
+ * @param assembler Line assembler state
+ * @param stream Source stream
+ * @return Line status
+ */
+LineStatus assembleLine(LineAssembler* assembler, Stream& stream);
+
+/**
+ * Get the next token, terminating it in place
+ * Leading separators are skipped.
+ * @param cursor Tokenizer position, advanced past the token
+ * @param separators Characters that end a token
+ * @return Token, or nullptr at the end of the line
+ */
+char* nextToken(TextCursor* cursor, const char* separators = TEXT_SEPARATORS);
+
+/**
+ * Get the rest of the line with surrounding whitespace removed
+ * @param cursor Tokenizer position, moved to the end of the line
+ * @return Remaining text (empty string at the end of the line)
+ */
+char* remainingText(TextCursor* cursor);
+
+/**
+ * Compare a token with a keyword, ignoring case
+ * @param token Token, may be nullptr
+ * @param word Keyword
+ * @return true if they match
+ */
+bool tokenEquals(const char* token, const char* word);
+
+/**
+ * Parse an unsigned integer
+ * @param text Whole token to parse
+ * @param value Receives the value
+ * @param base 10, 16, or 0 to accept a 0x prefix for hex
+ * @return false if the text is not a number in range
+ */
+bool parseTextUint(const char* text, uint32_t* value, uint8_t base = 0);
+
+/**
+ * Parse a signed integer (decimal, or hex with 0x)
+ * @param text Whole token to parse
+ * @param value Receives the value
+ * @return false if the text is not a number in range
+ */
+bool parseTextInt(const char* text, int32_t* value);
+
+/**
+ * Parse a decimal floating point number ([-]digits[.digits][e[-]digits])
+ * @param text Whole token to parse
+ * @param value Receives the value
+ * @return false if the text is not a number
+ */
+bool parseTextFloat(const char* text, float* value);
+
+#endif // TEXT_COMMAND_H
@@ -0,0 +1,73 @@
+#ifndef HAL_NATIVE_ARDUINO_H
+#define HAL_NATIVE_ARDUINO_H
+
+// Host Arduino Core
+// The subset of the Arduino-ESP32 core the firmware uses, implemented on
+// Linux for the native environment. Time is the host's monotonic clock,
+// GPIO is a simulated pin array and the UARTs are in-memory byte queues
+// (see hal_sim.h for the simulation side of each device).
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <ctype.h>
+#include <functional>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define PI 3.1415926535897932384626433832795
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+
+#define IRAM_ATTR
+
+#define HAL_PIN_COUNT 40
+#define HAL_CPU_FREQ_MHZ 240      // Rate ESP.getCycleCount() runs at
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+uint32_t getCpuFrequencyMhz();
+
+// ESP object: cycle counter and heap figures
+class EspClass {
+public:
+    uint32_t getCycleCount();
+    uint32_t getFreeHeap();
+};
+extern EspClass ESP;
+
+// Arduino hardware timers (ESP32 core 2.x API); the alarm runs on a host thread
+struct hw_timer_t;
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool countUp);
+void timerAttachInterrupt(hw_timer_t* timer, void (*fn)(void), bool edge);
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarmValue, bool autoreload);
+void timerAlarmEnable(hw_timer_t* timer);
+void timerAlarmDisable(hw_timer_t* timer);
+
+#include "Stream.h"
+#include "HardwareSerial.h"
+
+#endif // HAL_NATIVE_ARDUINO_H
@@ -0,0 +1,38 @@
+#ifndef HAL_NATIVE_DFROBOT_GP8XXX_H
+#define HAL_NATIVE_DFROBOT_GP8XXX_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// GP8XXX I2C DAC, simulated
+// Output codes are kept per device address and channel; read them back
+// with halGetDacCode().
+
+#define DFGP8XXX_I2C_DEVICEADDR 0x58
+#define RESOLUTION_12_BIT 0x0FFF
+#define RESOLUTION_15_BIT 0x7FFF
+
+class DFRobot_GP8XXX_IIC {
+public:
+    typedef enum {
+        eOutputRange2_5V = 0,
+        eOutputRange5V = 1,
+        eOutputRange10V = 2,
+        eOutputRangeVCC = 3
+    } eOutPutRange_t;
+
+    DFRobot_GP8XXX_IIC(uint16_t resolution, uint8_t deviceAddr = DFGP8XXX_I2C_DEVICEADDR, TwoWire* pWire = &Wire)
+        : _resolution(resolution), _deviceAddr(deviceAddr), _pWire(pWire) {}
+
+    int begin() { return 0; }
+    void setDACOutRange(eOutPutRange_t range) {}
+    void setDACOutVoltage(uint16_t data, uint8_t channel = 0);
+    void store() {}
+
+protected:
+    uint16_t _resolution;
+    uint8_t _deviceAddr;
+    TwoWire* _pWire;
+};
+
+#endif // HAL_NATIVE_DFROBOT_GP8XXX_H
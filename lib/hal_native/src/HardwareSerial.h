@@ -0,0 +1,61 @@
+#ifndef HAL_NATIVE_HARDWARE_SERIAL_H
+#define HAL_NATIVE_HARDWARE_SERIAL_H
+
+#include <functional>
+#include <deque>
+#include <mutex>
+#include "Stream.h"
+
+#define SERIAL_8N1 0x800001c
+#define SERIAL_8E1 0x800001e
+#define SERIAL_8O1 0x800001f
+
+#define HAL_SERIAL_BUFFER_SIZE 4096  // Per direction; the oldest bytes are dropped beyond this
+
+typedef std::function<void(void)> OnReceiveCb;
+typedef std::function<void(const uint8_t*, size_t)> HalTxHandler;
+
+// UART backed by in-memory queues
+// UART 0 writes to stdout unless a TX handler is set; the other ports keep
+// their output for the simulation side to collect.
+class HardwareSerial : public Stream {
+public:
+    explicit HardwareSerial(int uartNum);
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1);
+    void end();
+    void onReceive(OnReceiveCb function, bool onlyOnTimeout = false);
+    bool setRxTimeout(uint8_t symbols);
+    void setRxBufferSize(size_t size) {}
+    unsigned long baudRate() const { return baud; }
+    operator bool() const { return true; }
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int availableForWrite() override;
+    void flush() override;
+
+    // Simulation side (hal_sim.h)
+    void simReceive(const uint8_t* data, size_t length);
+    size_t simTakeTx(uint8_t* out, size_t maxLength);
+    void simSetTxHandler(HalTxHandler handler);
+
+private:
+    int uartNum;
+    unsigned long baud = 115200;
+    std::mutex lock;
+    std::deque<uint8_t> rx;
+    std::deque<uint8_t> tx;
+    OnReceiveCb onReceiveCb;
+    HalTxHandler txHandler;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+
+#endif // HAL_NATIVE_HARDWARE_SERIAL_H
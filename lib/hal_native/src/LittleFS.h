@@ -0,0 +1,63 @@
+#ifndef HAL_NATIVE_LITTLEFS_H
+#define HAL_NATIVE_LITTLEFS_H
+
+#include <Arduino.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// LittleFS, simulated in memory
+// Files written through an open handle are visible immediately; directories
+// list the files directly below them. halResetStorage() erases everything.
+
+struct HalFileNode;
+
+class File {
+public:
+    File() {}
+    File(std::shared_ptr<HalFileNode> node, const std::string& path, bool writable, bool append);
+
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size);
+    int read();
+    size_t read(uint8_t* buffer, size_t size);
+    int available();
+    size_t size();
+    size_t position() const { return pos; }
+    bool seek(uint32_t position);
+    void close();
+    const char* name() const;
+    const char* path() const { return filePath.c_str(); }
+    bool isDirectory() const;
+    File openNextFile();
+    operator bool() const { return node != nullptr || directory; }
+
+private:
+    std::shared_ptr<HalFileNode> node;    // nullptr for a directory or a closed file
+    std::string filePath;
+    size_t pos = 0;
+    bool writable = false;
+    bool directory = false;
+    std::vector<std::string> entries;     // Directory listing when opened
+    size_t nextEntry = 0;
+};
+
+class LittleFSFS {
+public:
+    bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+               const char* partitionLabel = "spiffs");
+    void end() {}
+    bool format();
+    File open(const char* path, const char* mode = "r", bool create = false);
+    bool exists(const char* path);
+    bool remove(const char* path);
+    bool rename(const char* from, const char* to);
+    bool mkdir(const char* path);
+    bool rmdir(const char* path);
+    size_t totalBytes();
+    size_t usedBytes();
+};
+
+extern LittleFSFS LittleFS;
+
+#endif // HAL_NATIVE_LITTLEFS_H
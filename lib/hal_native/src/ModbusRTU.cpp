@@ -0,0 +1,330 @@
+#include <ModbusRTU.h>
+
+/**
+ * CRC-16/MODBUS
+ */
+static uint16_t modbusCrc(const uint8_t* data, uint16_t length) {
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+        }
+    }
+    return crc;
+}
+
+/**
+ * Attach the serial port
+ */
+bool ModbusRTU::begin(HardwareSerial* port, int16_t txPin, bool direct) {
+    this->port = port;
+    this->txPin = txPin;
+    if (txPin >= 0) {
+        pinMode(txPin, OUTPUT);
+        digitalWrite(txPin, direct ? LOW : HIGH);
+    }
+    return true;
+}
+
+/**
+ * Poll the port; a frame is processed once the line has been silent for 3.5 characters
+ */
+void ModbusRTU::task() {
+    if (!port) {
+        return;
+    }
+    int available = port->available();
+    if (available == 0) {
+        pendingBytes = 0;
+        return;
+    }
+    uint32_t now = micros();
+    if (available != pendingBytes) {
+        pendingBytes = available;
+        lastByteUs = now;
+        return;
+    }
+    unsigned long baud = port->baudRate();
+    uint32_t t35 = baud > 19200 ? 1750 : (uint32_t)(35000000UL / baud * 11 / 10);
+    if (now - lastByteUs < t35) {
+        return;
+    }
+
+    uint8_t frame[MODBUS_MAX_FRAME];
+    uint16_t length = 0;
+    while (length < sizeof(frame) && port->available()) {
+        frame[length++] = port->read();
+    }
+    while (port->available()) {
+        port->read(); // Oversized frame, dropped below
+        length = sizeof(frame) + 1;
+    }
+    pendingBytes = 0;
+    if (length <= sizeof(frame)) {
+        processFrame(frame, length);
+    }
+}
+
+/**
+ * Check the address and CRC of a frame and answer it
+ */
+void ModbusRTU::processFrame(uint8_t* frame, uint16_t length) {
+    if (length < 4) {
+        return;
+    }
+    uint16_t crc = frame[length - 2] | (frame[length - 1] << 8);
+    if (crc != modbusCrc(frame, length - 2)) {
+        return;
+    }
+    // The raw hook sees every frame that passed the CRC, any address
+    uint8_t address = frame[0];
+    uint8_t* pdu = frame + 1;
+    uint16_t pduLength = length - 3;
+    ResultCode result = EX_PASSTHROUGH;
+    if (rawCb) {
+        frame_arg_t header = {true, address};
+        rawAnswered = false;
+        result = rawCb(pdu, pduLength, &header);
+        if (result == EX_SUCCESS && rawAnswered) {
+            return;
+        }
+    }
+    if (address != slaveId_ && address != 0) {
+        return;
+    }
+
+    uint8_t response[MODBUS_MAX_FRAME];
+    uint16_t responseLength = 0;
+    if (result == EX_PASSTHROUGH || result == EX_FORCE_PROCESS) {
+        responseLength = processRequest(pdu, pduLength, &result);
+        if (result == EX_SUCCESS) {
+            memcpy(response, pdu, responseLength);
+        }
+    } else if (result == EX_SUCCESS) {
+        // Raw hook answered in place
+        memcpy(response, pdu, pduLength);
+        responseLength = pduLength;
+    }
+
+    if (result != EX_SUCCESS) {
+        response[0] = pdu[0] | 0x80;
+        response[1] = result;
+        responseLength = 2;
+    }
+    if (address != 0) {
+        sendResponse(slaveId_, response, responseLength);
+    }
+}
+
+/**
+ * Serve a request from the register map
+ * The response PDU is written over the request.
+ * @return Response PDU length
+ */
+uint16_t ModbusRTU::processRequest(uint8_t* pdu, uint16_t length, ResultCode* result) {
+    FunctionCode fc = (FunctionCode)pdu[0];
+    RequestData data = {};
+    uint16_t first = length >= 3 ? (pdu[1] << 8) | pdu[2] : 0;
+    uint16_t count = length >= 5 ? (pdu[3] << 8) | pdu[4] : 0;
+
+    TAddress::RegType type;
+    switch (fc) {
+        case FC_READ_REGS:
+        case FC_READ_INPUT_REGS:
+            type = fc == FC_READ_REGS ? TAddress::HREG : TAddress::IREG;
+            if (length != 5 || count < 1 || count > 125) {
+                *result = EX_ILLEGAL_VALUE;
+                return 0;
+            }
+            break;
+        case FC_WRITE_REG:
+            type = TAddress::HREG;
+            if (length != 5) {
+                *result = EX_ILLEGAL_VALUE;
+                return 0;
+            }
+            count = 1;
+            break;
+        case FC_WRITE_REGS:
+            type = TAddress::HREG;
+            if (length < 6 || count < 1 || count > 123 || pdu[5] != count * 2 || length != 6 + count * 2) {
+                *result = EX_ILLEGAL_VALUE;
+                return 0;
+            }
+            break;
+        default:
+            *result = EX_ILLEGAL_FUNCTION;
+            return 0;
+    }
+
+    data.reg = {type, first};
+    data.regCount = count;
+    if (requestCb && (*result = requestCb(fc, data)) != EX_SUCCESS) {
+        return 0;
+    }
+    if (!hasRegs(type, first, count)) {
+        *result = EX_ILLEGAL_ADDRESS;
+        return 0;
+    }
+
+    uint16_t responseLength;
+    if (fc == FC_READ_REGS || fc == FC_READ_INPUT_REGS) {
+        uint16_t values[125];
+        for (uint16_t i = 0; i < count; i++) {
+            values[i] = getReg(type, first + i);
+        }
+        pdu[1] = count * 2;
+        for (uint16_t i = 0; i < count; i++) {
+            pdu[2 + i * 2] = values[i] >> 8;
+            pdu[3 + i * 2] = values[i] & 0xFF;
+        }
+        responseLength = 2 + count * 2;
+    } else if (fc == FC_WRITE_REG) {
+        setReg(type, first, count); // The "count" field holds the value
+        responseLength = 5;
+    } else {
+        for (uint16_t i = 0; i < count; i++) {
+            setReg(type, first + i, (pdu[6 + i * 2] << 8) | pdu[7 + i * 2]);
+        }
+        responseLength = 5;
+    }
+
+    *result = EX_SUCCESS;
+    if (requestSuccessCb) {
+        requestSuccessCb(fc, data);
+    }
+    return responseLength;
+}
+
+/**
+ * Send a response PDU built by the raw hook
+ */
+uint16_t ModbusRTU::rawResponce(uint8_t slaveId, uint8_t* data, uint16_t len) {
+    if (!port || len > MODBUS_MAX_FRAME) {
+        return 0;
+    }
+    sendResponse(slaveId, data, len);
+    rawAnswered = true;
+    return len;
+}
+
+/**
+ * Send a response PDU with a slave address and the CRC
+ */
+void ModbusRTU::sendResponse(uint8_t slaveId, const uint8_t* pdu, uint16_t length) {
+    uint8_t frame[MODBUS_MAX_FRAME + 3];
+    frame[0] = slaveId;
+    memcpy(frame + 1, pdu, length);
+    uint16_t crc = modbusCrc(frame, length + 1);
+    frame[length + 1] = crc & 0xFF;
+    frame[length + 2] = crc >> 8;
+
+    if (txPin >= 0) {
+        digitalWrite(txPin, HIGH);
+    }
+    port->write(frame, length + 3);
+    port->flush();
+    if (txPin >= 0) {
+        digitalWrite(txPin, LOW);
+    }
+}
+
+/**
+ * Add registers
+ */
+bool ModbusRTU::addReg(TAddress::RegType type, uint16_t offset, uint16_t value, uint16_t numregs) {
+    for (uint32_t i = 0; i < numregs; i++) {
+        uint16_t address = offset + i;
+        if (!regs.count(regKey(type, address))) {
+            regs[regKey(type, address)] = TRegister{{type, address}, value};
+        }
+    }
+    return true;
+}
+
+/**
+ * Set a register through its onSet callbacks
+ */
+bool ModbusRTU::setReg(TAddress::RegType type, uint16_t offset, uint16_t value) {
+    auto it = regs.find(regKey(type, offset));
+    if (it == regs.end()) {
+        return false;
+    }
+    if (cbEnabled) {
+        for (const Callback& callback : callbacks) {
+            if (callback.onSet && callback.type == type && (uint16_t)(offset - callback.first) < callback.count) {
+                value = callback.cb(&it->second, value);
+            }
+        }
+    }
+    it->second.value = value;
+    return true;
+}
+
+/**
+ * Get a register through its onGet callbacks
+ */
+uint16_t ModbusRTU::getReg(TAddress::RegType type, uint16_t offset) {
+    auto it = regs.find(regKey(type, offset));
+    if (it == regs.end()) {
+        return 0;
+    }
+    uint16_t value = it->second.value;
+    if (cbEnabled) {
+        for (const Callback& callback : callbacks) {
+            if (!callback.onSet && callback.type == type && (uint16_t)(offset - callback.first) < callback.count) {
+                value = callback.cb(&it->second, value);
+            }
+        }
+    }
+    return value;
+}
+
+/**
+ * Remove registers
+ */
+bool ModbusRTU::removeReg(TAddress::RegType type, uint16_t offset, uint16_t numregs) {
+    bool removed = false;
+    for (uint32_t i = 0; i < numregs; i++) {
+        removed |= regs.erase(regKey(type, offset + i)) > 0;
+    }
+    return removed;
+}
+
+/**
+ * Register a callback for a range of registers
+ */
+bool ModbusRTU::addCallback(TAddress::RegType type, bool onSet, uint16_t offset, cbModbus cb, uint16_t numregs) {
+    if (!cb) {
+        return false;
+    }
+    callbacks.push_back(Callback{type, onSet, offset, numregs, cb});
+    return true;
+}
+
+/**
+ * Check that every register in a range exists
+ */
+bool ModbusRTU::hasRegs(TAddress::RegType type, uint16_t first, uint16_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (!regs.count(regKey(type, first + i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ModbusRTU::addHreg(uint16_t offset, uint16_t value, uint16_t numregs) { return addReg(TAddress::HREG, offset, value, numregs); }
+bool ModbusRTU::Hreg(uint16_t offset, uint16_t value) { return setReg(TAddress::HREG, offset, value); }
+uint16_t ModbusRTU::Hreg(uint16_t offset) { return getReg(TAddress::HREG, offset); }
+bool ModbusRTU::removeHreg(uint16_t offset, uint16_t numregs) { return removeReg(TAddress::HREG, offset, numregs); }
+bool ModbusRTU::onGetHreg(uint16_t offset, cbModbus cb, uint16_t numregs) { return addCallback(TAddress::HREG, false, offset, cb, numregs); }
+bool ModbusRTU::onSetHreg(uint16_t offset, cbModbus cb, uint16_t numregs) { return addCallback(TAddress::HREG, true, offset, cb, numregs); }
+
+bool ModbusRTU::addIreg(uint16_t offset, uint16_t value, uint16_t numregs) { return addReg(TAddress::IREG, offset, value, numregs); }
+bool ModbusRTU::Ireg(uint16_t offset, uint16_t value) { return setReg(TAddress::IREG, offset, value); }
+uint16_t ModbusRTU::Ireg(uint16_t offset) { return getReg(TAddress::IREG, offset); }
+bool ModbusRTU::removeIreg(uint16_t offset, uint16_t numregs) { return removeReg(TAddress::IREG, offset, numregs); }
+bool ModbusRTU::onGetIreg(uint16_t offset, cbModbus cb, uint16_t numregs) { return addCallback(TAddress::IREG, false, offset, cb, numregs); }
+bool ModbusRTU::onSetIreg(uint16_t offset, cbModbus cb, uint16_t numregs) { return addCallback(TAddress::IREG, true, offset, cb, numregs); }
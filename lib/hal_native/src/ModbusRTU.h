@@ -0,0 +1,144 @@
+#ifndef HAL_NATIVE_MODBUS_RTU_H
+#define HAL_NATIVE_MODBUS_RTU_H
+
+#include <Arduino.h>
+#include <functional>
+#include <map>
+#include <vector>
+
+// Modbus RTU slave (modbus-esp8266 4.x interface)
+// Serves FC03, FC04, FC06 and FC16 from the register map with the library's
+// callback semantics: onSet callbacks filter the stored value, onGet
+// callbacks supply the value read, the raw hook sees every frame that passed
+// the CRC (any slave address) before processing. A raw hook returning EX_SUCCESS has answered the
+// request: either in place (same length) or through rawResponce().
+// Frames are delimited by 3.5 character times of silence on the attached
+// port, as on the target.
+
+#define MODBUS_MAX_FRAME 256
+
+struct TAddress {
+    enum RegType { COIL, ISTS, IREG, HREG, NONE = 0xFF };
+    RegType type;
+    uint16_t address;
+};
+
+struct TRegister {
+    TAddress address;
+    uint16_t value;
+};
+
+class Modbus {
+public:
+    enum FunctionCode {
+        FC_READ_COILS = 0x01,
+        FC_READ_INPUT_STAT = 0x02,
+        FC_READ_REGS = 0x03,
+        FC_READ_INPUT_REGS = 0x04,
+        FC_WRITE_COIL = 0x05,
+        FC_WRITE_REG = 0x06,
+        FC_DIAGNOSTICS = 0x08,
+        FC_WRITE_COILS = 0x0F,
+        FC_WRITE_REGS = 0x10,
+        FC_MASKWRITE_REG = 0x16,
+        FC_READWRITE_REGS = 0x17
+    };
+    enum ResultCode {
+        EX_SUCCESS = 0x00,
+        EX_ILLEGAL_FUNCTION = 0x01,
+        EX_ILLEGAL_ADDRESS = 0x02,
+        EX_ILLEGAL_VALUE = 0x03,
+        EX_SLAVE_FAILURE = 0x04,
+        EX_ACKNOWLEDGE = 0x05,
+        EX_SLAVE_DEVICE_BUSY = 0x06,
+        EX_MEMORY_PARITY_ERROR = 0x08,
+        EX_PATH_UNAVAILABLE = 0x0A,
+        EX_DEVICE_FAILED_TO_RESPOND = 0x0B,
+        EX_GENERAL_FAILURE = 0xE1,
+        EX_DATA_MISMACH = 0xE2,
+        EX_UNEXPECTED_RESPONSE = 0xE3,
+        EX_TIMEOUT = 0xE4,
+        EX_CONNECTION_LOST = 0xE5,
+        EX_CANCEL = 0xE6,
+        EX_PASSTHROUGH = 0xE7,
+        EX_FORCE_PROCESS = 0xE8
+    };
+    struct RequestData {
+        TAddress reg;
+        uint16_t regCount;
+        TAddress regRead;
+        uint16_t regReadCount;
+    };
+    struct frame_arg_t {
+        bool to_server;
+        uint8_t slaveId;
+    };
+};
+
+typedef std::function<uint16_t(TRegister* reg, uint16_t val)> cbModbus;
+typedef std::function<Modbus::ResultCode(Modbus::FunctionCode fc, const Modbus::RequestData data)> cbRequest;
+typedef std::function<Modbus::ResultCode(uint8_t* data, uint8_t len, void* custom)> cbRaw;
+
+class ModbusRTU : public Modbus {
+public:
+    bool begin(HardwareSerial* port, int16_t txPin = -1, bool direct = true);
+    void slave(uint8_t slaveId) { slaveId_ = slaveId; }
+    uint8_t slave() const { return slaveId_; }
+    void task();
+
+    bool addHreg(uint16_t offset, uint16_t value = 0, uint16_t numregs = 1);
+    bool Hreg(uint16_t offset, uint16_t value);
+    uint16_t Hreg(uint16_t offset);
+    bool removeHreg(uint16_t offset, uint16_t numregs = 1);
+    bool onGetHreg(uint16_t offset, cbModbus cb = nullptr, uint16_t numregs = 1);
+    bool onSetHreg(uint16_t offset, cbModbus cb = nullptr, uint16_t numregs = 1);
+
+    bool addIreg(uint16_t offset, uint16_t value = 0, uint16_t numregs = 1);
+    bool Ireg(uint16_t offset, uint16_t value);
+    uint16_t Ireg(uint16_t offset);
+    bool removeIreg(uint16_t offset, uint16_t numregs = 1);
+    bool onGetIreg(uint16_t offset, cbModbus cb = nullptr, uint16_t numregs = 1);
+    bool onSetIreg(uint16_t offset, cbModbus cb = nullptr, uint16_t numregs = 1);
+
+    bool onRequest(cbRequest cb = nullptr) { requestCb = cb; return true; }
+    bool onRequestSuccess(cbRequest cb = nullptr) { requestSuccessCb = cb; return true; }
+    bool onRaw(cbRaw cb = nullptr) { rawCb = cb; return true; }
+    uint16_t rawResponce(uint8_t slaveId, uint8_t* data, uint16_t len);
+    void cbEnable(bool state = true) { cbEnabled = state; }
+    void cbDisable() { cbEnabled = false; }
+
+private:
+    struct Callback {
+        TAddress::RegType type;
+        bool onSet;
+        uint16_t first;
+        uint16_t count;
+        cbModbus cb;
+    };
+
+    static uint32_t regKey(TAddress::RegType type, uint16_t address) { return ((uint32_t)type << 16) | address; }
+    bool addReg(TAddress::RegType type, uint16_t offset, uint16_t value, uint16_t numregs);
+    bool setReg(TAddress::RegType type, uint16_t offset, uint16_t value);
+    uint16_t getReg(TAddress::RegType type, uint16_t offset);
+    bool removeReg(TAddress::RegType type, uint16_t offset, uint16_t numregs);
+    bool addCallback(TAddress::RegType type, bool onSet, uint16_t offset, cbModbus cb, uint16_t numregs);
+    bool hasRegs(TAddress::RegType type, uint16_t first, uint16_t count);
+    void processFrame(uint8_t* frame, uint16_t length);
+    uint16_t processRequest(uint8_t* pdu, uint16_t length, ResultCode* result);
+    void sendResponse(uint8_t slaveId, const uint8_t* pdu, uint16_t length);
+
+    HardwareSerial* port = nullptr;
+    int16_t txPin = -1;
+    uint8_t slaveId_ = 1;
+    bool cbEnabled = true;
+    std::map<uint32_t, TRegister> regs;
+    std::vector<Callback> callbacks;
+    cbRequest requestCb;
+    cbRequest requestSuccessCb;
+    cbRaw rawCb;
+    bool rawAnswered = false;             // rawResponce() called from the raw hook
+    int pendingBytes = 0;                 // Bytes seen on the last poll
+    uint32_t lastByteUs = 0;              // When pendingBytes last changed
+};
+
+#endif // HAL_NATIVE_MODBUS_RTU_H
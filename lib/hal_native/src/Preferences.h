@@ -0,0 +1,40 @@
+#ifndef HAL_NATIVE_PREFERENCES_H
+#define HAL_NATIVE_PREFERENCES_H
+
+#include <Arduino.h>
+#include <string>
+
+// NVS key/value store, simulated in memory
+// Values are typed as in NVS: a key written with putBytes() cannot be read
+// back with getUChar(). halResetStorage() erases everything.
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end();
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putUChar(const char* key, uint8_t value);
+    size_t putUShort(const char* key, uint16_t value);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t putBytes(const char* key, const void* value, size_t length);
+    size_t putString(const char* key, const char* value);
+
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0);
+    uint16_t getUShort(const char* key, uint16_t defaultValue = 0);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buffer, size_t maxLength);
+    size_t getString(const char* key, char* value, size_t maxLength);
+
+private:
+    size_t put(const char* key, char type, const void* value, size_t length);
+    bool get(const char* key, char type, void* value, size_t length);
+
+    std::string space;
+    bool opened = false;
+    bool readOnly = true;
+};
+
+#endif // HAL_NATIVE_PREFERENCES_H
@@ -0,0 +1,18 @@
+#ifndef HAL_NATIVE_WIRE_H
+#define HAL_NATIVE_WIRE_H
+
+#include <Arduino.h>
+
+// I2C bus; the devices on it are simulated by their drivers (see DFRobot_GP8XXX.h)
+class TwoWire {
+public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) { return true; }
+    void setClock(uint32_t frequency) {}
+    void beginTransmission(uint8_t address) {}
+    size_t write(uint8_t data) { return 1; }
+    uint8_t endTransmission(bool sendStop = true) { return 0; }
+};
+
+extern TwoWire Wire;
+
+#endif // HAL_NATIVE_WIRE_H
@@ -0,0 +1,44 @@
+#ifndef HAL_NATIVE_FREERTOS_H
+#define HAL_NATIVE_FREERTOS_H
+
+// Host FreeRTOS
+// Tasks are host threads; priorities and core affinity are accepted and
+// ignored. Critical sections take one process-wide lock, standing in for
+// the interrupt mask, so they also exclude the timer "interrupts".
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef struct HalTask* TaskHandle_t;
+typedef struct HalQueue* QueueHandle_t;
+typedef struct HalSemaphore* SemaphoreHandle_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xFFFFFFFFu
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((TickType_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define configMAX_PRIORITIES 25
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+typedef struct {
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0, 0}
+
+void halEnterCritical(portMUX_TYPE* mux);
+void halExitCritical(portMUX_TYPE* mux);
+
+#define portENTER_CRITICAL(mux) halEnterCritical(mux)
+#define portEXIT_CRITICAL(mux) halExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux) halEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux) halExitCritical(mux)
+#define portYIELD_FROM_ISR()
+
+#endif // HAL_NATIVE_FREERTOS_H
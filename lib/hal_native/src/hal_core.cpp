@@ -0,0 +1,232 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include <DFRobot_GP8XXX.h>
+#include "hal_sim.h"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unistd.h>
+
+typedef std::chrono::steady_clock HalClock;
+
+static const HalClock::time_point startTime = HalClock::now();
+
+// Simulated GPIO
+struct PinState {
+    std::atomic<uint8_t> mode;
+    std::atomic<uint8_t> output;
+    std::atomic<uint8_t> input;
+    std::atomic<bool> driven;     // Input level set by the simulation
+};
+static PinState pins[HAL_PIN_COUNT];
+
+// Simulated DAC outputs, keyed by (address << 1) | channel
+static std::mutex dacLock;
+static std::map<uint16_t, uint16_t> dacCodes;
+static std::atomic<uint32_t> dacWrites(0);
+
+static std::mt19937 randomEngine(1);
+static std::mutex randomLock;
+
+EspClass ESP;
+TwoWire Wire;
+
+/**
+ * Nanoseconds since start
+ */
+static uint64_t elapsedNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(HalClock::now() - startTime).count();
+}
+
+/**
+ * Milliseconds since start
+ */
+unsigned long millis() {
+    return (uint32_t)(elapsedNs() / 1000000);
+}
+
+/**
+ * Microseconds since start (wraps at 32 bits, as on the target)
+ */
+unsigned long micros() {
+    return (uint32_t)(elapsedNs() / 1000);
+}
+
+/**
+ * Sleep for a number of milliseconds
+ */
+void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+/**
+ * Wait for a number of microseconds
+ */
+void delayMicroseconds(uint32_t us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+/**
+ * Configure a pin
+ */
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin >= HAL_PIN_COUNT) {
+        return;
+    }
+    pins[pin].mode = mode;
+    if (!pins[pin].driven) {
+        pins[pin].input = mode == INPUT_PULLUP ? HIGH : LOW;
+    }
+}
+
+/**
+ * Set an output pin
+ */
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < HAL_PIN_COUNT) {
+        pins[pin].output = value ? HIGH : LOW;
+    }
+}
+
+/**
+ * Read a pin
+ */
+int digitalRead(uint8_t pin) {
+    if (pin >= HAL_PIN_COUNT) {
+        return LOW;
+    }
+    return pins[pin].mode == OUTPUT ? pins[pin].output : pins[pin].input;
+}
+
+/**
+ * Drive an input pin
+ */
+void halSetPinInput(uint8_t pin, uint8_t level) {
+    if (pin < HAL_PIN_COUNT) {
+        pins[pin].input = level ? HIGH : LOW;
+        pins[pin].driven = true;
+    }
+}
+
+/**
+ * Get the level on a pin
+ */
+uint8_t halGetPinLevel(uint8_t pin) {
+    return digitalRead(pin);
+}
+
+/**
+ * Get the mode a pin was set to
+ */
+uint8_t halGetPinMode(uint8_t pin) {
+    return pin < HAL_PIN_COUNT ? pins[pin].mode.load() : 0;
+}
+
+/**
+ * Random number in [0, max)
+ */
+long random(long max) {
+    return max <= 0 ? 0 : random(0, max);
+}
+
+/**
+ * Random number in [min, max)
+ */
+long random(long min, long max) {
+    if (min >= max) {
+        return min;
+    }
+    std::lock_guard<std::mutex> guard(randomLock);
+    return std::uniform_int_distribution<long>(min, max - 1)(randomEngine);
+}
+
+/**
+ * Seed the random number generator
+ */
+void randomSeed(unsigned long seed) {
+    std::lock_guard<std::mutex> guard(randomLock);
+    randomEngine.seed(seed);
+}
+
+/**
+ * CPU clock of the target the cycle counter is scaled to
+ */
+uint32_t getCpuFrequencyMhz() {
+    return HAL_CPU_FREQ_MHZ;
+}
+
+/**
+ * Cycle counter at HAL_CPU_FREQ_MHZ
+ */
+uint32_t EspClass::getCycleCount() {
+    return (uint32_t)(elapsedNs() * HAL_CPU_FREQ_MHZ / 1000);
+}
+
+/**
+ * Free heap (not tracked on the host)
+ */
+uint32_t EspClass::getFreeHeap() {
+    return 0;
+}
+
+/**
+ * Write a code to the simulated DAC
+ */
+void DFRobot_GP8XXX_IIC::setDACOutVoltage(uint16_t data, uint8_t channel) {
+    std::lock_guard<std::mutex> guard(dacLock);
+    dacCodes[(_deviceAddr << 1) | (channel & 1)] = data > _resolution ? _resolution : data;
+    dacWrites++;
+}
+
+/**
+ * Get the last code written to a simulated DAC
+ */
+uint16_t halGetDacCode(uint8_t address, uint8_t channel) {
+    std::lock_guard<std::mutex> guard(dacLock);
+    auto it = dacCodes.find((address << 1) | (channel & 1));
+    return it == dacCodes.end() ? 0 : it->second;
+}
+
+/**
+ * Get the number of DAC writes since start
+ */
+uint32_t halGetDacWriteCount() {
+    return dacWrites;
+}
+
+/**
+ * Feed stdin to the USB console
+ */
+void halStartConsole() {
+    std::thread([] {
+        uint8_t buffer[256];
+        ssize_t length;
+        while ((length = ::read(STDIN_FILENO, buffer, sizeof(buffer))) > 0) {
+            Serial.simReceive(buffer, length);
+        }
+    }).detach();
+}
+
+void setup() __attribute__((weak));
+void loop() __attribute__((weak));
+
+/**
+ * Firmware entry point: setup() once, then loop() forever
+ * Weak, so test runners and simulators can provide their own.
+ */
+__attribute__((weak)) int main() {
+    halStartConsole();
+    if (setup) {
+        setup();
+    }
+    for (;;) {
+        if (loop) {
+            loop();
+        } else {
+            delay(1000);
+        }
+    }
+}
@@ -0,0 +1,389 @@
+#include <Arduino.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock HalClock;
+
+// Task: a host thread with a notification counter
+struct HalTask {
+    std::mutex lock;
+    std::condition_variable wake;
+    uint32_t notifications = 0;
+};
+
+struct HalQueue {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+};
+
+struct HalSemaphore {
+    std::recursive_timed_mutex mutex;   // Mutex kinds
+    std::mutex lock;                    // Binary kind
+    std::condition_variable given;
+    bool available = false;
+    bool binary = false;
+};
+
+struct hw_timer_t {
+    uint16_t divider;
+    void (*handler)(void);
+    uint64_t alarmTicks;
+    bool autoreload;
+    std::atomic<bool> enabled;
+    std::atomic<uint32_t> generation;   // Bumped to retire a running alarm thread
+};
+
+static thread_local HalTask* currentTask = nullptr;
+static std::recursive_mutex criticalLock;     // Stands in for the interrupt mask
+
+/**
+ * Deadline for a FreeRTOS timeout
+ */
+static HalClock::time_point tickDeadline(TickType_t ticks) {
+    return HalClock::now() + std::chrono::milliseconds((uint64_t)ticks * portTICK_PERIOD_MS);
+}
+
+/**
+ * Create a task
+ */
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameter,
+                       UBaseType_t priority, TaskHandle_t* handle) {
+    HalTask* task = new HalTask();
+    if (handle) {
+        *handle = task;
+    }
+    std::thread([task, function, parameter] {
+        currentTask = task;
+        function(parameter);
+    }).detach();
+    return pdPASS;
+}
+
+/**
+ * Create a task; the core is ignored
+ */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth,
+                                   void* parameter, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t coreId) {
+    return xTaskCreate(function, name, stackDepth, parameter, priority, handle);
+}
+
+/**
+ * Delete a task
+ * A host thread cannot be stopped from outside, so only a task deleting
+ * itself is supported; it never runs again.
+ */
+void vTaskDelete(TaskHandle_t task) {
+    if (task == nullptr || task == xTaskGetCurrentTaskHandle()) {
+        for (;;) {
+            std::this_thread::sleep_for(std::chrono::hours(24));
+        }
+    }
+}
+
+/**
+ * Sleep for a number of ticks
+ */
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds((uint64_t)ticks * portTICK_PERIOD_MS));
+}
+
+/**
+ * Ticks since start
+ */
+TickType_t xTaskGetTickCount() {
+    return millis() / portTICK_PERIOD_MS;
+}
+
+/**
+ * Handle of the calling task (threads not created as tasks get one on first use)
+ */
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    if (!currentTask) {
+        currentTask = new HalTask();
+    }
+    return currentTask;
+}
+
+/**
+ * Core of the calling task
+ */
+BaseType_t xPortGetCoreID() {
+    return 0;
+}
+
+/**
+ * Wait for notifications
+ */
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+    HalTask* task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> guard(task->lock);
+    if (ticksToWait == portMAX_DELAY) {
+        task->wake.wait(guard, [task] { return task->notifications > 0; });
+    } else {
+        task->wake.wait_until(guard, tickDeadline(ticksToWait), [task] { return task->notifications > 0; });
+    }
+    uint32_t count = task->notifications;
+    if (count > 0) {
+        task->notifications = clearOnExit ? 0 : count - 1;
+    }
+    return count;
+}
+
+/**
+ * Notify a task
+ */
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    {
+        std::lock_guard<std::mutex> guard(task->lock);
+        task->notifications++;
+    }
+    task->wake.notify_one();
+    return pdPASS;
+}
+
+/**
+ * Notify a task from an interrupt
+ */
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken) {
+    xTaskNotifyGive(task);
+    if (higherPriorityTaskWoken) {
+        *higherPriorityTaskWoken = pdFALSE;
+    }
+}
+
+/**
+ * Enter a critical section
+ */
+void halEnterCritical(portMUX_TYPE* mux) {
+    criticalLock.lock();
+    mux->count++;
+}
+
+/**
+ * Leave a critical section
+ */
+void halExitCritical(portMUX_TYPE* mux) {
+    mux->count--;
+    criticalLock.unlock();
+}
+
+/**
+ * Create a queue of fixed-size items
+ */
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    HalQueue* queue = new HalQueue();
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+/**
+ * Append an item, waiting for room
+ */
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticksToWait) {
+    std::unique_lock<std::mutex> guard(queue->lock);
+    auto hasRoom = [queue] { return queue->items.size() < queue->length; };
+    if (ticksToWait == portMAX_DELAY) {
+        queue->changed.wait(guard, hasRoom);
+    } else if (!queue->changed.wait_until(guard, tickDeadline(ticksToWait), hasRoom)) {
+        return pdFALSE;
+    }
+    const uint8_t* bytes = (const uint8_t*)item;
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    guard.unlock();
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+/**
+ * Append an item from an interrupt
+ */
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* higherPriorityTaskWoken) {
+    if (higherPriorityTaskWoken) {
+        *higherPriorityTaskWoken = pdFALSE;
+    }
+    return xQueueSend(queue, item, 0);
+}
+
+/**
+ * Take the oldest item, waiting for one
+ */
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticksToWait) {
+    std::unique_lock<std::mutex> guard(queue->lock);
+    auto hasItem = [queue] { return !queue->items.empty(); };
+    if (ticksToWait == portMAX_DELAY) {
+        queue->changed.wait(guard, hasItem);
+    } else if (!queue->changed.wait_until(guard, tickDeadline(ticksToWait), hasItem)) {
+        return pdFALSE;
+    }
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    guard.unlock();
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+/**
+ * Items in a queue
+ */
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    return queue->items.size();
+}
+
+/**
+ * Create a mutex
+ */
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new HalSemaphore();
+}
+
+/**
+ * Create a recursive mutex
+ */
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+    return new HalSemaphore();
+}
+
+/**
+ * Create a binary semaphore (initially taken)
+ */
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    HalSemaphore* semaphore = new HalSemaphore();
+    semaphore->binary = true;
+    return semaphore;
+}
+
+/**
+ * Take a semaphore or mutex
+ */
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait) {
+    if (!semaphore->binary) {
+        return xSemaphoreTakeRecursive(semaphore, ticksToWait);
+    }
+    std::unique_lock<std::mutex> guard(semaphore->lock);
+    auto isAvailable = [semaphore] { return semaphore->available; };
+    if (ticksToWait == portMAX_DELAY) {
+        semaphore->given.wait(guard, isAvailable);
+    } else if (!semaphore->given.wait_until(guard, tickDeadline(ticksToWait), isAvailable)) {
+        return pdFALSE;
+    }
+    semaphore->available = false;
+    return pdTRUE;
+}
+
+/**
+ * Give a semaphore or mutex
+ */
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    if (!semaphore->binary) {
+        return xSemaphoreGiveRecursive(semaphore);
+    }
+    {
+        std::lock_guard<std::mutex> guard(semaphore->lock);
+        if (semaphore->available) {
+            return pdFALSE;
+        }
+        semaphore->available = true;
+    }
+    semaphore->given.notify_one();
+    return pdTRUE;
+}
+
+/**
+ * Take a recursive mutex
+ */
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t ticksToWait) {
+    if (ticksToWait == portMAX_DELAY) {
+        semaphore->mutex.lock();
+        return pdTRUE;
+    }
+    return semaphore->mutex.try_lock_until(tickDeadline(ticksToWait)) ? pdTRUE : pdFALSE;
+}
+
+/**
+ * Give a recursive mutex
+ */
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore) {
+    semaphore->mutex.unlock();
+    return pdTRUE;
+}
+
+/**
+ * Create a hardware timer (80 MHz APB clock divided by divider)
+ */
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool countUp) {
+    hw_timer_t* timer = new hw_timer_t();
+    timer->divider = divider ? divider : 1;
+    timer->handler = nullptr;
+    timer->alarmTicks = 0;
+    timer->autoreload = false;
+    timer->enabled = false;
+    timer->generation = 0;
+    return timer;
+}
+
+/**
+ * Set the alarm interrupt handler
+ */
+void timerAttachInterrupt(hw_timer_t* timer, void (*fn)(void), bool edge) {
+    timer->handler = fn;
+}
+
+/**
+ * Set the alarm value in timer ticks
+ */
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarmValue, bool autoreload) {
+    timer->alarmTicks = alarmValue;
+    timer->autoreload = autoreload;
+}
+
+/**
+ * Start the alarm: its handler runs on a thread of its own, like an interrupt
+ * Alarms are scheduled on absolute deadlines, so host wake-up latency shows
+ * up as jitter and missed ticks rather than as drift.
+ */
+void timerAlarmEnable(hw_timer_t* timer) {
+    if (timer->alarmTicks == 0 || timer->enabled.exchange(true)) {
+        return;
+    }
+    uint32_t generation = ++timer->generation;
+    std::thread([timer, generation] {
+        auto period = std::chrono::nanoseconds(timer->alarmTicks * timer->divider * 1000 / 80);
+        auto next = HalClock::now() + period;
+        while (timer->enabled && timer->generation == generation) {
+            std::this_thread::sleep_until(next);
+            if (!timer->enabled || timer->generation != generation) {
+                break;
+            }
+            if (timer->handler) {
+                std::lock_guard<std::recursive_mutex> guard(criticalLock);
+                timer->handler();
+            }
+            if (!timer->autoreload) {
+                timer->enabled = false;
+                break;
+            }
+            next += period;
+        }
+    }).detach();
+}
+
+/**
+ * Stop the alarm
+ */
+void timerAlarmDisable(hw_timer_t* timer) {
+    timer->enabled = false;
+    timer->generation++;
+}
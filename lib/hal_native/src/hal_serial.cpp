@@ -0,0 +1,276 @@
+#include <Arduino.h>
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+HardwareSerial Serial2(2);
+
+/**
+ * Write a buffer one byte at a time
+ */
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while (size--) {
+        written += write(*buffer++);
+    }
+    return written;
+}
+
+/**
+ * Write a C string
+ */
+size_t Print::write(const char* str) {
+    return str ? write((const uint8_t*)str, strlen(str)) : 0;
+}
+
+/**
+ * Formatted output
+ */
+size_t Print::printf(const char* format, ...) {
+    char small[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(small, sizeof(small), format, args);
+    va_end(args);
+    if (length < 0) {
+        return 0;
+    }
+    if ((size_t)length < sizeof(small)) {
+        return write((const uint8_t*)small, length);
+    }
+
+    char* large = (char*)malloc(length + 1);
+    if (!large) {
+        return 0;
+    }
+    va_start(args, format);
+    vsnprintf(large, length + 1, format, args);
+    va_end(args);
+    size_t written = write((const uint8_t*)large, length);
+    free(large);
+    return written;
+}
+
+/**
+ * Print a number in a base
+ */
+size_t Print::printNumber(unsigned long value, bool negative, int base) {
+    char buffer[8 * sizeof(long) + 2];
+    char* p = buffer + sizeof(buffer);
+    *--p = '\0';
+    if (base < 2) {
+        base = 10;
+    }
+    do {
+        uint8_t digit = value % base;
+        *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        value /= base;
+    } while (value);
+    if (negative) {
+        *--p = '-';
+    }
+    return write(p);
+}
+
+size_t Print::print(const char* str) { return write(str); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(int value, int base) { return print((long)value, base); }
+size_t Print::print(unsigned int value, int base) { return print((unsigned long)value, base); }
+size_t Print::print(unsigned long value, int base) { return printNumber(value, false, base); }
+
+/**
+ * Print a signed number (negative only in base 10, as in the Arduino core)
+ */
+size_t Print::print(long value, int base) {
+    if (base == 10 && value < 0) {
+        return printNumber(0UL - (unsigned long)value, true, 10);
+    }
+    return printNumber((unsigned long)value, false, base);
+}
+
+/**
+ * Print a floating point number with a number of decimals
+ */
+size_t Print::print(double value, int digits) {
+    return printf("%.*f", digits, value);
+}
+
+size_t Print::println() { return write("\r\n"); }
+size_t Print::println(const char* str) { return print(str) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(int value, int base) { return print(value, base) + println(); }
+size_t Print::println(unsigned int value, int base) { return print(value, base) + println(); }
+size_t Print::println(long value, int base) { return print(value, base) + println(); }
+size_t Print::println(unsigned long value, int base) { return print(value, base) + println(); }
+size_t Print::println(double value, int digits) { return print(value, digits) + println(); }
+
+/**
+ * Read bytes, waiting up to the stream timeout for each one
+ */
+size_t Stream::readBytes(uint8_t* buffer, size_t length) {
+    size_t count = 0;
+    unsigned long start = millis();
+    while (count < length) {
+        int c = read();
+        if (c < 0) {
+            if (millis() - start >= timeout) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+        buffer[count++] = (uint8_t)c;
+        start = millis();
+    }
+    return count;
+}
+
+/**
+ * UART with in-memory queues
+ */
+HardwareSerial::HardwareSerial(int uartNum) : uartNum(uartNum) {}
+
+/**
+ * Open the port; pins and frame format only matter on the target
+ */
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rxPin, int8_t txPin) {
+    this->baud = baud;
+}
+
+/**
+ * Close the port and drop buffered data
+ */
+void HardwareSerial::end() {
+    std::lock_guard<std::mutex> guard(lock);
+    rx.clear();
+    tx.clear();
+}
+
+/**
+ * Set the receive callback, called after each received burst
+ */
+void HardwareSerial::onReceive(OnReceiveCb function, bool onlyOnTimeout) {
+    std::lock_guard<std::mutex> guard(lock);
+    onReceiveCb = function;
+}
+
+/**
+ * RX timeout in symbols (bursts arrive whole on the host)
+ */
+bool HardwareSerial::setRxTimeout(uint8_t symbols) {
+    return true;
+}
+
+/**
+ * Bytes waiting to be read
+ */
+int HardwareSerial::available() {
+    std::lock_guard<std::mutex> guard(lock);
+    return (int)rx.size();
+}
+
+/**
+ * Read one byte
+ */
+int HardwareSerial::read() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (rx.empty()) {
+        return -1;
+    }
+    uint8_t c = rx.front();
+    rx.pop_front();
+    return c;
+}
+
+/**
+ * Next byte without removing it
+ */
+int HardwareSerial::peek() {
+    std::lock_guard<std::mutex> guard(lock);
+    return rx.empty() ? -1 : rx.front();
+}
+
+/**
+ * Send one byte
+ */
+size_t HardwareSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+/**
+ * Send bytes
+ */
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    HalTxHandler handler;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        handler = txHandler;
+        if (!handler && uartNum != 0) {
+            tx.insert(tx.end(), buffer, buffer + size);
+            while (tx.size() > HAL_SERIAL_BUFFER_SIZE) {
+                tx.pop_front();
+            }
+            return size;
+        }
+    }
+    if (handler) {
+        handler(buffer, size);
+    } else {
+        fwrite(buffer, 1, size, stdout);
+        fflush(stdout); // Console output must not sit in stdio's buffer
+    }
+    return size;
+}
+
+/**
+ * Room in the transmit buffer
+ */
+int HardwareSerial::availableForWrite() {
+    return HAL_SERIAL_BUFFER_SIZE;
+}
+
+/**
+ * Wait for transmission to complete
+ */
+void HardwareSerial::flush() {
+}
+
+/**
+ * Bytes arriving on the RX line
+ */
+void HardwareSerial::simReceive(const uint8_t* data, size_t length) {
+    OnReceiveCb callback;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        rx.insert(rx.end(), data, data + length);
+        while (rx.size() > HAL_SERIAL_BUFFER_SIZE) {
+            rx.pop_front();
+        }
+        callback = onReceiveCb;
+    }
+    if (callback) {
+        callback();
+    }
+}
+
+/**
+ * Collect transmitted bytes
+ */
+size_t HardwareSerial::simTakeTx(uint8_t* out, size_t maxLength) {
+    std::lock_guard<std::mutex> guard(lock);
+    size_t count = 0;
+    while (count < maxLength && !tx.empty()) {
+        out[count++] = tx.front();
+        tx.pop_front();
+    }
+    return count;
+}
+
+/**
+ * Route transmitted bytes to a handler instead of the buffer
+ */
+void HardwareSerial::simSetTxHandler(HalTxHandler handler) {
+    std::lock_guard<std::mutex> guard(lock);
+    txHandler = handler;
+}
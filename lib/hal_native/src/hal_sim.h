@@ -0,0 +1,61 @@
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+#include <Arduino.h>
+
+// Native Simulation Control
+// The device side of the host HAL, for tests, benchmarks and simulators:
+// drive inputs, read back outputs and reset simulated storage. UART traffic
+// is injected and collected through HardwareSerial::simReceive(),
+// simTakeTx() and simSetTxHandler().
+//
+// Build and run the firmware on Linux:
+//   pio run -e native && .pio/build/native/program
+// USB console commands are read from stdin.
+
+/**
+ * Drive an input pin (e.g. a device ID jumper)
+ * Overrides the pull-up/pull-down level until the pin is made an output.
+ * @param pin GPIO number
+ * @param level HIGH or LOW
+ */
+void halSetPinInput(uint8_t pin, uint8_t level);
+
+/**
+ * Get the level on a pin
+ * @param pin GPIO number
+ * @return Output level for an output pin, input level otherwise
+ */
+uint8_t halGetPinLevel(uint8_t pin);
+
+/**
+ * Get the mode a pin was set to
+ * @param pin GPIO number
+ * @return INPUT, OUTPUT, INPUT_PULLUP, INPUT_PULLDOWN, or 0 if never set
+ */
+uint8_t halGetPinMode(uint8_t pin);
+
+/**
+ * Get the last code written to a simulated GP8XXX DAC
+ * @param address I2C address
+ * @param channel Output channel (0 or 1)
+ * @return DAC code
+ */
+uint16_t halGetDacCode(uint8_t address, uint8_t channel);
+
+/**
+ * Get the number of DAC writes since start
+ */
+uint32_t halGetDacWriteCount();
+
+/**
+ * Erase the simulated NVS and LittleFS contents
+ */
+void halResetStorage();
+
+/**
+ * Feed stdin to the USB console (Serial) from a reader thread
+ */
+void halStartConsole();
+
+#endif // HAL_SIM_H
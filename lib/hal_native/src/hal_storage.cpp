@@ -0,0 +1,478 @@
+#include <Preferences.h>
+#include <LittleFS.h>
+#include "hal_sim.h"
+#include <map>
+#include <mutex>
+#include <set>
+
+// NVS entry: type letter as used by put/get, value bytes
+struct NvsEntry {
+    char type;
+    std::vector<uint8_t> value;
+};
+
+struct HalFileNode {
+    std::vector<uint8_t> data;
+};
+
+static std::mutex storageLock;
+static std::map<std::string, std::map<std::string, NvsEntry>> nvs;
+static std::map<std::string, std::shared_ptr<HalFileNode>> files;
+static std::set<std::string> directories = {"/"};
+
+LittleFSFS LittleFS;
+
+/**
+ * Erase the simulated NVS and LittleFS contents
+ */
+void halResetStorage() {
+    std::lock_guard<std::mutex> guard(storageLock);
+    nvs.clear();
+    files.clear();
+    directories = {"/"};
+}
+
+/**
+ * Open a namespace
+ */
+bool Preferences::begin(const char* name, bool readOnly, const char* partitionLabel) {
+    if (opened || !name || strlen(name) > 15) {
+        return false;
+    }
+    space = name;
+    this->readOnly = readOnly;
+    opened = true;
+    return true;
+}
+
+/**
+ * Close the namespace
+ */
+void Preferences::end() {
+    opened = false;
+}
+
+/**
+ * Remove every key in the namespace
+ */
+bool Preferences::clear() {
+    if (!opened || readOnly) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    nvs[space].clear();
+    return true;
+}
+
+/**
+ * Remove a key
+ */
+bool Preferences::remove(const char* key) {
+    if (!opened || readOnly) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    return nvs[space].erase(key) > 0;
+}
+
+/**
+ * Check whether a key exists
+ */
+bool Preferences::isKey(const char* key) {
+    if (!opened) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    return nvs[space].count(key) > 0;
+}
+
+/**
+ * Store a typed value
+ */
+size_t Preferences::put(const char* key, char type, const void* value, size_t length) {
+    if (!opened || readOnly || !key || strlen(key) > 15) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    const uint8_t* bytes = (const uint8_t*)value;
+    nvs[space][key] = NvsEntry{type, std::vector<uint8_t>(bytes, bytes + length)};
+    return length;
+}
+
+/**
+ * Load a typed value of an exact size
+ */
+bool Preferences::get(const char* key, char type, void* value, size_t length) {
+    if (!opened || !key) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    auto& entries = nvs[space];
+    auto it = entries.find(key);
+    if (it == entries.end() || it->second.type != type || it->second.value.size() != length) {
+        return false;
+    }
+    memcpy(value, it->second.value.data(), length);
+    return true;
+}
+
+size_t Preferences::putUChar(const char* key, uint8_t value) { return put(key, 'u', &value, sizeof(value)); }
+size_t Preferences::putUShort(const char* key, uint16_t value) { return put(key, 'u', &value, sizeof(value)); }
+size_t Preferences::putUInt(const char* key, uint32_t value) { return put(key, 'u', &value, sizeof(value)); }
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) { return put(key, 'b', value, length); }
+
+/**
+ * Store a string
+ */
+size_t Preferences::putString(const char* key, const char* value) {
+    return value ? put(key, 's', value, strlen(value)) : 0;
+}
+
+/**
+ * Load a byte
+ */
+uint8_t Preferences::getUChar(const char* key, uint8_t defaultValue) {
+    uint8_t value = defaultValue;
+    get(key, 'u', &value, sizeof(value));
+    return value;
+}
+
+/**
+ * Load a 16-bit value
+ */
+uint16_t Preferences::getUShort(const char* key, uint16_t defaultValue) {
+    uint16_t value = defaultValue;
+    get(key, 'u', &value, sizeof(value));
+    return value;
+}
+
+/**
+ * Load a 32-bit value
+ */
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    uint32_t value = defaultValue;
+    get(key, 'u', &value, sizeof(value));
+    return value;
+}
+
+/**
+ * Length of a blob
+ */
+size_t Preferences::getBytesLength(const char* key) {
+    if (!opened || !key) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    auto& entries = nvs[space];
+    auto it = entries.find(key);
+    return it == entries.end() || it->second.type != 'b' ? 0 : it->second.value.size();
+}
+
+/**
+ * Load a blob
+ * @return Blob length, or 0 if it is missing or larger than the buffer
+ */
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLength) {
+    if (!opened || !key) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    auto& entries = nvs[space];
+    auto it = entries.find(key);
+    if (it == entries.end() || it->second.type != 'b' || it->second.value.size() > maxLength) {
+        return 0;
+    }
+    memcpy(buffer, it->second.value.data(), it->second.value.size());
+    return it->second.value.size();
+}
+
+/**
+ * Load a string
+ * @return Length including the terminator, or 0 if it is missing or does not fit
+ */
+size_t Preferences::getString(const char* key, char* value, size_t maxLength) {
+    if (!opened || !key || !value) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    auto& entries = nvs[space];
+    auto it = entries.find(key);
+    if (it == entries.end() || it->second.type != 's' || it->second.value.size() + 1 > maxLength) {
+        return 0;
+    }
+    memcpy(value, it->second.value.data(), it->second.value.size());
+    value[it->second.value.size()] = '\0';
+    return it->second.value.size() + 1;
+}
+
+/**
+ * Path without a trailing slash
+ */
+static std::string normalPath(const char* path) {
+    std::string result = path ? path : "";
+    if (result.empty() || result[0] != '/') {
+        result.insert(result.begin(), '/');
+    }
+    while (result.size() > 1 && result.back() == '/') {
+        result.pop_back();
+    }
+    return result;
+}
+
+/**
+ * Directory part of a path
+ */
+static std::string parentPath(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+/**
+ * Open handle on a file or directory
+ */
+File::File(std::shared_ptr<HalFileNode> node, const std::string& path, bool writable, bool append)
+    : node(node), filePath(path), writable(writable) {
+    if (!node) {
+        // Directory: snapshot the entries directly below it
+        directory = true;
+        std::string prefix = path == "/" ? "/" : path + "/";
+        for (const auto& file : files) {
+            if (file.first.compare(0, prefix.size(), prefix) == 0 &&
+                file.first.find('/', prefix.size()) == std::string::npos) {
+                entries.push_back(file.first);
+            }
+        }
+    } else if (append) {
+        pos = node->data.size();
+    }
+}
+
+/**
+ * Write at the current position
+ */
+size_t File::write(const uint8_t* buffer, size_t size) {
+    if (!node || !writable) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    if (node->data.size() < pos + size) {
+        node->data.resize(pos + size);
+    }
+    memcpy(node->data.data() + pos, buffer, size);
+    pos += size;
+    return size;
+}
+
+/**
+ * Read one byte
+ */
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+/**
+ * Read from the current position
+ */
+size_t File::read(uint8_t* buffer, size_t size) {
+    if (!node) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    size_t count = pos < node->data.size() ? node->data.size() - pos : 0;
+    if (count > size) {
+        count = size;
+    }
+    memcpy(buffer, node->data.data() + pos, count);
+    pos += count;
+    return count;
+}
+
+/**
+ * Bytes left to read
+ */
+int File::available() {
+    if (!node) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    return pos < node->data.size() ? (int)(node->data.size() - pos) : 0;
+}
+
+/**
+ * File size
+ */
+size_t File::size() {
+    if (!node) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(storageLock);
+    return node->data.size();
+}
+
+/**
+ * Move the position
+ */
+bool File::seek(uint32_t position) {
+    if (!node || position > size()) {
+        return false;
+    }
+    pos = position;
+    return true;
+}
+
+/**
+ * Close the handle
+ */
+void File::close() {
+    node.reset();
+    directory = false;
+    entries.clear();
+}
+
+/**
+ * File name without the directory
+ */
+const char* File::name() const {
+    size_t slash = filePath.rfind('/');
+    return filePath.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+/**
+ * Whether the handle is a directory
+ */
+bool File::isDirectory() const {
+    return directory;
+}
+
+/**
+ * Next entry of a directory
+ */
+File File::openNextFile() {
+    if (!directory || nextEntry >= entries.size()) {
+        return File();
+    }
+    return LittleFS.open(entries[nextEntry++].c_str(), "r");
+}
+
+/**
+ * Mount (always succeeds)
+ */
+bool LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    return true;
+}
+
+/**
+ * Erase everything
+ */
+bool LittleFSFS::format() {
+    std::lock_guard<std::mutex> guard(storageLock);
+    files.clear();
+    directories = {"/"};
+    return true;
+}
+
+/**
+ * Open a file ("r", "w", "a", "r+", "w+", "a+") or a directory
+ */
+File LittleFSFS::open(const char* path, const char* mode, bool create) {
+    std::string name = normalPath(path);
+    bool write = mode && (mode[0] == 'w' || mode[0] == 'a' || strchr(mode, '+'));
+    bool append = mode && mode[0] == 'a';
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    if (directories.count(name)) {
+        return write ? File() : File(nullptr, name, false, false);
+    }
+    auto it = files.find(name);
+    if (it == files.end()) {
+        if (!mode || mode[0] == 'r' || !directories.count(parentPath(name))) {
+            return File();
+        }
+        it = files.emplace(name, std::make_shared<HalFileNode>()).first;
+    } else if (mode && mode[0] == 'w') {
+        it->second->data.clear();
+    }
+    return File(it->second, name, write, append);
+}
+
+/**
+ * Check whether a file or directory exists
+ */
+bool LittleFSFS::exists(const char* path) {
+    std::string name = normalPath(path);
+    std::lock_guard<std::mutex> guard(storageLock);
+    return files.count(name) > 0 || directories.count(name) > 0;
+}
+
+/**
+ * Delete a file
+ */
+bool LittleFSFS::remove(const char* path) {
+    std::lock_guard<std::mutex> guard(storageLock);
+    return files.erase(normalPath(path)) > 0;
+}
+
+/**
+ * Rename a file
+ */
+bool LittleFSFS::rename(const char* from, const char* to) {
+    std::string source = normalPath(from);
+    std::string target = normalPath(to);
+    std::lock_guard<std::mutex> guard(storageLock);
+    auto it = files.find(source);
+    if (it == files.end() || !directories.count(parentPath(target)) || directories.count(target)) {
+        return false;
+    }
+    std::shared_ptr<HalFileNode> node = it->second;
+    files.erase(it);
+    files[target] = node;
+    return true;
+}
+
+/**
+ * Create a directory
+ */
+bool LittleFSFS::mkdir(const char* path) {
+    std::string name = normalPath(path);
+    std::lock_guard<std::mutex> guard(storageLock);
+    if (files.count(name) || !directories.count(parentPath(name))) {
+        return false;
+    }
+    directories.insert(name);
+    return true;
+}
+
+/**
+ * Remove an empty directory
+ */
+bool LittleFSFS::rmdir(const char* path) {
+    std::string name = normalPath(path);
+    std::string prefix = name + "/";
+    std::lock_guard<std::mutex> guard(storageLock);
+    for (const auto& file : files) {
+        if (file.first.compare(0, prefix.size(), prefix) == 0) {
+            return false;
+        }
+    }
+    return name != "/" && directories.erase(name) > 0;
+}
+
+/**
+ * Size of the simulated partition
+ */
+size_t LittleFSFS::totalBytes() {
+    return 1024 * 1024;
+}
+
+/**
+ * Bytes used by file contents
+ */
+size_t LittleFSFS::usedBytes() {
+    std::lock_guard<std::mutex> guard(storageLock);
+    size_t used = 0;
+    for (const auto& file : files) {
+        used += file.second->data.size();
+    }
+    return used;
+}
@@ -0,0 +1,90 @@
+#include "rs485_bus.h"
+
+/**
+ * Create an idle bus
+ */
+VirtualBus::VirtualBus(uint32_t baud, uint8_t sources)
+    : charNs(BUS_BITS_PER_CHAR * 1000000000ull / baud),
+      sourceCount(sources < BUS_MAX_SOURCES ? sources : BUS_MAX_SOURCES) {
+    for (uint8_t i = 0; i < BUS_MAX_SOURCES; i++) {
+        sourceBusyUntil[i] = 0;
+    }
+}
+
+/**
+ * Hand bytes to a transmitter
+ */
+void VirtualBus::transmit(uint8_t source, const uint8_t* data, size_t length, uint64_t nowNs) {
+    if (source >= sourceCount) {
+        return;
+    }
+    for (size_t i = 0; i < length; i++) {
+        BusByte byte;
+        byte.startNs = nowNs > sourceBusyUntil[source] ? nowNs : sourceBusyUntil[source];
+        byte.endNs = byte.startNs + charNs;
+        byte.value = data[i];
+        byte.source = source;
+        byte.collided = false;
+        sourceBusyUntil[source] = byte.endNs;
+
+        // Anything already scheduled by another transmitter in this window collides.
+        // Delivered bytes ended before now, so they can never overlap a new one.
+        for (BusByte& other : pending) {
+            if (other.source != source && other.startNs < byte.endNs && byte.startNs < other.endNs) {
+                if (!other.collided) {
+                    counters.corruptedBytes++;
+                }
+                if (!byte.collided) {
+                    counters.corruptedBytes++;
+                }
+                other.collided = true;
+                byte.collided = true;
+                other.value &= data[i];
+                byte.value &= other.value;
+                counters.collisions++;
+            }
+        }
+
+        if (byte.startNs >= lineBusyUntil) {
+            counters.busyNs += charNs;
+        } else if (byte.endNs > lineBusyUntil) {
+            counters.busyNs += byte.endNs - lineBusyUntil;
+        }
+        if (byte.endNs > lineBusyUntil) {
+            lineBusyUntil = byte.endNs;
+        }
+        counters.bytes++;
+        pending.push_back(byte);
+    }
+}
+
+/**
+ * Take the next byte whose character time has ended
+ */
+bool VirtualBus::takeDelivered(uint64_t nowNs, BusByte* out) {
+    size_t next = pending.size();
+    for (size_t i = 0; i < pending.size(); i++) {
+        if (pending[i].endNs <= nowNs && (next == pending.size() || pending[i].endNs < pending[next].endNs)) {
+            next = i;
+        }
+    }
+    if (next == pending.size()) {
+        return false;
+    }
+    *out = pending[next];
+    pending.erase(pending.begin() + next);
+    return true;
+}
+
+/**
+ * Time the next byte finishes
+ */
+uint64_t VirtualBus::nextDeliveryNs() const {
+    uint64_t next = UINT64_MAX;
+    for (const BusByte& byte : pending) {
+        if (byte.endNs < next) {
+            next = byte.endNs;
+        }
+    }
+    return next;
+}
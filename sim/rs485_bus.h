@@ -0,0 +1,97 @@
+#ifndef RS485_BUS_H
+#define RS485_BUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Virtual RS-485 Bus
+// Timing model of a shared half-duplex line for the bus simulator.
+// Each byte holds the line for one character time (start, 8 data, parity
+// and stop bit at the configured baud rate). Bytes from one transmitter are
+// serialized behind each other like a UART shift register; a byte handed
+// over while the transmitter is idle starts at once.
+//
+// Bytes from different transmitters that overlap in time collide. The
+// level on a contended differential pair is undefined; as a deterministic
+// stand-in every collided byte is delivered as the AND of all bytes on the
+// line with it, so receivers see corrupted data rather than nothing.
+// A transmitter never receives its own bytes (RE tied to DE).
+
+#define BUS_BITS_PER_CHAR 11      // 8E1: start + 8 data + parity + stop
+#define BUS_MAX_SOURCES 40
+
+// A byte on the line
+struct BusByte {
+    uint64_t startNs;
+    uint64_t endNs;               // Delivered to receivers at this time
+    uint8_t value;                // Value seen by receivers
+    uint8_t source;               // Transmitter index
+    bool collided;
+};
+
+// Line counters
+struct BusStats {
+    uint64_t bytes;               // Bytes put on the line
+    uint64_t collisions;          // Overlapping byte pairs from different transmitters
+    uint64_t corruptedBytes;      // Bytes delivered with a collision
+    uint64_t busyNs;              // Time the line carried at least one byte
+};
+
+class VirtualBus {
+public:
+    /**
+     * @param baud Line baud rate
+     * @param sources Number of transmitters (at most BUS_MAX_SOURCES)
+     */
+    VirtualBus(uint32_t baud, uint8_t sources);
+
+    /**
+     * Hand bytes to a transmitter
+     * @param source Transmitter index
+     * @param data Bytes to send
+     * @param length Byte count
+     * @param nowNs Current time
+     */
+    void transmit(uint8_t source, const uint8_t* data, size_t length, uint64_t nowNs);
+
+    /**
+     * Take the next byte whose character time has ended
+     * Bytes come out in the order they finish on the line.
+     * @param nowNs Current time
+     * @param out Receives the byte
+     * @return false if no byte is due yet
+     */
+    bool takeDelivered(uint64_t nowNs, BusByte* out);
+
+    /**
+     * Time the next byte finishes
+     * @return End time in ns, or UINT64_MAX if the line is idle
+     */
+    uint64_t nextDeliveryNs() const;
+
+    /**
+     * Check whether any transmitter still has bytes on or queued for the line
+     */
+    bool isIdle() const { return pending.empty(); }
+
+    /**
+     * Duration of one character
+     */
+    uint64_t charTimeNs() const { return charNs; }
+
+    /**
+     * Line counters
+     */
+    const BusStats& stats() const { return counters; }
+
+private:
+    uint64_t charNs;
+    uint8_t sourceCount;
+    uint64_t sourceBusyUntil[BUS_MAX_SOURCES];
+    uint64_t lineBusyUntil = 0;
+    std::vector<BusByte> pending; // Not yet delivered, in insertion order
+    BusStats counters = {};
+};
+
+#endif // RS485_BUS_H
@@ -0,0 +1,608 @@
+// RS-485 Bus Simulator
+// Runs N copies of the RS-485 node firmware (rs485_serial, the command
+// handler and the channel state behind it) as forked processes, each with its
+// own jumper ID, on one virtual half-duplex bus (rs485_bus.h) that models
+// character timing and collisions. The bus is also exposed as a pty, so a
+// host application can act as master or just watch the traffic.
+//
+// A built-in master can load the bus and measure it:
+//   unicast    poll every node in turn with one frame
+//   broadcast  one frame to 0xFF, wait for every node's slotted reply
+//   pipeline   several frames back to back to one node, then wait
+//   none       no built-in master (pty only)
+// A poll ends when every addressed node has replied and the line has been
+// quiet for QUIET_CHARS character times, or at the timeout. Latency is from
+// the end of the request to the end of the last reply byte.
+//
+// Everything runs in real time on the host clock. Node processes are
+// scheduled by the host, so with many nodes on few cores a few milliseconds
+// of jitter shows up in the latencies and can push a slotted reply into its
+// neighbour's slot; compare runs made on the same machine.
+//
+// Build and run (Linux):
+//   pio run -e bus_sim && .pio/build/bus_sim/program -n 32 -m broadcast -t 20
+// Options:
+//   -n nodes       node count, IDs 0..n-1 (1-32, default 8)
+//   -I id,id,...   explicit node IDs instead of -n (duplicates allowed)
+//   -b baud        line baud rate (default RS485_BAUDRATE)
+//   -m mode        unicast | broadcast | pipeline | none (default unicast)
+//   -c opcode      request opcode, decimal or 0x hex (default CMD_PING)
+//   -p hex         request payload, e.g. 01F4
+//   -d depth       frames per pipelined poll (default 4)
+//   -T ms          reply timeout (default 100; broadcast adds the slot sweep)
+//   -t seconds     run time (default 10)
+//   -o file        also write the report as JSON
+
+#include <Arduino.h>
+#include <HardwareSerial.h>
+#include <hal_sim.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <chrono>
+#include "rs485_bus.h"
+#include "rs485_serial.h"
+#include "rs485_command_handler.h"
+#include "device_id.h"
+#include "relay_controller.h"
+#include "dac_controller.h"
+#include "sine_wave_generator.h"
+#include "setpoint_stream.h"
+
+extern HardwareSerial RS485Serial;
+
+#define SIM_MAX_NODES 32
+#define QUIET_CHARS 4                   // Idle line after the last reply that ends a poll
+#define QUIET_MIN_US 2000               // Floor for host scheduling jitter
+#define NODE_POLL_MS 1                  // Node wake-up period, opens slotted replies on time
+
+enum MasterMode {
+    MASTER_UNICAST,
+    MASTER_BROADCAST,
+    MASTER_PIPELINE,
+    MASTER_NONE
+};
+
+// Simulation settings
+struct SimConfig {
+    uint8_t nodeCount = 8;
+    uint8_t nodeIDs[SIM_MAX_NODES];
+    uint32_t baud = RS485_BAUDRATE;
+    MasterMode mode = MASTER_UNICAST;
+    uint8_t opcode = CMD_PING;
+    uint8_t payload[RS485_MAX_COMMAND_LENGTH - 2];
+    uint8_t payloadLength = 0;
+    uint8_t depth = 4;
+    uint32_t timeoutMs = 100;
+    uint32_t durationS = 10;
+    const char* jsonPath = nullptr;
+};
+
+// Built-in master state
+struct MasterState {
+    bool waiting = false;               // Request sent, poll not finished
+    uint16_t bytesOnLine = 0;           // Request bytes not yet delivered
+    uint64_t requestEndNs = 0;          // 0 until the last request byte is delivered
+    uint64_t lastReplyEndNs = 0;
+    uint32_t expectedMask = 0;          // Bit n = node ID n must reply
+    uint32_t repliedMask = 0;
+    uint8_t nextTarget = 0;             // Index into nodeIDs
+    uint8_t frame[RS485_BUFFER_SIZE];   // Reply frame being assembled
+    uint8_t frameLength = 0;
+    bool frameCollided = false;
+
+    // Results
+    uint32_t polls = 0;
+    uint32_t completed = 0;
+    uint32_t timeouts = 0;
+    uint32_t missingReplies = 0;        // Addressed nodes that did not answer a timed-out poll
+    uint32_t replyFrames = 0;
+    uint32_t badFrames = 0;             // Frames hit by a collision
+    std::vector<uint32_t> latencyUs;
+};
+
+static volatile sig_atomic_t stopRequested = 0;
+static const std::chrono::steady_clock::time_point simStart = std::chrono::steady_clock::now();
+
+/**
+ * Nanoseconds since the simulator started
+ */
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - simStart).count();
+}
+
+/**
+ * Stop on Ctrl-C and still print the report
+ */
+static void onSignal(int) {
+    stopRequested = 1;
+}
+
+/**
+ * Write a whole buffer to a blocking descriptor
+ */
+static void writeAll(int fd, const uint8_t* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return;
+        }
+        data += n;
+        length -= n;
+    }
+}
+
+/**
+ * Node process: the RS-485 firmware path on one end of a socket
+ * Bytes from the socket are what this node's receiver sees on the line;
+ * everything the firmware transmits goes back over the socket.
+ */
+static void runNode(uint8_t id, int busFd) {
+    signal(SIGINT, SIG_IGN); // The simulator stops the nodes by closing the bus
+    Serial.simSetTxHandler([](const uint8_t*, size_t) {});
+
+    // Jumpers: a grounded pin is a 1 bit
+    static const uint8_t idPins[] = {NO1, NO2, NO3, NO4, NO5};
+    for (uint8_t bit = 0; bit < 5; bit++) {
+        halSetPinInput(idPins[bit], (id & (1 << bit)) ? LOW : HIGH);
+    }
+
+    // Channel state; without the output engine task output calls run inline
+    initRelayController();
+    initDACControllers();
+    initSineWaveGenerator();
+    initSetpointStream();
+    initRS485Serial();
+    initRS485CommandHandler();
+    RS485Serial.simSetTxHandler([busFd](const uint8_t* data, size_t length) { writeAll(busFd, data, length); });
+
+    uint8_t buffer[256];
+    for (;;) {
+        pollfd fd = {busFd, POLLIN, 0};
+        if (poll(&fd, 1, NODE_POLL_MS) > 0) {
+            ssize_t n = read(busFd, buffer, sizeof(buffer));
+            if (n <= 0) {
+                break; // Simulator closed the bus
+            }
+            RS485Serial.simReceive(buffer, n);
+        }
+        handleRS485Commands();
+    }
+    _exit(0);
+}
+
+/**
+ * Open the pty that mirrors the bus
+ * The slave end is kept open so the line stays up between client sessions.
+ * @return Master descriptor, or -1
+ */
+static int openBusPty(int* slaveFd) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("pty");
+        return -1;
+    }
+    *slaveFd = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (*slaveFd < 0) {
+        perror("pty slave");
+        close(master);
+        return -1;
+    }
+    termios tio;
+    tcgetattr(*slaveFd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(*slaveFd, TCSANOW, &tio);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    return master;
+}
+
+/**
+ * Bit mask of node IDs
+ */
+static uint32_t idMask(const SimConfig& config) {
+    uint32_t mask = 0;
+    for (uint8_t i = 0; i < config.nodeCount; i++) {
+        mask |= 1u << config.nodeIDs[i];
+    }
+    return mask;
+}
+
+/**
+ * Start the next poll
+ */
+static void startPoll(const SimConfig& config, MasterState& master, VirtualBus& bus, uint8_t source, uint64_t now) {
+    uint8_t target = RS485_BROADCAST_ID;
+    uint8_t frames = 1;
+    if (config.mode == MASTER_BROADCAST) {
+        master.expectedMask = idMask(config);
+    } else {
+        target = config.nodeIDs[master.nextTarget];
+        master.nextTarget = (master.nextTarget + 1) % config.nodeCount;
+        master.expectedMask = 1u << target;
+        if (config.mode == MASTER_PIPELINE) {
+            frames = config.depth;
+        }
+    }
+
+    uint8_t request[RS485_BUFFER_SIZE * 8];
+    uint16_t length = 0;
+    for (uint8_t f = 0; f < frames; f++) {
+        request[length++] = 0xAA;
+        request[length++] = target;
+        request[length++] = config.opcode;
+        memcpy(&request[length], config.payload, config.payloadLength);
+        length += config.payloadLength;
+        request[length++] = 0x55;
+    }
+    bus.transmit(source, request, length, now);
+
+    master.waiting = true;
+    master.bytesOnLine = length;
+    master.requestEndNs = 0;
+    master.lastReplyEndNs = 0;
+    master.repliedMask = 0;
+    master.frameLength = 0;
+    master.polls++;
+}
+
+/**
+ * Feed the master one byte delivered on the line
+ */
+static void masterObserve(MasterState& master, uint8_t masterSource, const BusByte& byte) {
+    if (byte.source == masterSource) {
+        if (master.bytesOnLine > 0 && --master.bytesOnLine == 0) {
+            master.requestEndNs = byte.endNs;
+        }
+        return;
+    }
+    if (!master.waiting) {
+        return;
+    }
+
+    // Reply frames: [0xAA][ID][CMD][DATA...][0x55]
+    master.lastReplyEndNs = byte.endNs;
+    if (byte.value == 0xAA && !byte.collided) {
+        master.frameLength = 0;
+        master.frameCollided = false;
+    } else if (master.frameLength == 0) {
+        return; // Not inside a frame
+    }
+    if (master.frameLength < sizeof(master.frame)) {
+        master.frame[master.frameLength++] = byte.value;
+    }
+    master.frameCollided |= byte.collided;
+    if (byte.value == 0x55 && master.frameLength >= 4) {
+        if (master.frameCollided) {
+            master.badFrames++;
+        } else {
+            master.replyFrames++;
+            if (master.frame[1] < SIM_MAX_NODES) {
+                master.repliedMask |= 1u << master.frame[1];
+            }
+        }
+        master.frameLength = 0;
+    }
+}
+
+/**
+ * Finish the current poll when it is answered or timed out
+ */
+static void masterCheck(const SimConfig& config, MasterState& master, VirtualBus& bus, uint64_t now) {
+    if (!master.waiting || master.requestEndNs == 0) {
+        return;
+    }
+    uint64_t quietNs = std::max<uint64_t>(QUIET_CHARS * bus.charTimeNs(), QUIET_MIN_US * 1000ull);
+    uint64_t timeoutNs = config.timeoutMs * 1000000ull;
+    if (config.mode == MASTER_BROADCAST) {
+        timeoutNs += (uint64_t)SIM_MAX_NODES * RS485_REPLY_SLOT_US * 1000;
+    }
+
+    bool answered = (master.repliedMask & master.expectedMask) == master.expectedMask;
+    if (answered && bus.isIdle() && now - master.lastReplyEndNs >= quietNs) {
+        master.completed++;
+        master.latencyUs.push_back((uint32_t)((master.lastReplyEndNs - master.requestEndNs) / 1000));
+        master.waiting = false;
+    } else if (now - master.requestEndNs >= timeoutNs) {
+        master.timeouts++;
+        master.missingReplies += __builtin_popcount(master.expectedMask & ~master.repliedMask);
+        master.waiting = false;
+    }
+}
+
+/**
+ * Latency percentile in microseconds
+ */
+static uint32_t percentileUs(const std::vector<uint32_t>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+/**
+ * Print the report, and write it as JSON if asked
+ */
+static void report(const SimConfig& config, MasterState& master, const VirtualBus& bus, uint64_t elapsedNs) {
+    static const char* modeNames[] = {"unicast", "broadcast", "pipeline", "none"};
+    std::sort(master.latencyUs.begin(), master.latencyUs.end());
+    double seconds = elapsedNs / 1e9;
+    const BusStats& line = bus.stats();
+    uint32_t p50 = percentileUs(master.latencyUs, 0.50);
+    uint32_t p90 = percentileUs(master.latencyUs, 0.90);
+    uint32_t p99 = percentileUs(master.latencyUs, 0.99);
+    uint32_t max = master.latencyUs.empty() ? 0 : master.latencyUs.back();
+
+    printf("\n=== RS-485 bus simulation: %u nodes, %lu baud, %s, opcode 0x%02X, %.1f s ===\n",
+           config.nodeCount, (unsigned long)config.baud, modeNames[config.mode], config.opcode, seconds);
+    printf("Polls: %lu sent, %lu completed (%.1f/s), %lu timed out, %lu missing replies\n",
+           (unsigned long)master.polls, (unsigned long)master.completed, master.completed / seconds,
+           (unsigned long)master.timeouts, (unsigned long)master.missingReplies);
+    printf("Reply frames: %lu good (%.1f/s), %lu bad\n", (unsigned long)master.replyFrames,
+           master.replyFrames / seconds, (unsigned long)master.badFrames);
+    printf("Latency us: p50 %lu, p90 %lu, p99 %lu, max %lu\n", (unsigned long)p50, (unsigned long)p90,
+           (unsigned long)p99, (unsigned long)max);
+    printf("Line: %llu bytes, %.1f%% busy, %llu collisions, %llu corrupted bytes\n",
+           (unsigned long long)line.bytes, 100.0 * line.busyNs / elapsedNs,
+           (unsigned long long)line.collisions, (unsigned long long)line.corruptedBytes);
+
+    if (!config.jsonPath) {
+        return;
+    }
+    FILE* file = fopen(config.jsonPath, "w");
+    if (!file) {
+        perror(config.jsonPath);
+        return;
+    }
+    fprintf(file, "{\n  \"nodes\": %u,\n  \"baud\": %lu,\n  \"mode\": \"%s\",\n  \"opcode\": %u,\n  \"seconds\": %.3f,\n",
+            config.nodeCount, (unsigned long)config.baud, modeNames[config.mode], config.opcode, seconds);
+    fprintf(file, "  \"polls\": %lu,\n  \"completed\": %lu,\n  \"polls_per_s\": %.3f,\n  \"timeouts\": %lu,\n",
+            (unsigned long)master.polls, (unsigned long)master.completed, master.completed / seconds,
+            (unsigned long)master.timeouts);
+    fprintf(file, "  \"missing_replies\": %lu,\n  \"reply_frames\": %lu,\n  \"bad_frames\": %lu,\n",
+            (unsigned long)master.missingReplies, (unsigned long)master.replyFrames, (unsigned long)master.badFrames);
+    fprintf(file, "  \"latency_us\": {\"p50\": %lu, \"p90\": %lu, \"p99\": %lu, \"max\": %lu},\n",
+            (unsigned long)p50, (unsigned long)p90, (unsigned long)p99, (unsigned long)max);
+    fprintf(file, "  \"line_bytes\": %llu,\n  \"line_busy\": %.4f,\n  \"collisions\": %llu,\n  \"corrupted_bytes\": %llu\n}\n",
+            (unsigned long long)line.bytes, (double)line.busyNs / elapsedNs,
+            (unsigned long long)line.collisions, (unsigned long long)line.corruptedBytes);
+    fclose(file);
+}
+
+/**
+ * Parse a comma-separated ID list
+ */
+static bool parseIDList(const char* text, SimConfig& config) {
+    config.nodeCount = 0;
+    while (*text) {
+        char* end;
+        long id = strtol(text, &end, 0);
+        if (end == text || id < 0 || id >= SIM_MAX_NODES || config.nodeCount >= SIM_MAX_NODES) {
+            return false;
+        }
+        config.nodeIDs[config.nodeCount++] = (uint8_t)id;
+        text = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',') {
+            return false;
+        }
+    }
+    return config.nodeCount > 0;
+}
+
+/**
+ * Parse a hex payload
+ */
+static bool parsePayload(const char* text, SimConfig& config) {
+    size_t digits = strlen(text);
+    if (digits % 2 || digits / 2 > sizeof(config.payload)) {
+        return false;
+    }
+    for (size_t i = 0; i < digits / 2; i++) {
+        char pair[3] = {text[i * 2], text[i * 2 + 1], '\0'};
+        char* end;
+        config.payload[i] = (uint8_t)strtoul(pair, &end, 16);
+        if (*end) {
+            return false;
+        }
+    }
+    config.payloadLength = digits / 2;
+    return true;
+}
+
+/**
+ * Parse the command line
+ */
+static bool parseArguments(int argc, char** argv, SimConfig& config) {
+    bool explicitIDs = false;
+    int option;
+    while ((option = getopt(argc, argv, "n:I:b:m:c:p:d:T:t:o:")) != -1) {
+        switch (option) {
+            case 'n': config.nodeCount = atoi(optarg); break;
+            case 'I':
+                if (!parseIDList(optarg, config)) {
+                    return false;
+                }
+                explicitIDs = true;
+                break;
+            case 'b': config.baud = strtoul(optarg, nullptr, 0); break;
+            case 'm':
+                if (strcmp(optarg, "unicast") == 0) config.mode = MASTER_UNICAST;
+                else if (strcmp(optarg, "broadcast") == 0) config.mode = MASTER_BROADCAST;
+                else if (strcmp(optarg, "pipeline") == 0) config.mode = MASTER_PIPELINE;
+                else if (strcmp(optarg, "none") == 0) config.mode = MASTER_NONE;
+                else return false;
+                break;
+            case 'c': config.opcode = strtoul(optarg, nullptr, 0) & 0xFF; break;
+            case 'p':
+                if (!parsePayload(optarg, config)) {
+                    return false;
+                }
+                break;
+            case 'd': config.depth = atoi(optarg); break;
+            case 'T': config.timeoutMs = strtoul(optarg, nullptr, 0); break;
+            case 't': config.durationS = strtoul(optarg, nullptr, 0); break;
+            case 'o': config.jsonPath = optarg; break;
+            default: return false;
+        }
+    }
+    if (!explicitIDs) {
+        if (config.nodeCount < 1 || config.nodeCount > SIM_MAX_NODES) {
+            return false;
+        }
+        for (uint8_t i = 0; i < config.nodeCount; i++) {
+            config.nodeIDs[i] = i;
+        }
+    }
+    return config.baud > 0 && config.depth >= 1 && config.depth <= 8 && config.durationS > 0;
+}
+
+int main(int argc, char** argv) {
+    SimConfig config;
+    if (!parseArguments(argc, argv, config)) {
+        fprintf(stderr, "usage: %s [-n nodes | -I id,id,...] [-b baud] [-m unicast|broadcast|pipeline|none]\n"
+                        "          [-c opcode] [-p hexpayload] [-d depth] [-T timeout_ms] [-t seconds] [-o json]\n",
+                argv[0]);
+        return 2;
+    }
+
+    // Transmitters: nodes first, then the built-in master, then the pty
+    const uint8_t masterSource = config.nodeCount;
+    const uint8_t ptySource = config.nodeCount + 1;
+    int nodeFds[SIM_MAX_NODES];
+    pid_t nodePids[SIM_MAX_NODES];
+    int pairs[SIM_MAX_NODES][2];
+    for (uint8_t i = 0; i < config.nodeCount; i++) {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, pairs[i]) != 0) {
+            perror("socketpair");
+            return 1;
+        }
+    }
+    for (uint8_t i = 0; i < config.nodeCount; i++) {
+        nodePids[i] = fork();
+        if (nodePids[i] == 0) {
+            for (uint8_t j = 0; j < config.nodeCount; j++) {
+                close(pairs[j][0]);
+                if (j != i) {
+                    close(pairs[j][1]);
+                }
+            }
+            runNode(config.nodeIDs[i], pairs[i][1]);
+        }
+        close(pairs[i][1]);
+        nodeFds[i] = pairs[i][0];
+    }
+
+    int ptySlave = -1;
+    int ptyFd = openBusPty(&ptySlave);
+    if (ptyFd >= 0) {
+        printf("Bus pty: %s\n", ptsname(ptyFd));
+    }
+    printf("Nodes:");
+    for (uint8_t i = 0; i < config.nodeCount; i++) {
+        printf(" %u", config.nodeIDs[i]);
+    }
+    printf("\n");
+    fflush(stdout);
+
+    signal(SIGINT, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+    VirtualBus bus(config.baud, config.nodeCount + 2);
+    MasterState master;
+
+    // Let the nodes finish booting before the first request
+    usleep(200000);
+    uint64_t startNs = nowNs();
+    uint64_t endNs = startNs + config.durationS * 1000000000ull;
+    uint8_t buffer[512];
+    std::vector<uint8_t> outbox[SIM_MAX_NODES + 1]; // Per node, then the pty
+
+    while (!stopRequested) {
+        uint64_t now = nowNs();
+        if (now >= endNs) {
+            break;
+        }
+        if (config.mode != MASTER_NONE && !master.waiting) {
+            startPoll(config, master, bus, masterSource, now);
+        }
+
+        // Sleep until the next byte ends on the line or a descriptor is readable
+        pollfd fds[SIM_MAX_NODES + 1];
+        uint8_t fdCount = 0;
+        for (uint8_t i = 0; i < config.nodeCount; i++) {
+            fds[fdCount++] = {nodeFds[i], POLLIN, 0};
+        }
+        if (ptyFd >= 0) {
+            fds[fdCount++] = {ptyFd, POLLIN, 0};
+        }
+        uint64_t wakeNs = std::min<uint64_t>(bus.nextDeliveryNs(), now + 1000000);
+        uint64_t waitNs = wakeNs > now ? wakeNs - now : 0;
+        timespec timeout = {(time_t)(waitNs / 1000000000ull), (long)(waitNs % 1000000000ull)};
+        ppoll(fds, fdCount, &timeout, nullptr);
+
+        // Bytes handed to transmitters
+        now = nowNs();
+        for (uint8_t i = 0; i < fdCount; i++) {
+            if (!(fds[i].revents & POLLIN)) {
+                continue;
+            }
+            ssize_t n = read(fds[i].fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                bus.transmit(i < config.nodeCount ? i : ptySource, buffer, n, now);
+            }
+        }
+
+        // Bytes whose character time has ended reach every other receiver
+        BusByte byte;
+        while (bus.takeDelivered(now, &byte)) {
+            for (uint8_t i = 0; i < config.nodeCount; i++) {
+                if (byte.source != i) {
+                    outbox[i].push_back(byte.value);
+                }
+            }
+            if (byte.source != ptySource) {
+                outbox[config.nodeCount].push_back(byte.value);
+            }
+            masterObserve(master, masterSource, byte);
+        }
+        for (uint8_t i = 0; i < config.nodeCount; i++) {
+            if (!outbox[i].empty()) {
+                writeAll(nodeFds[i], outbox[i].data(), outbox[i].size());
+                outbox[i].clear();
+            }
+        }
+        if (!outbox[config.nodeCount].empty()) {
+            if (ptyFd >= 0 && write(ptyFd, outbox[config.nodeCount].data(), outbox[config.nodeCount].size()) < 0) {
+                // No client draining the pty: drop, the bus itself is unaffected
+            }
+            outbox[config.nodeCount].clear();
+        }
+
+        masterCheck(config, master, bus, now);
+    }
+
+    report(config, master, bus, nowNs() - startNs);
+
+    for (uint8_t i = 0; i < config.nodeCount; i++) {
+        close(nodeFds[i]);
+    }
+    for (uint8_t i = 0; i < config.nodeCount; i++) {
+        waitpid(nodePids[i], nullptr, 0);
+    }
+    if (ptyFd >= 0) {
+        close(ptySlave);
+        close(ptyFd);
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "change_notify.h"
+#include <atomic>
+#include "command_handler.h"
+#include "relay_controller.h"
+#include "sine_wave_generator.h"
+#include "telemetry.h"
+
+extern char signalModes[3];
+
+static std::atomic<uint8_t> dirtyMask(0);
+static uint8_t subscribedMask = 0;            // 0 = not subscribed
+static uint32_t heartbeatMs = 0;
+static uint32_t lastNotifyMs = 0;
+static uint8_t sequence = 0;
+static uint32_t notificationsSent = 0;
+static uint32_t heartbeatsSent = 0;
+
+/**
+ * Record that part of the reported state changed
+ */
+void markStateChanged(uint8_t bits) {
+    dirtyMask.fetch_or(bits, std::memory_order_relaxed);
+}
+
+/**
+ * Mark a signal's mode or setpoint as changed
+ */
+void markSignalChanged(uint8_t sig) {
+    if (sig >= 1 && sig <= 3) {
+        markStateChanged(CHANGE_SIG1 << (sig - 1));
+    }
+}
+
+/**
+ * Subscribe to change notifications
+ */
+void subscribeChanges(uint8_t mask, uint8_t heartbeatS) {
+    subscribedMask = mask & CHANGE_ALL;
+    heartbeatMs = (uint32_t)heartbeatS * 1000;
+    lastNotifyMs = millis();
+    markStateChanged(subscribedMask);
+}
+
+/**
+ * Build the notification for a poll, if one is due
+ */
+uint8_t buildChangeNotification(uint8_t* out) {
+    if (subscribedMask == 0) {
+        return 0;
+    }
+
+    uint32_t now = millis();
+    uint8_t changed = dirtyMask.fetch_and(~subscribedMask, std::memory_order_relaxed) & subscribedMask;
+    if (changed == 0 && (heartbeatMs == 0 || now - lastNotifyMs < heartbeatMs)) {
+        return 0;
+    }
+
+    // Bits are cleared before the fields are read, so a change racing with
+    // this poll is either included now or reported again next time
+    uint8_t length = 0;
+    out[length++] = sequence++;
+    out[length++] = changed;
+    for (uint8_t sig = 1; sig <= 3; sig++) {
+        if (changed & (CHANGE_SIG1 << (sig - 1))) {
+            uint16_t value = (uint16_t)(getSignalValue(sig) * 100 + 0.5f);
+            out[length++] = signalModes[sig - 1];
+            out[length++] = (value >> 8) & 0xFF;
+            out[length++] = value & 0xFF;
+        }
+    }
+    if (changed & CHANGE_RELAYS) {
+        uint8_t relays = 0;
+        for (uint8_t relay = 1; relay <= 6; relay++) {
+            if (getRelayState(relay)) {
+                relays |= 1 << (relay - 1);
+            }
+        }
+        out[length++] = relays;
+    }
+    if (changed & CHANGE_WAVE) {
+        uint16_t period = (uint16_t)(getSineWavePeriod() * 10 + 0.5f);
+        out[length++] = isSineWaveActive() ? TELEMETRY_WAVE_ACTIVE : 0;
+        out[length++] = getSineWaveMode();
+        out[length++] = (period >> 8) & 0xFF;
+        out[length++] = period & 0xFF;
+    }
+
+    lastNotifyMs = now;
+    if (changed) {
+        notificationsSent++;
+    } else {
+        heartbeatsSent++;
+    }
+    return length;
+}
+
+/**
+ * Print subscription state
+ */
+void printChangeNotifyStatus() {
+    if (subscribedMask == 0) {
+        Serial.println("Change notifications: not subscribed");
+    } else {
+        Serial.printf("Change notifications: mask 0x%02X, heartbeat %lus\n", subscribedMask,
+                      (unsigned long)(heartbeatMs / 1000));
+    }
+    Serial.printf("Pending 0x%02X, next seq %u, sent %lu, heartbeats %lu\n",
+                  dirtyMask.load(std::memory_order_relaxed), sequence,
+                  (unsigned long)notificationsSent, (unsigned long)heartbeatsSent);
+}
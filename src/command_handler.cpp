@@ -2,6 +2,10 @@
 #include "dac_controller.h"
 #include "relay_controller.h"
 #include "utils.h"
+#include "output_engine.h"
+#include "debug_log.h"
+#include "change_notify.h"
+#include "text_command.h"
 
 // Global variable declarations
 extern char signalModes[3]; // Signal modes
@@ -13,67 +17,126 @@ SignalMap signalMap[3] = {
     {&gp8413_2, 0, &gp8313_3}  // SIG3
 };
 
-void parseModeCommand(String params) {
-    int commaIndex = params.indexOf(',');
-    if (commaIndex == -1 || params.length() <= commaIndex + 1) {
+void parseModeCommand(char* params) {
+    TextCursor cursor = {params};
+    char* sigText = nextToken(&cursor, ", ");
+    char* modeText = nextToken(&cursor, ", ");
+    int32_t sig;
+    if (!parseTextInt(sigText, &sig) || !modeText) {
         Serial.println("Invalid mode command. Use 'MODE SIG,MODE' (case-insensitive).");
         return;
     }
 
-    int sig = params.substring(0, commaIndex).toInt(); // Get signal number
-    char mode = toLowerCase(params.substring(commaIndex + 1).charAt(0)); // Get mode ('v' or 'c') - case insensitive
+    char mode = toLowerCase(modeText[0]); // Get mode ('v' or 'c') - case insensitive
 
-    if (sig < 1 || sig > 3 || (mode != 'v' && mode != 'c')) {
+    if (sig < 1 || sig > 3 || !setSignalMode(sig, mode)) {
         Serial.println("Invalid mode. Use 'v' or 'c' (case-insensitive).");
+    }
+}
+
+void parseValueCommand(char* params) {
+    TextCursor cursor = {params};
+    int32_t sig;
+    float value;
+    if (!parseTextInt(nextToken(&cursor, ", "), &sig) || !parseTextFloat(nextToken(&cursor, ", "), &value)) {
+        Serial.println("Invalid value command. Use 'VALUE SIG,VALUE' (case-insensitive).");
+        return;
+    }
+
+    if (sig < 1 || sig > 3) {
+        Serial.println("Invalid signal number. Use 1 to 3.");
         return;
     }
 
+    setSignalValue(sig, value);
+}
+
+bool setSignalMode(uint8_t sig, char mode) {
+    if (sig < 1 || sig > 3 || (mode != 'v' && mode != 'c')) {
+        return false;
+    }
+    if (!isOutputEngineContext()) {
+        OutputCommand command = {};
+        command.type = OUT_CMD_SIGNAL_MODE;
+        command.signalMode.sig = sig;
+        command.signalMode.mode = mode;
+        return postOutputCommand(command);
+    }
+
     // Execute protection operation
     if (mode == 'v') {
         signalMap[sig - 1].currentDAC->setDACOutElectricCurrent(0);
-        Serial.printf("SIG%d: Current set to 0mA for protection.\n", sig);
+        LOG_INFO(LOG_CAT_DAC, "SIG%d: Current set to 0mA for protection.", sig);
     } else if (mode == 'c') {
         signalMap[sig - 1].voltageDAC->setVoltage(0.0, signalMap[sig - 1].voltageChannel);
-        Serial.printf("SIG%d: Voltage set to 0V for protection.\n", sig);
+        LOG_INFO(LOG_CAT_DAC, "SIG%d: Voltage set to 0V for protection.", sig);
     }
 
     // Update mode status and set relay
     signalModes[sig - 1] = mode;
     setRelayMode(sig, mode);
-    Serial.printf("Mode set: SIG%d -> %c\n", sig, mode);
+    markSignalChanged(sig);
+    LOG_INFO(LOG_CAT_DAC, "Mode set: SIG%d -> %c", sig, mode);
+    return true;
 }
 
-void parseValueCommand(String params) {
-    int commaIndex = params.indexOf(',');
-    if (commaIndex == -1 || params.length() <= commaIndex + 1) {
-        Serial.println("Invalid value command. Use 'VALUE SIG,VALUE' (case-insensitive).");
-        return;
-    }
-
-    int sig = params.substring(0, commaIndex).toInt();
-    float value = params.substring(commaIndex + 1).toFloat();
-
+bool setSignalValue(uint8_t sig, float value) {
     if (sig < 1 || sig > 3) {
-        Serial.println("Invalid signal number. Use 1 to 3.");
-        return;
+        return false;
+    }
+    if (!isOutputEngineContext()) {
+        OutputCommand command = {};
+        command.type = OUT_CMD_SIGNAL_VALUE;
+        command.signalValue.sig = sig;
+        command.signalValue.value = value;
+        return postOutputCommand(command);
     }
 
     char mode = signalModes[sig - 1];
     if (mode == 'v') {
         if (value < 0 || value > 10.0) {
-            Serial.println("Invalid voltage value. Use 0-10V.");
-            return;
+            LOG_WARN(LOG_CAT_DAC, "Invalid voltage value. Use 0-10V.");
+            return false;
         }
-        signalMap[sig - 1].voltageDAC->setVoltage(value, signalMap[sig - 1].voltageChannel);
-        Serial.printf("Voltage set: SIG%d -> %.2f V\n", sig, value);
+        writeSignalOutput(sig, value);
+        LOG_INFO(LOG_CAT_DAC, "Voltage set: SIG%d -> %.2f V", sig, value);
     } else if (mode == 'c') {
         if (value < 0 || value > 25.0) {
-            Serial.println("Invalid current value. Use 0-25mA.");
-            return;
+            LOG_WARN(LOG_CAT_DAC, "Invalid current value. Use 0-25mA.");
+            return false;
         }
-        signalMap[sig - 1].currentDAC->setDACOutElectricCurrent(static_cast<uint16_t>(value * 1000));
-        Serial.printf("Current set: SIG%d -> %.2f mA\n", sig, value);
+        writeSignalOutput(sig, value);
+        LOG_INFO(LOG_CAT_DAC, "Current set: SIG%d -> %.2f mA", sig, value);
     } else {
-        Serial.printf("Unknown mode '%c' for SIG%d.\n", mode, sig);
+        LOG_WARN(LOG_CAT_DAC, "Unknown mode '%c' for SIG%d.", mode, sig);
+        return false;
+    }
+    return true;
+}
+
+void writeSignalOutput(uint8_t sig, float value) {
+    if (sig < 1 || sig > 3) {
+        return;
+    }
+    const SignalMap& map = signalMap[sig - 1];
+    if (value < 0) value = 0;
+    if (signalModes[sig - 1] == 'v') {
+        if (value > 10.0f) value = 10.0f;
+        map.voltageDAC->setVoltage(value, map.voltageChannel);
+    } else if (signalModes[sig - 1] == 'c') {
+        if (value > 25.0f) value = 25.0f;
+        map.currentDAC->setDACOutElectricCurrent(static_cast<uint16_t>(value * 1000));
+    }
+}
+
+float getSignalValue(uint8_t sig) {
+    if (sig < 1 || sig > 3) {
+        return 0.0f;
+    }
+    // Read back from the DAC driving the signal in its current mode
+    const SignalMap& map = signalMap[sig - 1];
+    if (signalModes[sig - 1] == 'c') {
+        return map.currentDAC->getCurrent();
     }
+    return map.voltageDAC->getVoltage(map.voltageChannel);
 }
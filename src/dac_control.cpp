@@ -1,4 +1,9 @@
 #include "dac_controller.h"
+#include "output_engine.h"
+#include "debug_log.h"
+#include "event_trace.h"
+#include "change_notify.h"
+#include "utils.h"
 
 // Global DAC instance definitions
 GP8413 gp8413_1(0x58); // GP8413 address 0x58, corresponds to SIG1 and SIG2 voltage
@@ -8,20 +13,53 @@ GP8313 gp8313_1(0x5A); // GP8313 address 0x5A, corresponds to SIG1 current
 GP8313 gp8313_2(0x5B); // GP8313 address 0x5B, corresponds to SIG2 current
 GP8313 gp8313_3(0x5C); // GP8313 address 0x5C, corresponds to SIG3 current
 
+extern char signalModes[3];
+
+/**
+ * Mark the signals whose reported setpoint is this DAC output as changed
+ * All DAC writes come through here, so change notifications and
+ * getSignalValue() follow streamed, waveform and RS-485 writes alike.
+ * Writes to the DAC of the inactive mode (protection zeroing) are not
+ * reported; setSignalMode() marks the mode change itself.
+ */
+static void markDacSignals(const DFRobot_GP8XXX_IIC* dac, uint8_t channel) {
+    for (uint8_t i = 0; i < 3; i++) {
+        if ((signalModes[i] == 'v' && signalMap[i].voltageDAC == dac && signalMap[i].voltageChannel == channel) ||
+            (signalModes[i] == 'c' && signalMap[i].currentDAC == dac)) {
+            markSignalChanged(i + 1);
+        }
+    }
+}
+
 // GP8413: Set voltage output
 bool GP8413::setVoltage(float voltage, uint8_t channel) {
     if (voltage < 0 || voltage > 10.0) { // Ensure voltage is within 0-10V range
-        Serial.printf("Voltage %.2fV out of range (0 to 10.0V).\n", voltage);
+        LOG_WARN(LOG_CAT_DAC, "Voltage %.2fV out of range (0 to 10.0V).", voltage);
         return false;
     }
 
     // Convert voltage to 15-bit DAC data
     uint16_t data = static_cast<uint16_t>((voltage / 10.0) * _resolution);
     setDACOutVoltage(data, channel); // Call base class setting function
-    Serial.printf("GP8413 Voltage Set: %.2fV on Channel %d (Address 0x%X)\n", voltage, channel, _deviceAddr);
+    if (_voltage[channel & 1] != voltage) {
+        _voltage[channel & 1] = voltage;
+        markDacSignals(this, channel);
+    }
+    traceEvent(TRACE_DAC_VOLTAGE, (uint8_t)((_deviceAddr << 1) | channel), data);
+    LOG_DEBUG(LOG_CAT_DAC, "GP8413 Voltage Set: %.2fV on Channel %d (Address 0x%X)", voltage, channel, _deviceAddr);
     return true;
 }
 
+// GP8313: Set current output
+void GP8313::setDACOutElectricCurrent(uint16_t current) {
+    setDACOutVoltage(current);
+    if (_current != current / 1000.0f) {
+        _current = current / 1000.0f;
+        markDacSignals(this, 0);
+    }
+    traceEvent(TRACE_DAC_CURRENT, _deviceAddr, current);
+}
+
 /**
  * Initialize all DAC outputs to 0
  */
@@ -36,7 +74,7 @@ void initializeDACs() {
     gp8313_2.setDACOutElectricCurrent(0); // SIG2 current channel
     gp8313_3.setDACOutElectricCurrent(0); // SIG3 current channel
 
-    Serial.println("All DAC outputs initialized to 0.");
+    LOG_INFO(LOG_CAT_DAC, "All DAC outputs initialized to 0.");
 }
 
 // Global variables to track current outputs
@@ -48,7 +86,7 @@ static float currentCurrentOutput = 0.0f;
  */
 void initDACControllers() {
     initializeDACs();
-    Serial.println("DAC controllers initialized");
+    LOG_INFO(LOG_CAT_DAC, "DAC controllers initialized");
 }
 
 /**
@@ -56,14 +94,21 @@ void initDACControllers() {
  * @param voltage Voltage value (0-10V)
  */
 void setVoltageOutput(float voltage) {
+    if (!isOutputEngineContext()) {
+        OutputCommand command = {};
+        command.type = OUT_CMD_VOLTAGE;
+        command.level = voltage;
+        postOutputCommand(command);
+        return;
+    }
     if (voltage < 0 || voltage > 10.0) {
-        Serial.printf("Voltage %.2fV out of range (0-10V)\n", voltage);
+        LOG_WARN(LOG_CAT_DAC, "Voltage %.2fV out of range (0-10V)", voltage);
         return;
     }
     
     currentVoltageOutput = voltage;
     gp8413_1.setVoltage(voltage, 0); // Set on first channel
-    Serial.printf("Voltage output set to %.2fV\n", voltage);
+    LOG_INFO(LOG_CAT_DAC, "Voltage output set to %.2fV", voltage);
 }
 
 /**
@@ -71,14 +116,21 @@ void setVoltageOutput(float voltage) {
  * @param current Current value (0-25mA)
  */
 void setCurrentOutput(float current) {
+    if (!isOutputEngineContext()) {
+        OutputCommand command = {};
+        command.type = OUT_CMD_CURRENT;
+        command.level = current;
+        postOutputCommand(command);
+        return;
+    }
     if (current < 0 || current > 25.0) {
-        Serial.printf("Current %.2fmA out of range (0-25mA)\n", current);
+        LOG_WARN(LOG_CAT_DAC, "Current %.2fmA out of range (0-25mA)", current);
         return;
     }
     
     currentCurrentOutput = current;
-    gp8313_1.setDACOutElectricCurrent((uint16_t)current);
-    Serial.printf("Current output set to %.2fmA\n", current);
+    gp8313_1.setDACOutElectricCurrent(static_cast<uint16_t>(current * 1000));
+    LOG_INFO(LOG_CAT_DAC, "Current output set to %.2fmA", current);
 }
 
 /**
@@ -0,0 +1,137 @@
+#include "debug_log.h"
+#include <atomic>
+#include <stdarg.h>
+#include <freertos/task.h>
+
+// Ring slot: the lap counter tells producers and the drain task whose turn
+// it is (bounded multi-producer queue, one consumer). It holds the position
+// of the slot's current lap start, +1 once written, so a zeroed ring is
+// ready for the first lap without an init call.
+struct LogRecord {
+    std::atomic<uint32_t> lap;
+    uint32_t timestamp;            // millis()
+    uint8_t level;
+    uint8_t category;
+    char text[LOG_MESSAGE_MAX];
+};
+
+static LogRecord logRing[LOG_RING_SIZE];
+static std::atomic<uint32_t> enqueuePos(0);
+static uint32_t dequeuePos = 0;               // Drain task only
+static std::atomic<uint32_t> droppedCount(0);
+
+static volatile uint8_t runtimeLevel = LOG_LEVEL;
+static volatile uint8_t runtimeCategories = LOG_CATEGORIES;
+
+static const char levelTags[] = {'-', 'E', 'W', 'I', 'D'};
+
+/**
+ * Ring position at which the lap containing pos started
+ */
+static inline uint32_t lapStart(uint32_t pos) {
+    return pos - pos % LOG_RING_SIZE;
+}
+
+/**
+ * Queue one message
+ */
+void logWrite(uint8_t level, uint8_t category, const char* format, ...) {
+    if (level > runtimeLevel || !(category & runtimeCategories)) {
+        return;
+    }
+
+    // Claim a slot
+    uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+    LogRecord* record;
+    for (;;) {
+        record = &logRing[pos % LOG_RING_SIZE];
+        int32_t diff = (int32_t)(record->lap.load(std::memory_order_acquire) - lapStart(pos));
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            droppedCount.fetch_add(1, std::memory_order_relaxed); // Full
+            return;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    record->timestamp = millis();
+    record->level = level;
+    record->category = category;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(record->text, sizeof(record->text), format, args);
+    va_end(args);
+    record->lap.store(lapStart(pos) + 1, std::memory_order_release);
+}
+
+/**
+ * Write queued messages to the USB serial port
+ */
+static void drainLogRing() {
+    for (;;) {
+        LogRecord& record = logRing[dequeuePos % LOG_RING_SIZE];
+        if (record.lap.load(std::memory_order_acquire) != lapStart(dequeuePos) + 1) {
+            return; // Empty, or the next slot is still being written
+        }
+        Serial.printf("[%lu %c] %s\n", (unsigned long)record.timestamp, levelTags[record.level], record.text);
+        record.lap.store(lapStart(dequeuePos) + LOG_RING_SIZE, std::memory_order_release);
+        dequeuePos++;
+    }
+}
+
+/**
+ * Log drain task
+ */
+static void logTask(void* param) {
+    uint32_t reportedDrops = 0;
+    for (;;) {
+        drainLogRing();
+        uint32_t dropped = droppedCount.load(std::memory_order_relaxed);
+        if (dropped != reportedDrops) {
+            Serial.printf("[log] %lu messages dropped\n", (unsigned long)(dropped - reportedDrops));
+            reportedDrops = dropped;
+        }
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+    }
+}
+
+/**
+ * Start the log drain task
+ */
+void initDebugLog() {
+    xTaskCreate(logTask, "log", LOG_TASK_STACK, nullptr, LOG_TASK_PRIORITY, nullptr);
+}
+
+/**
+ * Set the runtime level
+ */
+void setLogLevel(uint8_t level) {
+    runtimeLevel = level > LOG_LEVEL_DEBUG ? LOG_LEVEL_DEBUG : level;
+}
+
+/**
+ * Set the runtime category mask
+ */
+void setLogCategories(uint8_t mask) {
+    runtimeCategories = mask;
+}
+
+/**
+ * Get number of messages dropped because the ring was full
+ */
+uint32_t getLogDroppedCount() {
+    return droppedCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * Print log settings and counters to the USB serial port
+ */
+void printLogStatus() {
+    Serial.printf("Log: level %u (compiled %u), categories 0x%02X (compiled 0x%02X), %lu dropped\n",
+                  runtimeLevel, LOG_LEVEL, runtimeCategories, LOG_CATEGORIES,
+                  (unsigned long)getLogDroppedCount());
+}
@@ -56,15 +56,6 @@ void setupDeviceID() {
     }
 }
 
-/**
- * Example: Use device ID for Modbus slave address
- */
-uint8_t getModbusSlaveAddress() {
-    uint8_t deviceID = calculateDeviceID();
-    // Use device ID as base address, add offset if needed
-    return 0x01 + deviceID; // Addresses: 0x01, 0x02, 0x03, etc.
-}
-
 /**
  * Example: Check if device has specific feature enabled
  */
@@ -0,0 +1,91 @@
+#include "event_trace.h"
+
+TraceRecord traceRing[TRACE_RING_SIZE];
+std::atomic<uint32_t> traceHead(0);
+volatile bool traceEnabled = EVENT_TRACE;
+
+/**
+ * Event name used in the CSV dump
+ */
+static const char* traceEventName(uint8_t event) {
+    switch (event) {
+        case TRACE_FRAME_RX: return "frame_rx";
+        case TRACE_FRAME_DROP: return "frame_drop";
+        case TRACE_REPLY_TX: return "reply_tx";
+        case TRACE_CMD_BEGIN: return "cmd_begin";
+        case TRACE_CMD_END: return "cmd_end";
+        case TRACE_DAC_VOLTAGE: return "dac_voltage";
+        case TRACE_DAC_CURRENT: return "dac_current";
+        case TRACE_RELAY: return "relay";
+        case TRACE_TICK_BEGIN: return "tick_begin";
+        case TRACE_TICK_END: return "tick_end";
+        default: return "unknown";
+    }
+}
+
+/**
+ * Start or stop recording
+ */
+void setTraceEnabled(bool enabled) {
+    traceEnabled = enabled && EVENT_TRACE;
+}
+
+/**
+ * Discard all records
+ */
+void clearTrace() {
+    traceHead.store(0, std::memory_order_relaxed);
+    memset(traceRing, 0, sizeof(traceRing));
+}
+
+/**
+ * Get the sequence number the next record will receive
+ */
+uint32_t getTraceHead() {
+    return traceHead.load(std::memory_order_relaxed);
+}
+
+/**
+ * Copy records out of the ring
+ */
+uint16_t readTrace(uint32_t from, TraceRecord* out, uint16_t maxCount, uint32_t* first) {
+    uint32_t head = traceHead.load(std::memory_order_acquire);
+    uint32_t oldest = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+    if (from < oldest) {
+        from = oldest;
+    }
+    if (from > head) {
+        from = head;
+    }
+    *first = from;
+
+    uint16_t count = 0;
+    while (from + count < head && count < maxCount) {
+        out[count] = traceRing[(from + count) % TRACE_RING_SIZE];
+        count++;
+    }
+    return count;
+}
+
+/**
+ * Print the retained records as CSV
+ */
+void dumpTrace() {
+    bool wasEnabled = traceEnabled;
+    traceEnabled = false;
+
+    uint32_t head = getTraceHead();
+    Serial.printf("# trace: %lu records, %lu retained\n", (unsigned long)head,
+                  (unsigned long)(head > TRACE_RING_SIZE ? TRACE_RING_SIZE : head));
+    Serial.println("seq,t_us,event,arg8,arg16");
+
+    TraceRecord record;
+    uint32_t seq = 0;
+    while (readTrace(seq, &record, 1, &seq) == 1) {
+        Serial.printf("%lu,%lu,%s,%u,%u\n", (unsigned long)seq, (unsigned long)record.timestamp,
+                      traceEventName(record.event), record.arg8, record.arg16);
+        seq++;
+    }
+
+    traceEnabled = wasEnabled;
+}
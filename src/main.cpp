@@ -6,129 +6,163 @@
 #include "sine_wave_generator.h"
 #include "device_id.h"
 #include "modbus_handler.h"
+#include "setpoint_stream.h"
+#include "modbus_generator.h"
+#include "scheduler.h"
+#include "output_engine.h"
+#include "debug_log.h"
+#include "event_trace.h"
+#include "profiler.h"
+#include "telemetry.h"
+#include "change_notify.h"
+#include "output_journal.h"
+#include "command_handler.h"
+#include "text_command.h"
 
 char signalModes[3] = {'v', 'v', 'v'};
-// Timing variables
-unsigned long lastStatusReport = 0;
-const unsigned long STATUS_REPORT_INTERVAL = 5000; // 5 seconds
 
-// 新增：每通道模式和数值
-char channelModes[3] = {'v', 'v', 'v'}; // 'v' or 'c'
-float channelValues[3] = {0.0f, 0.0f, 0.0f}; // 输出值
+// Communications task: runs the scheduler on core 0, next to the Modbus task
+#define COMMS_TASK_CORE 0
+#define COMMS_TASK_PRIORITY 2       // Below the Modbus task (3)
+#define COMMS_TASK_STACK 8192
+
+// Boot phase timestamps (micros() counts from reset)
+#define BOOT_PHASE_MAX 8
+struct BootPhase {
+    const char* name;
+    uint32_t atUs;
+};
+static BootPhase bootPhases[BOOT_PHASE_MAX];
+static uint8_t bootPhaseCount = 0;
+static bool outputsRestored = false;
+
+// Scheduler jobs released by UART receive events
+static int8_t usbJob = -1;
+static int8_t rs485Job = -1;
 
 // Forward declarations
-void printStatusReport();
 void printHelp();
 void handleUSBSerialCommands();
 void sendTestRS485Command(uint8_t commandType, const uint8_t* data, uint8_t length);
 void setChannelOutput(uint8_t channel, char mode, float value);
+void initMainLoopJobs();
+void commsTask(void* param);
+
+/**
+ * Record the end of a boot phase
+ * @param name Phase name (static string)
+ */
+static void markBootPhase(const char* name) {
+    if (bootPhaseCount < BOOT_PHASE_MAX) {
+        bootPhases[bootPhaseCount].name = name;
+        bootPhases[bootPhaseCount].atUs = micros();
+        bootPhaseCount++;
+    }
+}
+
+/**
+ * Print boot phase timing
+ */
+void printBootTiming() {
+    Serial.printf("Boot: outputs %s\n", outputsRestored ? "restored from journal" : "set to defaults");
+    uint32_t previous = 0;
+    for (uint8_t i = 0; i < bootPhaseCount; i++) {
+        Serial.printf("  %-10s at %7.2f ms (+%.2f ms)\n", bootPhases[i].name,
+                      bootPhases[i].atUs / 1000.0f, (bootPhases[i].atUs - previous) / 1000.0f);
+        previous = bootPhases[i].atUs;
+    }
+}
 
 void setup() {
-    // Initialize USB Serial for debugging
-    Serial.begin(115200);
-    Serial.println("=== ESP32 Input Module with RS-485 ===");
+    markBootPhase("startup");
     
-    // Initialize device ID
+    // Outputs first: put the last journaled state back before anything slow
     initDeviceIDPins();
-    uint8_t deviceID = calculateDeviceID();
-    Serial.printf("Device ID: %d\n", deviceID);
-    
-    // Initialize DAC controllers
+    initRelayController();
     initDACControllers();
-    Serial.println("DAC controllers initialized");
+    initSineWaveGenerator();
+    initSetpointStream();
+    outputsRestored = restoreOutputJournal();
+    markBootPhase("outputs");
     
-    // Initialize relay controller
-    initRelayController();
-    Serial.println("Relay controller initialized");
-
-    // Default to three-channel voltage mode on startup
-    setRelayMode(1, 'v');
-    setRelayMode(2, 'v');
-    setRelayMode(3, 'v');
+    // Waveform and output engine on core 1; output calls are posted to it from here on
+    initOutputEngine();
+    markBootPhase("engine");
     
-    // Initialize sine wave generator
-    initSineWaveGenerator();
-    Serial.println("Sine wave generator initialized");
+    // USB Serial for debugging; boot messages go through the deferred log
+    Serial.begin(115200);
+    initDebugLog();
+    uint8_t deviceID = calculateDeviceID();
+    LOG_INFO(LOG_CAT_SYSTEM, "=== ESP32 Input Module with RS-485 ===");
+    LOG_INFO(LOG_CAT_SYSTEM, "Device ID: %d", deviceID);
     
-    // Initialize RS-485 serial communication
+    // RS-485 serial and command handler
     initRS485Serial();
-    
-    // Initialize RS-485 command handler
     initRS485CommandHandler();
+    markBootPhase("rs485");
     
-    // Initialize Modbus slave
+    // Modbus slave
     initModbus();
+    markBootPhase("modbus");
+    
+    // USB, RS-485 and Modbus control handling on core 0
+    xTaskCreatePinnedToCore(commsTask, "comms", COMMS_TASK_STACK, nullptr, COMMS_TASK_PRIORITY, nullptr, COMMS_TASK_CORE);
+    markBootPhase("ready");
     
-    Serial.println("System initialization complete");
-    Serial.println("USB Serial: Debug output only");
-    Serial.println("RS-485 Serial: Command interface (GPIO 19=TX, 18=RX, 21=DE)");
-    Serial.println("Modbus Slave: Interface (GPIO 17=TX, 16=RX)");
-    Serial.println("Ready to receive commands...");
+    LOG_INFO(LOG_CAT_SYSTEM, "Outputs %s at %.1f ms, ready at %.1f ms",
+             outputsRestored ? "restored" : "defaulted", bootPhases[1].atUs / 1000.0f,
+             bootPhases[bootPhaseCount - 1].atUs / 1000.0f);
+    LOG_INFO(LOG_CAT_SYSTEM, "RS-485: GPIO 19=TX, 18=RX, 21=DE; Modbus: GPIO 17=TX, 16=RX, address %u",
+             getModbusSlaveAddress());
 }
 
 void loop() {
-    // Process USB Serial commands
-    handleUSBSerialCommands();
-    
-    // Process RS-485 commands
-    if (handleRS485Commands()) {
-        // Command was processed, no need to do anything else
-        // The command handler will send responses automatically
-    }
-    
-    // Handle Modbus slave tasks
-    mb.task();
-    
-    // Update sine wave generator
-    updateSineWave();
-    
-    // Periodic status report via USB Serial (for debugging)
-    if (millis() - lastStatusReport >= STATUS_REPORT_INTERVAL) {
-        printStatusReport();
-        lastStatusReport = millis();
+    // All work runs in the comms and output engine tasks
+    vTaskDelete(nullptr);
+}
+
+/**
+ * Communications task (core 0)
+ * Runs due jobs; blocks until the next release or UART receive event.
+ */
+void commsTask(void* param) {
+    initMainLoopJobs();
+    for (;;) {
+        runScheduler();
     }
-    
-    // Small delay to prevent watchdog issues
-    delay(10);
 }
 
 /**
- * Print periodic status report via USB Serial
+ * Process RS-485 commands (responses are sent by the command handler)
  */
-void printStatusReport() {
-    Serial.println("\n=== Status Report ===");
-    
-    // Device information
-    Serial.printf("Device ID: %d\n", getCurrentDeviceID());
-    
-    // DAC outputs
-    Serial.printf("Voltage Output: %.2fV\n", getCurrentVoltage());
-    Serial.printf("Current Output: %.2fmA\n", getCurrentCurrent());
-    
+static void serviceRS485Job() {
+    PROFILE_ZONE(PROFILE_RS485);
+    handleRS485Commands();
 
-    
-    // Sine wave status
-    if (isSineWaveActive()) {
-        Serial.println("Sine Wave: ACTIVE");
-    } else {
-        Serial.println("Sine Wave: INACTIVE");
-    }
-    
-    // RS-485 status
-    Serial.printf("RS-485: %s\n", isRS485Available() ? "Data Available" : "Idle");
-    
-    // 修改 printStatusReport，循环显示每个通道
-    Serial.println("\n=== Channel Status ===");
-    for (int i = 0; i < 3; ++i) {
-        if (channelModes[i] == 'v') {
-            Serial.printf("Channel %d: Voltage mode, %.2fV\n", i+1, channelValues[i]);
-        } else if (channelModes[i] == 'c') {
-            Serial.printf("Channel %d: Current mode, %.2fmA\n", i+1, channelValues[i]);
-        } else {
-            Serial.printf("Channel %d: Unknown mode\n", i+1);
-        }
-    }
-    Serial.println("==================\n");
+    // Received bytes signal this job; only a queued slotted reply needs a timed wake
+    uint32_t waitUs = getRS485TransmitWaitUs();
+    setSchedulerJobPeriod(rs485Job, waitUs == UINT32_MAX ? SCHEDULER_EVENT_ONLY : (waitUs > 0 ? waitUs : 1));
+}
+
+/**
+ * Register the communication jobs (comms task)
+ * Priorities: bus timing first, then output requests, then housekeeping.
+ * The waveform and setpoint stream run in the output engine instead.
+ */
+void initMainLoopJobs() {
+    initScheduler();
+
+    //                          name         function                    period                deadline  priority
+    rs485Job = addSchedulerJob("rs485",      serviceRS485Job,            SCHEDULER_EVENT_ONLY,  1000,     5);
+    addSchedulerJob(           "modbus_ctl", applyModbusControlActions,  10000,                 10000,    3);
+    usbJob = addSchedulerJob(  "usb",        handleUSBSerialCommands,    20000,                 50000,    2);
+    addSchedulerJob(           "generators", updateModbusGenerators,     10000,                 20000,    1);
+    initOutputJournal();  // "journal" job, writes settled output changes to NVS
+    initTelemetry();  // "telemetry" job, event only until a host subscribes
+
+    // Serve received bytes immediately; RS-485 is event driven and never polled
+    Serial.onReceive([]() { signalSchedulerJob(usbJob); }, false);
+    onRS485Receive([]() { signalSchedulerJob(rs485Job); });
 }
 
 /**
@@ -165,108 +199,228 @@ void sendTestRS485Command(uint8_t commandType, const uint8_t* data, uint8_t leng
 }
 
 /**
- * Handle USB Serial commands for testing
+ * Handle a channel,mode,value line
  */
-void handleUSBSerialCommands() {
-    if (Serial.available()) {
-        String command = Serial.readStringUntil('\n');
-        command.trim();
-        // 不再整体toLowerCase，保留参数原样
-        String cmdLower = command;
-        cmdLower.toLowerCase();
-        if (cmdLower.startsWith("ping")) {
-            sendTestRS485Command(CMD_PING, nullptr, 0);
+static void processChannelCommand(char* line) {
+    TextCursor cursor = {line};
+    char* channelText = nextToken(&cursor, ", \t");
+    char* modeText = nextToken(&cursor, ", \t");
+    char* valueText = nextToken(&cursor, ", \t");
+    uint32_t channel;
+    float value;
+    if (!parseTextUint(channelText, &channel) || !modeText || !parseTextFloat(valueText, &value) ||
+        nextToken(&cursor, ", \t")) {
+        Serial.println("Usage: channel,mode,value (e.g., 3,v,2.0)");
+        return;
+    }
+    char mode = tolower(modeText[0]);
+    if (channel < 1 || channel > 3) {
+        Serial.println("Invalid channel (1-3)");
+    } else if ((mode != 'v' && mode != 'c') || modeText[1] != '\0') {
+        Serial.println("Invalid mode (v/c)");
+    } else {
+        setChannelOutput(channel, mode, value);
+        Serial.printf("Channel %lu set to %s mode, output %.2f%s\n", (unsigned long)channel,
+                      mode == 'v' ? "VOLTAGE" : "CURRENT", value, mode == 'v' ? "V" : "mA");
+    }
+}
+
+/**
+ * Send a setpoint command scaled by 100, if it is in range
+ */
+static void sendSetpointCommand(uint8_t opcode, const char* valueText, float maxValue, const char* error) {
+    float value;
+    if (parseTextFloat(valueText, &value) && value >= 0 && value <= maxValue) {
+        uint16_t raw = (uint16_t)(value * 100);
+        uint8_t data[2] = {(uint8_t)(raw >> 8), (uint8_t)(raw & 0xFF)};
+        sendTestRS485Command(opcode, data, 2);
+    } else {
+        Serial.println(error);
+    }
+}
+
+/**
+ * Handle one USB command line (edited in place by the tokenizer)
+ */
+static void processUSBCommand(char* line) {
+    if (isdigit((unsigned char)line[0]) && strchr(line, ',')) {
+        processChannelCommand(line);
+        return;
+    }
+
+    TextCursor cursor = {line};
+    char* command = nextToken(&cursor);
+    if (!command) {
+        return;
+    }
+
+    if (tokenEquals(command, "ping")) {
+        sendTestRS485Command(CMD_PING, nullptr, 0);
+    }
+    else if (tokenEquals(command, "status")) {
+        sendTestRS485Command(CMD_GET_STATUS, nullptr, 0);
+    }
+    else if (tokenEquals(command, "voltage")) {
+        sendSetpointCommand(CMD_SET_VOLTAGE, nextToken(&cursor), 10, "Invalid voltage value (0-10V)");
+    }
+    else if (tokenEquals(command, "current")) {
+        sendSetpointCommand(CMD_SET_CURRENT, nextToken(&cursor), 25, "Invalid current value (0-25mA)");
+    }
+    else if (tokenEquals(command, "sine")) {
+        char* modeText = nextToken(&cursor);
+        uint32_t center, amplitude, period;
+        if (!modeText || !parseTextUint(nextToken(&cursor), &center) ||
+            !parseTextUint(nextToken(&cursor), &amplitude) || !parseTextUint(nextToken(&cursor), &period)) {
+            Serial.println("Usage: sine <mode> <center> <amplitude> <period>");
+            return;
         }
-        else if (cmdLower.startsWith("status")) {
-            sendTestRS485Command(CMD_GET_STATUS, nullptr, 0);
+        uint8_t modeByte;
+        switch (modeText[0]) {
+            case 'v': case 'V': modeByte = 0; break;
+            case 'c': case 'C': modeByte = 1; break;
+            case 'd': case 'D': modeByte = 2; break;
+            default:
+                Serial.println("Invalid mode (v/c/d)");
+                return;
         }
-        else if (cmdLower.startsWith("voltage")) {
-            float voltage = command.substring(8).toFloat();
-            if (voltage >= 0 && voltage <= 10) {
-                uint16_t voltageRaw = (uint16_t)(voltage * 100);
-                uint8_t data[2] = {(uint8_t)(voltageRaw >> 8), (uint8_t)(voltageRaw & 0xFF)};
-                sendTestRS485Command(CMD_SET_VOLTAGE, data, 2);
-            } else {
-                Serial.println("Invalid voltage value (0-10V)");
-            }
+        uint8_t data[6] = {
+            modeByte,
+            (uint8_t)center,
+            (uint8_t)amplitude,
+            (uint8_t)(period >> 8),
+            (uint8_t)(period & 0xFF),
+            0x00 // Reserved
+        };
+        sendTestRS485Command(CMD_SINE_WAVE, data, 6);
+    }
+    else if (tokenEquals(command, "stop")) {
+        sendTestRS485Command(CMD_STOP_SINE, nullptr, 0);
+    }
+    else if (tokenEquals(command, "send")) {
+        // Generic RS-485 command by registry name: send <name> [byte ...]
+        const CommandSpec* spec = findRS485CommandByName(nextToken(&cursor));
+        if (!spec) {
+            Serial.println("Unknown RS-485 command name");
+            return;
         }
-        else if (cmdLower.startsWith("current")) {
-            float current = command.substring(8).toFloat();
-            if (current >= 0 && current <= 25) {
-                uint16_t currentRaw = (uint16_t)(current * 100);
-                uint8_t data[2] = {(uint8_t)(currentRaw >> 8), (uint8_t)(currentRaw & 0xFF)};
-                sendTestRS485Command(CMD_SET_CURRENT, data, 2);
-            } else {
-                Serial.println("Invalid current value (0-25mA)");
+        uint8_t data[RS485_MAX_COMMAND_LENGTH - 2];
+        uint8_t length = 0;
+        char* token;
+        while ((token = nextToken(&cursor)) != nullptr) {
+            uint32_t value;
+            if (length >= sizeof(data) || !parseTextUint(token, &value) || value > 0xFF) {
+                Serial.printf("Data must be up to %u bytes (0-255 or 0x00-0xFF)\n", (unsigned)sizeof(data));
+                return;
             }
+            data[length++] = (uint8_t)value;
+        }
+        if (checkCommand(spec, length, false) == CMD_CHECK_BAD_LENGTH) {
+            Serial.printf("Invalid length for %s (%d-%d bytes)\n", spec->name, spec->minLength, spec->maxLength);
+            return;
         }
-        else if (cmdLower.startsWith("sine")) {
-            int space1 = command.indexOf(' ', 5);
-            int space2 = command.indexOf(' ', space1 + 1);
-            int space3 = command.indexOf(' ', space2 + 1);
-            int space4 = command.indexOf(' ', space3 + 1);
-            if (space1 > 0 && space2 > 0 && space3 > 0 && space4 > 0) {
-                char mode = command.charAt(space1 + 1);
-                int center = command.substring(space2 + 1, space3).toInt();
-                int amplitude = command.substring(space3 + 1, space4).toInt();
-                int period = command.substring(space4 + 1).toInt();
-                uint8_t modeByte;
-                switch (mode) {
-                    case 'v': case 'V': modeByte = 0; break;
-                    case 'c': case 'C': modeByte = 1; break;
-                    case 'd': case 'D': modeByte = 2; break;
-                    default:
-                        Serial.println("Invalid mode (v/c/d)");
-                        return;
-                }
-                uint8_t data[6] = {
-                    modeByte,
-                    (uint8_t)center,
-                    (uint8_t)amplitude,
-                    (uint8_t)(period >> 8),
-                    (uint8_t)(period & 0xFF),
-                    0x00 // Reserved
-                };
-                sendTestRS485Command(CMD_SINE_WAVE, data, 6);
+        sendTestRS485Command(spec->opcode, data, length);
+    }
+    else if (tokenEquals(command, "engine")) {
+        printOutputEngineStats();
+        if (tokenEquals(nextToken(&cursor), "reset")) {
+            resetOutputEngineStats();
+        }
+    }
+    else if (tokenEquals(command, "log")) {
+        char* option;
+        while ((option = nextToken(&cursor)) != nullptr) {
+            uint32_t value;
+            if (tokenEquals(option, "level") && parseTextUint(nextToken(&cursor), &value, 10)) {
+                setLogLevel((uint8_t)value);
+            } else if (tokenEquals(option, "cat") && parseTextUint(nextToken(&cursor), &value, 16)) {
+                setLogCategories((uint8_t)value);
             } else {
-                Serial.println("Usage: sine <mode> <center> <amplitude> <period>");
+                Serial.println("Usage: log [level n] [cat hex]");
+                break;
             }
         }
-        else if (cmdLower.startsWith("stop")) {
-            sendTestRS485Command(CMD_STOP_SINE, nullptr, 0);
+        printLogStatus();
+    }
+    else if (tokenEquals(command, "trace")) {
+        char* action = nextToken(&cursor);
+        if (tokenEquals(action, "stop")) {
+            setTraceEnabled(false);
+            Serial.println("Trace stopped");
+        } else if (tokenEquals(action, "start")) {
+            setTraceEnabled(true);
+            Serial.println("Trace recording");
+        } else if (tokenEquals(action, "clear")) {
+            clearTrace();
+            Serial.println("Trace cleared");
+        } else {
+            dumpTrace();
         }
-        else if (cmdLower.startsWith("modbus")) {
-            String modbusCmd = command.substring(7); // Remove "modbus " prefix
-            processInput(modbusCmd);
+    }
+    else if (tokenEquals(command, "profile")) {
+        printProfiler();
+        if (tokenEquals(nextToken(&cursor), "reset")) {
+            resetProfiler();
         }
-        else if (command.indexOf(',') > 0) {
-            int comma1 = command.indexOf(',');
-            int comma2 = command.indexOf(',', comma1 + 1);
-            if (comma1 > 0 && comma2 > 0) {
-                int channel = command.substring(0, comma1).toInt();
-                char mode = command.charAt(comma1 + 1);
-                float value = command.substring(comma2 + 1).toFloat();
-                if (channel >= 1 && channel <= 3) {
-                    if (mode == 'v' || mode == 'c' || mode == 'V' || mode == 'C') {
-                        setChannelOutput(channel, tolower(mode), value);
-                        Serial.printf("Channel %d set to %s mode, output %.2f%s\n", channel, (mode == 'v' || mode == 'V') ? "VOLTAGE" : "CURRENT", value, (mode == 'v' || mode == 'V') ? "V" : "mA");
-                    } else {
-                        Serial.println("Invalid mode (v/c)");
-                    }
-                } else {
-                    Serial.println("Invalid channel (1-3)");
-                }
-            } else {
-                Serial.println("Usage: channel,mode,value (e.g., 3,v,2.0)");
+    }
+    else if (tokenEquals(command, "telemetry")) {
+        char* option = nextToken(&cursor);
+        if (tokenEquals(option, "rate")) {
+            uint32_t intervalMs;
+            if (!parseTextUint(nextToken(&cursor), &intervalMs, 10) || !setTelemetryInterval(intervalMs)) {
+                Serial.printf("Telemetry interval must be 0 (off) or >= %d ms\n", TELEMETRY_MIN_INTERVAL_MS);
             }
+        } else {
+            printTelemetry();
         }
-        else if (cmdLower.startsWith("help")) {
-            printHelp();
+    }
+    else if (tokenEquals(command, "notify")) {
+        printChangeNotifyStatus();
+    }
+    else if (tokenEquals(command, "journal")) {
+        if (tokenEquals(nextToken(&cursor), "clear")) {
+            clearOutputJournal();
+            Serial.println("Journal cleared");
         }
-        else if (command.length() > 0) {
-            Serial.println("Unknown command. Type 'help' for available commands.");
+        printOutputJournal();
+    }
+    else if (tokenEquals(command, "boot")) {
+        printBootTiming();
+    }
+    else if (tokenEquals(command, "sched")) {
+        printSchedulerStats();
+        if (tokenEquals(nextToken(&cursor), "reset")) {
+            resetSchedulerStats();
         }
     }
+    else if (tokenEquals(command, "modbus")) {
+        processInput(remainingText(&cursor));
+    }
+    else if (tokenEquals(command, "help")) {
+        printHelp();
+    }
+    else {
+        Serial.println("Unknown command. Type 'help' for available commands.");
+    }
+}
+
+/**
+ * Handle USB Serial commands for testing
+ * Never waits for the rest of a line; one line is handled per run and the
+ * job signals itself while more input is buffered.
+ */
+void handleUSBSerialCommands() {
+    PROFILE_ZONE(PROFILE_USB);
+    static LineAssembler usbLine;
+
+    LineStatus status = assembleLine(&usbLine, Serial);
+    if (status == LINE_READY) {
+        processUSBCommand(usbLine.line);
+    } else if (status == LINE_TOO_LONG) {
+        Serial.printf("Line too long (max %d characters), ignored\n", TEXT_LINE_MAX - 1);
+    }
+    if (status != LINE_PENDING && Serial.available()) {
+        signalSchedulerJob(usbJob);
+    }
 }
 
 /**
@@ -286,21 +440,35 @@ void printHelp() {
     Serial.println("current <value>         - Set current output (0-25mA)");
     Serial.println("sine <mode> <c> <a> <p> - Start sine wave");
     Serial.println("stop                    - Stop sine wave");
-    Serial.println("modbus <reg>,<addr>,<type>,<value> - Configure Modbus register");
-    Serial.println("  Example: modbus 0,1000,I,12345   - Set register 0 to address 1000, type I, value 12345");
-    Serial.println("  Types: I(U64), F(Float), S(Int16)");
+    Serial.println("send <name> [bytes...]  - Send any RS-485 command by name");
+    Serial.println("  Example: send relay 1 1   - Relay 1 on");
+    Serial.println("modbus <addr>,<type>,<value> - Define/update Modbus register");
+    Serial.println("  Example: modbus 1000,I,12345     - Address 1000, type I, value 12345");
+    Serial.println("  Types: I(U64), U(U32), F(Float), S(Int16)");
+    Serial.println("  Word order: append /ABCD, /CDAB, /BADC or /DCBA, e.g. 1000,F/CDAB,3.14");
+    Serial.println("modbus load <a>:<t>:<v>;...  - Load a whole register profile");
+    Serial.println("  End a line with \\ to continue the profile on the next modbus load line");
+    Serial.println("modbus del <addr> / clear / list - Manage register bank");
+    Serial.println("modbus profile save|load|delete|default <name> / list - Stored profiles");
+    Serial.println("modbus gen <addr> counter|ramp|sine|noise|off ... - Live register generator");
+    Serial.println("modbus timing [reset]   - Modbus turnaround statistics");
+    Serial.println("modbus diag [reset]     - Modbus traffic counters (also FC08 / input regs 0xF040)");
+    Serial.println("modbus address [base <n> | set <n> | auto] - Slave address (base + jumper ID)");
+    Serial.println("sched [reset]           - Scheduler job timing and overruns");
+    Serial.println("engine [reset]          - Output engine tick latency and jitter");
+    Serial.println("log [level n] [cat hex] - Runtime log level (0-4) and category mask");
+    Serial.println("trace [start|stop|clear] - Dump event trace as CSV, or control recording");
+    Serial.println("profile [reset]         - Per-stage min/avg/max/p99 execution time");
+    Serial.println("telemetry [rate <ms>]   - Show state, or stream binary frames (rate 0 = off)");
+    Serial.println("notify                  - Change notification subscription state");
+    Serial.println("journal [clear]         - Journaled output state restored at boot");
+    Serial.println("boot                    - Boot phase timing");
     Serial.println("help                    - Show this help");
     Serial.println("========================================\n");
 } 
 
 void setChannelOutput(uint8_t channel, char mode, float value) {
     if (channel < 1 || channel > 3) return;
-    channelModes[channel - 1] = mode;
-    channelValues[channel - 1] = value;
-    setRelayMode(channel, mode);
-    if (mode == 'v') {
-        setVoltageOutput(value);
-    } else if (mode == 'c') {
-        setCurrentOutput(value);
-    }
+    setSignalMode(channel, mode);
+    setSignalValue(channel, value);
 } 
\ No newline at end of file
@@ -0,0 +1,251 @@
+#include "modbus_diagnostics.h"
+#include "modbus_handler.h"
+#include "modbus_register_bank.h"
+
+// FC08 sub-functions
+#define DIAG_RETURN_QUERY_DATA 0x00
+#define DIAG_RESTART_COMMS 0x01
+#define DIAG_RETURN_REGISTER 0x02
+#define DIAG_CLEAR_COUNTERS 0x0A
+#define DIAG_BUS_MESSAGES 0x0B
+#define DIAG_BUS_COMM_ERRORS 0x0C
+#define DIAG_BUS_EXCEPTIONS 0x0D
+#define DIAG_SERVER_MESSAGES 0x0E
+#define DIAG_SERVER_NO_RESPONSE 0x0F
+#define DIAG_SERVER_NAK 0x10
+#define DIAG_SERVER_BUSY 0x11
+
+static const uint8_t diagFunctionCodes[MB_DIAG_FC_SLOTS - 1] = {1, 2, 3, 4, 5, 6, 8, 15, 16, 22, 23};
+
+static ModbusDiagnostics diagnostics;
+
+// Frame accounting: every frame on the line ends with a UART RX timeout
+// event; every frame that passes the CRC check reaches the raw hook
+static volatile uint32_t frameEnds = 0;   // RX timeout events (UART event task)
+static uint32_t framesAccounted = 0;      // Frame ends matched or counted
+static bool frameBroadcast = false;
+static bool framePending = false;         // Passed to the library, no success yet
+
+// Request rate window
+static unsigned long rateWindowStart = 0;
+static uint32_t rateWindowMessages = 0;
+
+/**
+ * Counter slot for a function code
+ */
+static uint8_t functionCodeSlot(uint8_t fc) {
+    for (uint8_t i = 0; i < MB_DIAG_FC_SLOTS - 1; i++) {
+        if (diagFunctionCodes[i] == fc) {
+            return i;
+        }
+    }
+    return MB_DIAG_FC_SLOTS - 1;
+}
+
+/**
+ * Answer an FC08 request in place
+ * The echo response has the request's layout, so the frame is rewritten and
+ * sent back by the library as is.
+ * @return true if the sub-function was handled
+ */
+static bool handleDiagnosticsRequest(uint8_t* frame, uint8_t length) {
+    if (length < 3) {
+        return false;
+    }
+    uint16_t subFunction = (frame[1] << 8) | frame[2];
+    if (subFunction == DIAG_RETURN_QUERY_DATA) {
+        return true; // Echo unchanged
+    }
+    if (length != 5) {
+        return false;
+    }
+
+    uint32_t value;
+    switch (subFunction) {
+        case DIAG_RESTART_COMMS:
+        case DIAG_CLEAR_COUNTERS:
+            resetModbusDiagnostics();
+            return true; // Echo unchanged
+        case DIAG_RETURN_REGISTER:    value = 0; break;
+        case DIAG_BUS_MESSAGES:       value = diagnostics.busMessages; break;
+        case DIAG_BUS_COMM_ERRORS:    value = diagnostics.crcErrors; break;
+        case DIAG_BUS_EXCEPTIONS:     value = diagnostics.exceptions; break;
+        case DIAG_SERVER_MESSAGES:    value = diagnostics.serverMessages; break;
+        case DIAG_SERVER_NO_RESPONSE: value = diagnostics.noResponse; break;
+        case DIAG_SERVER_NAK:         value = 0; break;
+        case DIAG_SERVER_BUSY:        value = 0; break;
+        default:
+            return false;
+    }
+    frame[3] = (value >> 8) & 0xFF;
+    frame[4] = value & 0xFF;
+    return true;
+}
+
+/**
+ * Raw frame hook: called by the library for every frame on the bus that
+ * passed the CRC check, with its slave address, before it is processed.
+ * Answers FC08 and register bank requests; everything else passes through.
+ */
+static Modbus::ResultCode onModbusRawFrame(uint8_t* frame, uint8_t length, void* custom) {
+    const Modbus::frame_arg_t* header = (const Modbus::frame_arg_t*)custom;
+    uint8_t fc = length > 0 ? frame[0] & 0x7F : 0;
+
+    diagnostics.busMessages++;
+    framesAccounted++;
+    if (header->slaveId != 0 && header->slaveId != getModbusSlaveAddress()) {
+        return Modbus::EX_PASSTHROUGH; // Another slave's traffic, dropped by the library
+    }
+
+    frameBroadcast = header->slaveId == 0;
+    diagnostics.serverMessages++;
+    diagnostics.functionCodes[functionCodeSlot(fc)]++;
+    if (frameBroadcast) {
+        diagnostics.noResponse++;
+    }
+
+    if (fc == Modbus::FC_DIAGNOSTICS && handleDiagnosticsRequest(frame, length)) {
+        return Modbus::EX_SUCCESS;
+    }
+
+    // Register bank requests are answered here, outside the library's register list
+    Modbus::ResultCode result = serveRegisterBankRequest(frame, length, frameBroadcast);
+    if (result == Modbus::EX_SUCCESS) {
+        recordModbusRequestServed();
+    } else if (result == Modbus::EX_PASSTHROUGH) {
+        framePending = !frameBroadcast;
+    } else if (!frameBroadcast) {
+        diagnostics.exceptions++;
+    }
+    return result;
+}
+
+/**
+ * Input register read: diagnostics block
+ */
+static uint16_t onGetDiagnostics(TRegister* reg, uint16_t val) {
+    uint16_t offset = reg->address.address - MB_DIAG_BASE;
+    const ModbusTimingStats* timing = getModbusTimingStats();
+    uint32_t value;
+    if (offset >= 0x10) {
+        value = diagnostics.functionCodes[(offset - 0x10) / 2];
+    } else if (offset >= 0x0A) {
+        switch (offset) {
+            case 0x0A: value = diagnostics.requestsPerSecond; break;
+            case 0x0B: value = timing->requests ? timing->totalUs / timing->requests : 0; break;
+            case 0x0C: value = timing->maxUs; break;
+            case 0x0D: value = timing->lastUs; break;
+            default:   value = 0; break;
+        }
+        return value > 0xFFFF ? 0xFFFF : value;
+    } else {
+        switch (offset / 2) {
+            case 0:  value = diagnostics.busMessages; break;
+            case 1:  value = diagnostics.crcErrors; break;
+            case 2:  value = diagnostics.exceptions; break;
+            case 3:  value = diagnostics.serverMessages; break;
+            default: value = diagnostics.noResponse; break;
+        }
+    }
+    return offset % 2 == 0 ? highWord(value) : lowWord(value);
+}
+
+/**
+ * Register the raw frame hook and the diagnostics input registers
+ */
+void initModbusDiagnostics() {
+    resetModbusDiagnostics();
+    mb.onRaw(onModbusRawFrame);
+    mb.addIreg(MB_DIAG_BASE, 0, MB_DIAG_IREG_COUNT);
+    mb.onGetIreg(MB_DIAG_BASE, onGetDiagnostics, MB_DIAG_IREG_COUNT);
+}
+
+/**
+ * Count the end of a frame on the line (UART event task)
+ */
+void noteModbusFrameEnd() {
+    frameEnds++;
+}
+
+/**
+ * Start accounting for one mb.task() poll
+ */
+void beginModbusDiagnosticsPoll() {
+    framePending = false;
+}
+
+/**
+ * Account for the frame handled by mb.task(), if any
+ * A request passed to the library that was not reported as a success was
+ * answered with an exception. Once the library has consumed everything,
+ * frame ends that never reached the raw hook failed the CRC check.
+ */
+void endModbusDiagnosticsPoll() {
+    if (framePending) {
+        diagnostics.exceptions++;
+        framePending = false;
+    }
+
+    if (Serial2.available() == 0) {
+        int32_t unmatched = (int32_t)(frameEnds - framesAccounted);
+        if (unmatched > 0) {
+            diagnostics.crcErrors += unmatched;
+            diagnostics.busMessages += unmatched;
+        }
+        framesAccounted = frameEnds;
+    }
+
+    unsigned long now = millis();
+    if (now - rateWindowStart >= MB_DIAG_RATE_WINDOW_MS) {
+        uint32_t messages = diagnostics.serverMessages - rateWindowMessages;
+        diagnostics.requestsPerSecond = messages * 1000UL / (now - rateWindowStart);
+        rateWindowStart = now;
+        rateWindowMessages = diagnostics.serverMessages;
+    }
+}
+
+/**
+ * Record a request answered without exception
+ */
+void recordModbusSuccess() {
+    framePending = false;
+}
+
+/**
+ * Get diagnostic counters
+ */
+const ModbusDiagnostics* getModbusDiagnostics() {
+    return &diagnostics;
+}
+
+/**
+ * Clear all diagnostic counters
+ */
+void resetModbusDiagnostics() {
+    memset(&diagnostics, 0, sizeof(diagnostics));
+    rateWindowStart = millis();
+    rateWindowMessages = 0;
+    resetModbusTimingStats();
+}
+
+/**
+ * Print diagnostic counters to the USB serial port
+ */
+void printModbusDiagnostics() {
+    Serial.printf("Modbus diagnostics: bus %lu, CRC errors %lu, exceptions %lu, server %lu, no response %lu, %u req/s\n",
+                  (unsigned long)diagnostics.busMessages, (unsigned long)diagnostics.crcErrors,
+                  (unsigned long)diagnostics.exceptions, (unsigned long)diagnostics.serverMessages,
+                  (unsigned long)diagnostics.noResponse, diagnostics.requestsPerSecond);
+    Serial.print("  Per function code:");
+    for (uint8_t i = 0; i < MB_DIAG_FC_SLOTS; i++) {
+        if (diagnostics.functionCodes[i] == 0) {
+            continue;
+        }
+        if (i < MB_DIAG_FC_SLOTS - 1) {
+            Serial.printf(" FC%u=%lu", diagFunctionCodes[i], (unsigned long)diagnostics.functionCodes[i]);
+        } else {
+            Serial.printf(" other=%lu", (unsigned long)diagnostics.functionCodes[i]);
+        }
+    }
+    Serial.println();
+}
@@ -0,0 +1,189 @@
+#include "modbus_generator.h"
+#include "modbus_register_bank.h"
+#include "profiler.h"
+#include "text_command.h"
+
+// Generator slot
+struct ModbusGenerator {
+    uint16_t address;
+    ModbusGeneratorKind kind;
+    float p1, p2, p3;
+    float phase;              // Ramp/sine position within the period (0..1)
+    double total;             // Counter accumulator
+};
+
+static ModbusGenerator generators[MB_GENERATOR_MAX];
+static uint8_t generatorCount = 0;
+static unsigned long lastTickTime = 0;
+
+static const char* const generatorNames[] = {"none", "counter", "ramp", "sine", "noise"};
+
+/**
+ * Initialize register generators (none active)
+ */
+void initModbusGenerators() {
+    generatorCount = 0;
+    lastTickTime = millis();
+}
+
+/**
+ * Attach a generator to a register bank entry
+ */
+bool setModbusGenerator(uint16_t address, ModbusGeneratorKind kind, float p1, float p2, float p3) {
+    ModbusRegisterEntry* entry = findRegister(address);
+    if (!entry) {
+        Serial.printf("Modbus: No register defined at %u\n", address);
+        return false;
+    }
+    if ((kind == GEN_RAMP || kind == GEN_SINE) && p3 <= 0) {
+        Serial.println("Modbus: Generator period must be positive");
+        return false;
+    }
+
+    ModbusGenerator* gen = nullptr;
+    for (uint8_t i = 0; i < generatorCount; i++) {
+        if (generators[i].address == address) {
+            gen = &generators[i];
+            break;
+        }
+    }
+    if (!gen) {
+        if (generatorCount >= MB_GENERATOR_MAX) {
+            Serial.println("Modbus: Too many generators");
+            return false;
+        }
+        gen = &generators[generatorCount++];
+    }
+
+    gen->address = address;
+    gen->kind = kind;
+    gen->p1 = p1;
+    gen->p2 = p2;
+    gen->p3 = p3;
+    gen->phase = 0;
+    gen->total = getRegisterNumber(entry); // Counters continue from the current value
+    Serial.printf("Modbus: %s generator on %u\n", generatorNames[kind], address);
+    return true;
+}
+
+/**
+ * Detach the generator from an entry
+ */
+bool clearModbusGenerator(uint16_t address) {
+    for (uint8_t i = 0; i < generatorCount; i++) {
+        if (generators[i].address == address) {
+            generators[i] = generators[--generatorCount];
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Advance all generators (call this in main loop)
+ */
+void updateModbusGenerators() {
+    PROFILE_ZONE(PROFILE_GENERATORS);
+    unsigned long now = millis();
+    unsigned long elapsed = now - lastTickTime;
+    if (elapsed < MB_GENERATOR_TICK_MS) {
+        return;
+    }
+    lastTickTime = now;
+
+    // Values are staged in the bank and swapped in between master transactions
+    for (uint8_t i = 0; i < generatorCount; i++) {
+        ModbusGenerator& gen = generators[i];
+        ModbusRegisterEntry* entry = findRegister(gen.address);
+        if (!entry) {
+            continue; // Register removed; generator stays idle until redefined
+        }
+
+        // Advanced by the tick length and wrapped every period, so it keeps
+        // full float precision however long it runs and across millis() wrap
+        gen.phase += (elapsed / 1000.0f) / (gen.p3 > 0 ? gen.p3 : 1.0f);
+        if (gen.phase >= 1.0f) {
+            gen.phase -= floorf(gen.phase);
+        }
+        double value;
+        switch (gen.kind) {
+            case GEN_COUNTER:
+                gen.total += gen.p1 * (elapsed / 1000.0);
+                value = gen.total;
+                break;
+            case GEN_RAMP:
+                value = gen.p1 + (gen.p2 - gen.p1) * gen.phase;
+                break;
+            case GEN_SINE:
+                value = gen.p1 + gen.p2 * sinf(2.0f * PI * gen.phase);
+                break;
+            case GEN_NOISE:
+                value = gen.p1 + gen.p2 * (random(-1000, 1001) / 1000.0f);
+                break;
+            default:
+                continue;
+        }
+        setRegisterNumber(entry, value);
+    }
+}
+
+/**
+ * Print active generators to the USB serial port
+ */
+void listModbusGenerators() {
+    Serial.printf("Modbus generators: %u active\n", generatorCount);
+    for (uint8_t i = 0; i < generatorCount; i++) {
+        const ModbusGenerator& gen = generators[i];
+        Serial.printf("  %u %s %g %g %g\n", gen.address, generatorNames[gen.kind], gen.p1, gen.p2, gen.p3);
+    }
+}
+
+/**
+ * Parse "<addr> <kind> [params...]" or "<addr> off" or "list"
+ */
+void parseModbusGeneratorCommand(char* input) {
+    TextCursor cursor = {input};
+    char* first = nextToken(&cursor);
+    if (tokenEquals(first, "list")) {
+        listModbusGenerators();
+        return;
+    }
+
+    uint32_t address;
+    char* kind = nextToken(&cursor);
+    if (!parseTextUint(first, &address) || address > 0xFFFF || !kind) {
+        Serial.println("Usage: modbus gen <addr> counter|ramp|sine|noise|off [params]");
+        return;
+    }
+
+    // Up to three numeric parameters
+    float params[3] = {0, 0, 0};
+    uint8_t count = 2;
+    char* token;
+    while ((token = nextToken(&cursor)) != nullptr) {
+        if (count >= 5 || !parseTextFloat(token, &params[count - 2])) {
+            count = 0; // Malformed, print usage below
+            break;
+        }
+        count++;
+    }
+    float p1 = params[0];
+    float p2 = params[1];
+    float p3 = params[2];
+
+    if (tokenEquals(kind, "off") && count == 2) {
+        Serial.println(clearModbusGenerator(address) ? "Generator removed" : "No generator on that address");
+    } else if (tokenEquals(kind, "counter") && count == 3) {
+        setModbusGenerator(address, GEN_COUNTER, p1, 0, 0);
+    } else if (tokenEquals(kind, "ramp") && count == 5) {
+        setModbusGenerator(address, GEN_RAMP, p1, p2, p3);
+    } else if (tokenEquals(kind, "sine") && count == 5) {
+        setModbusGenerator(address, GEN_SINE, p1, p2, p3);
+    } else if (tokenEquals(kind, "noise") && count == 4) {
+        setModbusGenerator(address, GEN_NOISE, p1, p2, 0);
+    } else {
+        Serial.println("Usage: modbus gen <addr> counter <rate> | ramp <min> <max> <period>");
+        Serial.println("       modbus gen <addr> sine <center> <amplitude> <period> | noise <center> <amplitude>");
+        Serial.println("       modbus gen <addr> off | modbus gen list");
+    }
+}
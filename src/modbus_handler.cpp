@@ -1,20 +1,36 @@
 #include "modbus_handler.h"
+#include <Preferences.h>
+#include <freertos/semphr.h>
+#include <freertos/queue.h>
 #include "relay_controller.h"
 #include "dac_controller.h"
-
-// Global variables
-uint16_t regAddresses[numRegisters]; 
-bool dataReady[numRegisters] = {false}; 
-uint64_t u64Values[numRegisters] = {0}; 
-float floatValues[numRegisters] = {0}; 
-int16_t int16Values[numRegisters] = {0}; 
-char regTypes[numRegisters] = {0}; 
+#include "command_handler.h"
+#include "sine_wave_generator.h"
+#include "rs485_serial.h"
+#include "modbus_register_bank.h"
+#include "modbus_profile.h"
+#include "modbus_generator.h"
+#include "modbus_diagnostics.h"
+#include "profiler.h"
+#include "text_command.h"
 
 // Modbus instance
 ModbusRTU mb;
 
-// Configuration status
-bool configDone = false;
+// Modbus task and register lock
+static TaskHandle_t modbusTaskHandle = nullptr;
+static SemaphoreHandle_t modbusMutex = nullptr;
+
+// Response timing
+static volatile uint32_t lastRxEventTime = 0;  // micros() of the last UART RX event
+static ModbusTimingStats timingStats;
+
+// Slave address configuration
+static uint8_t addressBase = MODBUS_ADDRESS_BASE_DEFAULT;
+static uint8_t addressOverride = 0; // 0 = base + jumper ID
+
+// Uptime latched with the register snapshot so both words come from one value
+static uint32_t uptimeSnapshot = 0;
 
 uint16_t lowWord(uint32_t dword) {
     return (uint16_t)(dword & 0xFFFF);
@@ -24,106 +40,742 @@ uint16_t highWord(uint32_t dword) {
     return (uint16_t)(dword >> 16);
 }
 
+/**
+ * UART RX timeout event, once per frame: wake the Modbus task (runs in the
+ * UART event task)
+ */
+static void onModbusReceive() {
+    lastRxEventTime = micros();
+    noteModbusFrameEnd();
+    if (modbusTaskHandle) {
+        xTaskNotifyGive(modbusTaskHandle);
+    }
+}
+
+/**
+ * Request handled: record end-of-frame to response turnaround
+ * The RX event fires MODBUS_RX_TIMEOUT_SYMBOLS character times after the
+ * last byte, so that silence is added back to get the true turnaround.
+ */
+void recordModbusRequestServed() {
+    uint32_t turnaround = micros() - lastRxEventTime + MODBUS_RX_TIMEOUT_US;
+    timingStats.requests++;
+    timingStats.totalUs += turnaround;
+    timingStats.lastUs = turnaround;
+    if (turnaround > timingStats.maxUs) {
+        timingStats.maxUs = turnaround;
+    }
+    if (turnaround > MODBUS_TURNAROUND_BUDGET_US) {
+        timingStats.overBudget++;
+    }
+    recordModbusSuccess();
+}
+
+/**
+ * Library request success callback
+ */
+static Modbus::ResultCode onModbusRequestSuccess(Modbus::FunctionCode fc, const Modbus::RequestData data) {
+    recordModbusRequestServed();
+    return Modbus::EX_SUCCESS;
+}
+
+/**
+ * Modbus RTU task
+ * Sleeps until the UART reports received data, then polls mb.task() every
+ * tick until the frame has been handled so the 3.5 character silent
+ * interval is measured by the library, not by comms task timing.
+ * Staged register values are swapped in before each poll; a request is
+ * parsed and answered within one mb.task() call, so it always sees a
+ * consistent snapshot.
+ */
+static void modbusTask(void* param) {
+    for (;;) {
+        lockModbus();
+        commitRegisterBank();
+        uptimeSnapshot = millis() / 1000;
+        beginModbusDiagnosticsPoll();
+        {
+            PROFILE_ZONE(PROFILE_MODBUS_POLL);
+            mb.task();
+        }
+        endModbusDiagnosticsPoll();
+        unlockModbus();
+
+        if (Serial2.available()) {
+            vTaskDelay(1); // Frame in progress
+        } else {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MODBUS_IDLE_POLL_MS));
+        }
+    }
+}
+
+void lockModbus() {
+    xSemaphoreTakeRecursive(modbusMutex, portMAX_DELAY);
+}
+
+void unlockModbus() {
+    xSemaphoreGiveRecursive(modbusMutex);
+}
+
+const ModbusTimingStats* getModbusTimingStats() {
+    return &timingStats;
+}
+
+void resetModbusTimingStats() {
+    memset(&timingStats, 0, sizeof(timingStats));
+}
+
+/**
+ * Slave address from the current base, jumper ID and override
+ */
+uint8_t getModbusSlaveAddress() {
+    return addressOverride ? addressOverride : addressBase + getCurrentDeviceID();
+}
+
+/**
+ * Check that a base gives a valid address with this unit's jumper ID
+ */
+static bool isValidAddressBase(uint8_t base) {
+    uint16_t address = base + getCurrentDeviceID();
+    return address >= 1 && address <= MODBUS_ADDRESS_MAX;
+}
+
+/**
+ * Switch the slave to the configured address and mirror it in the control map
+ */
+static void applyModbusAddress() {
+    lockModbus();
+    mb.slave(getModbusSlaveAddress());
+    mb.Hreg(MB_CTRL_ADDRESS_BASE, addressBase);
+    mb.Hreg(MB_CTRL_ADDRESS_OVERRIDE, addressOverride);
+    unlockModbus();
+}
+
+/**
+ * Save the address configuration to NVS
+ */
+static void saveModbusAddress() {
+    Preferences prefs;
+    prefs.begin("modbus", false);
+    prefs.putUChar("addrBase", addressBase);
+    prefs.putUChar("addr", addressOverride);
+    prefs.end();
+}
+
+/**
+ * Set the address base (slave address = base + jumper ID)
+ * @param base New base
+ * @return true if the resulting address is valid
+ */
+bool setModbusAddressBase(uint8_t base) {
+    if (!isValidAddressBase(base)) {
+        Serial.printf("Modbus: Base %u with jumper ID %u is not a valid address\n", base, getCurrentDeviceID());
+        return false;
+    }
+    addressBase = base;
+    saveModbusAddress();
+    applyModbusAddress();
+    Serial.printf("Modbus slave address: %u\n", getModbusSlaveAddress());
+    return true;
+}
+
+/**
+ * Set a fixed slave address, or 0 to derive it from the jumper ID again
+ * @param address 1-247, or 0
+ * @return true if the address is valid
+ */
+bool setModbusAddressOverride(uint8_t address) {
+    if (address > MODBUS_ADDRESS_MAX) {
+        Serial.printf("Modbus: Invalid slave address %u\n", address);
+        return false;
+    }
+    addressOverride = address;
+    saveModbusAddress();
+    applyModbusAddress();
+    Serial.printf("Modbus slave address: %u\n", getModbusSlaveAddress());
+    return true;
+}
+
+/**
+ * Load the address configuration from NVS
+ */
+static void loadModbusAddress() {
+    Preferences prefs;
+    prefs.begin("modbus", true);
+    addressBase = prefs.getUChar("addrBase", MODBUS_ADDRESS_BASE_DEFAULT);
+    addressOverride = prefs.getUChar("addr", 0);
+    prefs.end();
+
+    if (addressOverride > MODBUS_ADDRESS_MAX) {
+        addressOverride = 0;
+    }
+    if (!isValidAddressBase(addressBase)) {
+        addressBase = MODBUS_ADDRESS_BASE_DEFAULT;
+    }
+}
+
 void initModbus() {
+    modbusMutex = xSemaphoreCreateRecursiveMutex();
+    loadModbusAddress();
+
     Serial2.begin(BAUDRATE, PARITY, MODBUS_RX_PIN, MODBUS_TX_PIN);
+    Serial2.setRxTimeout(MODBUS_RX_TIMEOUT_SYMBOLS);
+    Serial2.onReceive(onModbusReceive, true);
     mb.begin(&Serial2, TXEN_PIN);
-    mb.slave(SLAVE_ID);
-    Serial.println("Modbus slave initialized on GPIO 16/17");
-    // 新增：Modbus初始化时关闭全部relay
-    for (int i = 1; i <= 6; ++i) {
-        setRelay(i, false);
+    mb.slave(getModbusSlaveAddress());
+    mb.onRequestSuccess(onModbusRequestSuccess);
+    initModbusDiagnostics();
+    initRegisterBank();
+    initModbusGenerators();
+    Serial.printf("Modbus slave initialized on GPIO 16/17, address %u (%s)\n", getModbusSlaveAddress(),
+                  addressOverride ? "fixed" : "base + jumper ID");
+    // Outputs are left as restoreOutputJournal() set them at boot
+
+    initModbusControlMap();
+    initModbusProfiles();
+
+    // Registers are ready; start serving requests
+    xTaskCreatePinnedToCore(modbusTask, "modbus", MODBUS_TASK_STACK, nullptr, MODBUS_TASK_PRIORITY, &modbusTaskHandle, MODBUS_TASK_CORE);
+}
+
+// Output changes requested by the master, applied by the comms task so the
+// Modbus task never blocks on I2C or debug output
+enum ModbusActionType : uint8_t {
+    MB_ACTION_MODE,
+    MB_ACTION_SETPOINT,
+    MB_ACTION_RELAYS,
+    MB_ACTION_WAVE_START,
+    MB_ACTION_WAVE_STOP,
+    MB_ACTION_ADDRESS_BASE,
+    MB_ACTION_ADDRESS_OVERRIDE
+};
+
+struct ModbusControlAction {
+    ModbusActionType type;
+    uint8_t sig;
+    uint16_t value;
+    uint16_t wave[5]; // mode, signal, center, amplitude, period (MB_CTRL_WAVE_*)
+};
+
+static QueueHandle_t controlQueue = nullptr;
+
+/**
+ * Queue an output change for applyModbusControlActions()
+ * @return true if queued
+ */
+static bool queueControlAction(const ModbusControlAction& action) {
+    return controlQueue && xQueueSend(controlQueue, &action, 0) == pdTRUE;
+}
+
+/**
+ * Holding register write: channel mode
+ */
+static uint16_t onSetChannelMode(TRegister* reg, uint16_t val) {
+    ModbusControlAction action = {MB_ACTION_MODE, (uint8_t)((reg->address.address - MB_CTRL_BASE) / 2 + 1), val, {0}};
+    if (val > 1 || !queueControlAction(action)) {
+        return reg->value; // Reject: keep previous value
+    }
+    return val;
+}
+
+/**
+ * Holding register write: channel setpoint
+ */
+static uint16_t onSetChannelSetpoint(TRegister* reg, uint16_t val) {
+    ModbusControlAction action = {MB_ACTION_SETPOINT, (uint8_t)((reg->address.address - MB_CTRL_BASE) / 2 + 1), val, {0}};
+    if (!queueControlAction(action)) {
+        return reg->value;
+    }
+    return val;
+}
+
+/**
+ * Holding register write: relay bitmap
+ */
+static uint16_t onSetRelays(TRegister* reg, uint16_t val) {
+    ModbusControlAction action = {MB_ACTION_RELAYS, 0, (uint16_t)(val & 0x3F), {0}};
+    if (!queueControlAction(action)) {
+        return reg->value;
+    }
+    return val & 0x3F;
+}
+
+/**
+ * Relay bitmap as stored in the relay registers
+ */
+static uint16_t getRelayBitmap() {
+    uint16_t bitmap = 0;
+    for (uint8_t relay = 1; relay <= 6; relay++) {
+        if (getRelayState(relay)) {
+            bitmap |= (1 << (relay - 1));
+        }
+    }
+    return bitmap;
+}
+
+/**
+ * Holding register write: waveform start/stop
+ * Parameters are taken from the waveform holding registers below it.
+ */
+static uint16_t onSetWaveControl(TRegister* reg, uint16_t val) {
+    ModbusControlAction action = {val == 0 ? MB_ACTION_WAVE_STOP : MB_ACTION_WAVE_START, 0, val, {0}};
+    for (uint8_t i = 0; i < 5; i++) {
+        action.wave[i] = mb.Hreg(MB_CTRL_WAVE_MODE + i);
+    }
+    if ((val != 0 && action.wave[0] > 2) || !queueControlAction(action)) {
+        return reg->value;
+    }
+    return val ? 1 : 0;
+}
+
+/**
+ * Holding register write: address base
+ * Usually written as a broadcast; every unit moves to base + its jumper ID.
+ */
+static uint16_t onSetAddressBase(TRegister* reg, uint16_t val) {
+    ModbusControlAction action = {MB_ACTION_ADDRESS_BASE, 0, val, {0}};
+    if (val > 0xFF || !isValidAddressBase(val) || !queueControlAction(action)) {
+        return reg->value;
+    }
+    return val;
+}
+
+/**
+ * Holding register write: fixed address override
+ */
+static uint16_t onSetAddressOverride(TRegister* reg, uint16_t val) {
+    ModbusControlAction action = {MB_ACTION_ADDRESS_OVERRIDE, 0, val, {0}};
+    if (val > MODBUS_ADDRESS_MAX || !queueControlAction(action)) {
+        return reg->value;
+    }
+    return val;
+}
+
+/**
+ * Holding register read: waveform control reflects the generator state
+ */
+static uint16_t onGetWaveControl(TRegister* reg, uint16_t val) {
+    return isSineWaveActive() ? 1 : 0;
+}
+
+/**
+ * Input register read: live status
+ * Also serves reads of the channel and relay holding registers, so changes
+ * made over USB or RS-485 are visible to the master.
+ */
+static uint16_t onGetStatus(TRegister* reg, uint16_t val) {
+    uint16_t offset = reg->address.address - MB_CTRL_BASE;
+    if (offset < 6) {
+        uint8_t sig = offset / 2 + 1;
+        if (offset % 2 == 0) {
+            return signalModes[sig - 1] == 'c' ? 1 : 0;
+        }
+        return (uint16_t)(getSignalValue(sig) * 100 + 0.5f);
+    }
+    switch (reg->address.address) {
+        case MB_CTRL_RELAYS:        return getRelayBitmap();
+        case MB_STATUS_WAVE_ACTIVE: return isSineWaveActive() ? 1 : 0;
+        case MB_STATUS_DEVICE_ID:   return getCurrentDeviceID();
+        case MB_STATUS_UPTIME:      return highWord(uptimeSnapshot);
+        case MB_STATUS_UPTIME + 1:  return lowWord(uptimeSnapshot);
+        case MB_STATUS_SLAVE_ADDRESS: return getModbusSlaveAddress();
     }
-    // 新增：Modbus初始化时关闭所有模拟量输出
-    setVoltageOutput(0.0f);
-    setCurrentOutput(0.0f);
-    // 如果有多通道DAC/电流源，可在此补充全部通道归零
+    return val;
 }
 
-void processInput(String input) {
-    int firstComma = input.indexOf(',');
-    int secondComma = input.indexOf(',', firstComma + 1);
-    int thirdComma = input.indexOf(',', secondComma + 1);
+/**
+ * Apply output changes requested by the master
+ * Runs as the comms task's "modbus_ctl" scheduler job on core 0.
+ */
+void applyModbusControlActions() {
+    PROFILE_ZONE(PROFILE_MODBUS_CTL);
+    static const char waveModes[3] = {'v', 'c', 'd'};
+    ModbusControlAction action;
+    while (controlQueue && xQueueReceive(controlQueue, &action, 0) == pdTRUE) {
+        switch (action.type) {
+            case MB_ACTION_MODE:
+                setSignalMode(action.sig, action.value == 0 ? 'v' : 'c');
+                break;
+            case MB_ACTION_SETPOINT:
+                setSignalValue(action.sig, action.value / 100.0f);
+                break;
+            case MB_ACTION_RELAYS:
+                for (uint8_t relay = 1; relay <= 6; relay++) {
+                    bool state = action.value & (1 << (relay - 1));
+                    if (getRelayState(relay) != state) {
+                        setRelay(relay, state);
+                    }
+                }
+                break;
+            case MB_ACTION_WAVE_START:
+                startSineWave(action.wave[3] / 100.0f, action.wave[4] / 10.0f, action.wave[2] / 100.0f,
+                              action.wave[1], waveModes[action.wave[0]]);
+                break;
+            case MB_ACTION_WAVE_STOP:
+                stopSineWave();
+                break;
+            case MB_ACTION_ADDRESS_BASE:
+                // Applied after the (possibly broadcast) write has been answered
+                if (action.value != addressBase) {
+                    setModbusAddressBase(action.value);
+                }
+                break;
+            case MB_ACTION_ADDRESS_OVERRIDE:
+                if (action.value != addressOverride) {
+                    setModbusAddressOverride(action.value);
+                }
+                break;
+        }
+    }
+}
+
+/**
+ * Register the live control/status map and its callbacks
+ */
+void initModbusControlMap() {
+    controlQueue = xQueueCreate(MODBUS_CONTROL_QUEUE_SIZE, sizeof(ModbusControlAction));
+    for (uint8_t sig = 1; sig <= 3; sig++) {
+        mb.addHreg(MB_CTRL_CHANNEL_MODE(sig), signalModes[sig - 1] == 'c' ? 1 : 0);
+        mb.addHreg(MB_CTRL_CHANNEL_SETPOINT(sig), 0);
+        mb.onSetHreg(MB_CTRL_CHANNEL_MODE(sig), onSetChannelMode);
+        mb.onSetHreg(MB_CTRL_CHANNEL_SETPOINT(sig), onSetChannelSetpoint);
+    }
+    mb.addHreg(MB_CTRL_RELAYS, 0);
+    mb.onSetHreg(MB_CTRL_RELAYS, onSetRelays);
+    mb.onGetHreg(MB_CTRL_BASE, onGetStatus, 7);
+
+    mb.addHreg(MB_CTRL_WAVE_MODE, 0, 6);
+    mb.Hreg(MB_CTRL_WAVE_SIGNAL, 1);
+    mb.Hreg(MB_CTRL_WAVE_PERIOD, 10);
+    mb.onSetHreg(MB_CTRL_WAVE_CONTROL, onSetWaveControl);
+    mb.onGetHreg(MB_CTRL_WAVE_CONTROL, onGetWaveControl);
+
+    mb.addHreg(MB_CTRL_ADDRESS_BASE, addressBase);
+    mb.addHreg(MB_CTRL_ADDRESS_OVERRIDE, addressOverride);
+    mb.onSetHreg(MB_CTRL_ADDRESS_BASE, onSetAddressBase);
+    mb.onSetHreg(MB_CTRL_ADDRESS_OVERRIDE, onSetAddressOverride);
+
+    mb.addIreg(MB_CTRL_BASE, 0, MB_STATUS_IREG_COUNT);
+    mb.onGetIreg(MB_CTRL_BASE, onGetStatus, MB_STATUS_IREG_COUNT);
+
+    Serial.printf("Modbus control map at 0x%04X (holding) / status at 0x%04X (input)\n", MB_CTRL_BASE, MB_CTRL_BASE);
+}
+
+static void processBankCommand(char* input);
+
+// Register parsed from a "modbus load" line, waiting for the bank swap
+struct StagedRegister {
+    uint64_t raw;
+    uint16_t address;
+    char type;
+    uint8_t order;
+};
+
+// Profile being staged by "modbus load"; allocated only while a load spans lines
+static StagedRegister* loadStage = nullptr;
+static uint16_t loadStageCount = 0;
+static uint16_t loadStageFailed = 0;
+
+/**
+ * Parse "<type>[/<order>]" and "<value>" fields
+ * @param typeSpec Type letter, optionally followed by "/ABCD", "/CDAB", "/BADC" or "/DCBA"
+ * @return true on success
+ */
+static bool parseRegisterSpec(const char* typeSpec, const char* valueStr, char* type, uint64_t* raw,
+                              uint8_t* order) {
+    *type = typeSpec[0];
+    *order = MB_ORDER_ABCD;
+    if (*type != '\0' && typeSpec[1] != '\0' &&
+        (typeSpec[1] != '/' || !parseWordOrder(typeSpec + 2, order))) {
+        Serial.println("Invalid word order. Use ABCD, CDAB, BADC or DCBA.");
+        return false;
+    }
+    if (!parseRegisterValue(*type, valueStr, raw)) {
+        Serial.println("Invalid type or value. Use I, U, F, or S.");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Define one register from "<addr>,<type>[/<order>],<value>" style fields
+ * @param typeSpec Type letter, optionally followed by "/ABCD", "/CDAB", "/BADC" or "/DCBA"
+ * @return true on success
+ */
+static bool defineRegisterFromText(uint16_t address, const char* typeSpec, const char* valueStr) {
+    char type;
+    uint64_t raw;
+    uint8_t order;
+    if (!parseRegisterSpec(typeSpec, valueStr, &type, &raw, &order)) {
+        return false;
+    }
+    lockModbus();
+    bool defined = defineRegister(address, type, raw, order);
+    unlockModbus();
+    return defined;
+}
+
+void processInput(char* input) {
+    // The Modbus lock is taken only around bank layout changes; listing,
+    // printing and file I/O run without it so the slave keeps answering
+    processBankCommand(input);
+}
+
+/**
+ * Parse a register address field
+ */
+static bool parseRegisterAddress(const char* text, uint16_t* address) {
+    uint32_t value;
+    if (!parseTextUint(text, &value) || value > 0xFFFF) {
+        return false;
+    }
+    *address = value;
+    return true;
+}
+
+/**
+ * Drop a profile staged by "modbus load" lines ending in '\'
+ */
+static void discardLoadStage() {
+    free(loadStage);
+    loadStage = nullptr;
+    loadStageCount = 0;
+    loadStageFailed = 0;
+}
 
-    if (firstComma == -1 || secondComma == -1 || thirdComma == -1) {
+/**
+ * Parse "<addr>:<type>:<value>;..." items into the load stage
+ * @return false if the stage could not be allocated
+ */
+static bool stageLoadItems(char* text) {
+    if (!loadStage) {
+        loadStage = (StagedRegister*)malloc(MB_BANK_CAPACITY * sizeof(StagedRegister));
+        if (!loadStage) {
+            Serial.println("Out of memory");
+            return false;
+        }
+    }
+    TextCursor items = {text};
+    char* item;
+    while ((item = nextToken(&items, "; \t")) != nullptr) {
+        TextCursor fields = {item};
+        char* addressText = nextToken(&fields, ":");
+        char* typeSpec = nextToken(&fields, ":");
+        char* valueStr = nextToken(&fields, ":");
+        StagedRegister* staged = &loadStage[loadStageCount];
+        if (loadStageCount < MB_BANK_CAPACITY && valueStr && !nextToken(&fields, ":") &&
+            parseRegisterAddress(addressText, &staged->address) &&
+            parseRegisterSpec(typeSpec, valueStr, &staged->type, &staged->raw, &staged->order)) {
+            loadStageCount++;
+        } else {
+            loadStageFailed++;
+        }
+    }
+    return true;
+}
+
+/**
+ * Replace the bank with the staged profile
+ * Swapped in under the Modbus lock, as loadModbusProfile() does, so a master
+ * never sees half a profile.
+ */
+static void commitLoadStage() {
+    uint16_t loaded = 0;
+    uint16_t failed = loadStageFailed;
+    lockModbus();
+    clearRegisterBank();
+    for (uint16_t i = 0; i < loadStageCount; i++) {
+        const StagedRegister& staged = loadStage[i];
+        if (defineRegister(staged.address, staged.type, staged.raw, staged.order)) {
+            loaded++;
+        } else {
+            failed++;
+        }
+    }
+    unlockModbus();
+    discardLoadStage();
+    Serial.printf("Profile loaded: %u registers, %u errors\n", loaded, failed);
+}
+
+/**
+ * Handle a single register definition: [<reg>,]<addr>,<type>,<value>
+ */
+static void processRegisterDefinition(char* input) {
+    TextCursor cursor = {input};
+    char* fields[4];
+    uint8_t count = 0;
+    char* field;
+    while (count < 4 && (field = nextToken(&cursor, ", \t")) != nullptr) {
+        fields[count++] = field;
+    }
+    if (count < 3 || nextToken(&cursor, ", \t")) {
         Serial.println("Invalid command format.");
         return;
     }
 
-    String regIndexStr = input.substring(0, firstComma);
-    int regIndex = regIndexStr.toInt();
+    // Legacy form has a register slot index in front
+    uint8_t first = count == 4 ? 1 : 0;
+    uint16_t regAddress;
+    if (!parseRegisterAddress(fields[first], &regAddress)) {
+        Serial.println("Invalid register address.");
+        return;
+    }
+    const char* typeSpec = fields[first + 1];
+    const char* valueStr = fields[first + 2];
+    Serial.printf("Received Command for Address: %u, Type: %s, Value: %s\n", regAddress, typeSpec, valueStr);
 
-    if (regIndex < 0 || regIndex >= numRegisters) {
-        Serial.println("Invalid register index.");
+    if (defineRegisterFromText(regAddress, typeSpec, valueStr)) {
+        Serial.println("Register updated");
+    }
+}
+
+/**
+ * Handle one register bank command (console task)
+ */
+static void processBankCommand(char* input) {
+    if (strchr(input, ',')) {
+        processRegisterDefinition(input);
         return;
     }
 
-    String regAddressStr = input.substring(firstComma + 1, secondComma);
-    uint16_t regAddress = regAddressStr.toInt();
-
-    char type = input.charAt(secondComma + 1);
-    String valueStr = input.substring(thirdComma + 1);
-    Serial.print("Received Command for Reg: ");
-    Serial.print(regIndex);
-    Serial.print(", Address: ");
-    Serial.print(regAddress);
-    Serial.print(", Type: ");
-    Serial.print(type);
-    Serial.print(", Value: ");
-    Serial.println(valueStr);
-
-    regAddresses[regIndex] = regAddress;
-    regTypes[regIndex] = type;
-
-    switch (type) {
-        case 'I':
-            u64Values[regIndex] = (uint64_t)valueStr.toInt();
-            break;
-        case 'F':
-            floatValues[regIndex] = valueStr.toFloat();
-            break;
-        case 'S':
-            int16Values[regIndex] = (int16_t)valueStr.toInt();
-            break;
-        default:
-            Serial.println("Invalid type. Use I, F, or S.");
-            return;
+    TextCursor cursor = {input};
+    char* command = nextToken(&cursor);
+
+    if (tokenEquals(command, "timing")) {
+        const ModbusTimingStats* stats = getModbusTimingStats();
+        Serial.printf("Modbus turnaround: %lu requests, avg %luus, max %luus, last %luus, %lu over %uus\n",
+                      (unsigned long)stats->requests,
+                      (unsigned long)(stats->requests ? stats->totalUs / stats->requests : 0),
+                      (unsigned long)stats->maxUs, (unsigned long)stats->lastUs,
+                      (unsigned long)stats->overBudget, MODBUS_TURNAROUND_BUDGET_US);
+        if (tokenEquals(nextToken(&cursor), "reset")) {
+            lockModbus();
+            resetModbusTimingStats();
+            unlockModbus();
+        }
+        return;
     }
-    dataReady[regIndex] = true;
-
-    // Check if all data is ready and update the registers
-    bool allReady = true;
-    for (int i = 0; i < numRegisters; i++) {
-        if (!dataReady[i]) {
-            allReady = false;
-            break;
-        }
-    }
-
-    uint32_t asInt = 0; // Initialize outside of the switch scope
-
-    if (allReady) {
-        for (int i = 0; i < numRegisters; i++) {
-            switch (regTypes[i]) {
-                case 'I':
-                    mb.addHreg(regAddresses[i], 0x01, 2);
-                    mb.Hreg(regAddresses[i], highWord(u64Values[i]));
-                    mb.Hreg(regAddresses[i] + 1, lowWord(u64Values[i]));
-                    break;
-                case 'F':
-                    asInt = *(uint32_t*)&floatValues[i];
-                    mb.addHreg(regAddresses[i], 0x01, 2);
-                    mb.Hreg(regAddresses[i], highWord(asInt));
-                    mb.Hreg(regAddresses[i] + 1, lowWord(asInt));
-                    break;
-                case 'S':
-                    mb.addHreg(regAddresses[i], 0x01, 1);
-                    mb.Hreg(regAddresses[i], (uint16_t)int16Values[i]);
-                    break;
+
+    if (tokenEquals(command, "diag")) {
+        printModbusDiagnostics();
+        if (tokenEquals(nextToken(&cursor), "reset")) {
+            lockModbus();
+            resetModbusDiagnostics();
+            unlockModbus();
+        }
+        return;
+    }
+
+    if (tokenEquals(command, "address")) {
+        // address, address base <n>, address set <n>, address auto
+        char* action = nextToken(&cursor);
+        char* arg = nextToken(&cursor);
+        uint32_t value;
+        if (tokenEquals(action, "base")) {
+            if (!parseTextUint(arg, &value) || value > MODBUS_ADDRESS_MAX || !setModbusAddressBase(value)) {
+                Serial.println("Usage: modbus address base <n> (base + jumper ID must be 1-247)");
+            }
+        } else if (tokenEquals(action, "set")) {
+            if (!parseTextUint(arg, &value) || value < 1 || value > MODBUS_ADDRESS_MAX ||
+                !setModbusAddressOverride(value)) {
+                Serial.println("Usage: modbus address set <1-247>");
             }
-            dataReady[i] = false; // Reset after processing
+        } else if (tokenEquals(action, "auto") && !arg) {
+            setModbusAddressOverride(0);
+        } else if (!action) {
+            Serial.printf("Modbus slave address: %u (base %u + jumper ID %u%s)\n", getModbusSlaveAddress(),
+                          addressBase, getCurrentDeviceID(), addressOverride ? ", overridden" : "");
+        } else {
+            Serial.println("Usage: modbus address [base <n> | set <n> | auto]");
         }
-        Serial.println("All registers updated");
+        return;
+    }
+
+    if (tokenEquals(command, "clear")) {
+        discardLoadStage();
+        lockModbus();
+        clearRegisterBank();
+        unlockModbus();
+        Serial.println("Register bank cleared");
+        return;
+    }
+
+    if (tokenEquals(command, "list")) {
+        Serial.printf("Register bank: %u entries\n", getRegisterCount());
+        ModbusRegisterEntry entry;
+        for (uint16_t i = 0; copyRegisterEntry(i, &entry); i++) {
+            const char* order = wordOrderName(entry.order);
+            if (entry.type == 'F') {
+                Serial.printf("  %u F/%s %g\n", entry.address, order, getRegisterNumber(&entry));
+            } else if (entry.type == 'S') {
+                Serial.printf("  %u S/%s %d\n", entry.address, order, (int16_t)entry.raw);
+            } else {
+                Serial.printf("  %u %c/%s %llu\n", entry.address, entry.type, order, (unsigned long long)entry.raw);
+            }
+        }
+        return;
     }
+
+    if (tokenEquals(command, "profile")) {
+        // profile save|load|delete|default <name>, profile list, profile default
+        char* action = nextToken(&cursor);
+        const char* name = remainingText(&cursor);
+        if (tokenEquals(action, "save")) {
+            saveModbusProfile(name);
+        } else if (tokenEquals(action, "load")) {
+            loadModbusProfile(name);
+        } else if (tokenEquals(action, "delete")) {
+            Serial.println(deleteModbusProfile(name) ? "Profile deleted" : "No such profile");
+        } else if (tokenEquals(action, "default")) {
+            setDefaultModbusProfile(name);
+        } else if (tokenEquals(action, "list")) {
+            listModbusProfiles();
+        } else {
+            Serial.println("Usage: modbus profile save|load|delete|default <name>, modbus profile list");
+        }
+        return;
+    }
+
+    if (tokenEquals(command, "gen")) {
+        parseModbusGeneratorCommand(remainingText(&cursor));
+        return;
+    }
+
+    if (tokenEquals(command, "del")) {
+        uint16_t address;
+        if (!parseRegisterAddress(nextToken(&cursor), &address)) {
+            Serial.println("Usage: modbus del <addr>");
+            return;
+        }
+        lockModbus();
+        bool removed = removeRegister(address);
+        unlockModbus();
+        Serial.println(removed ? "Register removed" : "No register at that address");
+        return;
+    }
+
+    if (tokenEquals(command, "load")) {
+        // Bulk profile: <addr>:<type>:<value>;<addr>:<type>:<value>;...
+        // A line ending in '\' continues on the next load line, so a profile
+        // longer than TEXT_LINE_MAX still replaces the bank in one step
+        char* items = remainingText(&cursor);
+        size_t length = strlen(items);
+        bool continued = length > 0 && items[length - 1] == '\\';
+        if (continued) {
+            items[length - 1] = '\0';
+        }
+        if (!stageLoadItems(items)) {
+            return;
+        }
+        if (continued) {
+            Serial.printf("Profile staged: %u registers, %u errors so far\n", loadStageCount, loadStageFailed);
+            return;
+        }
+        commitLoadStage();
+        return;
+    }
+
+    Serial.println("Invalid command format.");
 }
 
 // Commented out functions as per original code
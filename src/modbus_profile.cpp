@@ -0,0 +1,272 @@
+#include "modbus_profile.h"
+#include "modbus_register_bank.h"
+#include "modbus_handler.h"
+#include <LittleFS.h>
+#include <Preferences.h>
+
+// Version 2 adds a word order byte to each record; version 1 files load as ABCD
+static const uint8_t profileMagic[4] = {'M', 'B', 'P', '2'};
+static const uint8_t profileMagicV1[4] = {'M', 'B', 'P', '1'};
+static bool profilesMounted = false;
+
+/**
+ * CRC-16/MODBUS, continued from a previous value
+ */
+static uint16_t updateCrc16(uint16_t crc, const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+        }
+    }
+    return crc;
+}
+
+/**
+ * Build "/profiles/<name>.bin", rejecting unsafe names
+ * @return true if the name is valid
+ */
+static bool profilePath(const char* name, char* path, size_t size) {
+    size_t length = strlen(name);
+    if (length == 0 || length > MB_PROFILE_NAME_MAX) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        char c = name[i];
+        if (!isalnum((unsigned char)c) && c != '_' && c != '-') {
+            return false;
+        }
+    }
+    snprintf(path, size, "/profiles/%s.bin", name);
+    return true;
+}
+
+/**
+ * Value bytes stored for a register type
+ */
+static uint8_t profileValueSize(char type) {
+    return registerTypeWords(type) * 2;
+}
+
+/**
+ * Mount the profile filesystem and load the default profile, if any
+ */
+void initModbusProfiles() {
+    profilesMounted = LittleFS.begin(true);
+    if (!profilesMounted) {
+        Serial.println("Modbus profiles: LittleFS mount failed");
+        return;
+    }
+    LittleFS.mkdir("/profiles");
+
+    char name[MB_PROFILE_NAME_MAX + 1] = {0};
+    Preferences prefs;
+    prefs.begin("modbus", true);
+    prefs.getString("profile", name, sizeof(name));
+    prefs.end();
+
+    if (name[0] != '\0') {
+        unsigned long start = millis();
+        if (loadModbusProfile(name)) {
+            Serial.printf("Modbus profile '%s' restored in %lums\n", name, millis() - start);
+        }
+    }
+}
+
+/**
+ * Save the current register bank as a named profile
+ */
+bool saveModbusProfile(const char* name) {
+    char path[32];
+    if (!profilesMounted || !profilePath(name, path, sizeof(path))) {
+        Serial.println("Modbus profiles: Invalid profile name or filesystem not mounted");
+        return false;
+    }
+
+    // Written beside the old file and renamed over it, so a reset mid-save
+    // leaves either the old or the new profile, never a truncated one
+    char tempPath[32];
+    snprintf(tempPath, sizeof(tempPath), "/profiles/%s.tmp", name);
+    File file = LittleFS.open(tempPath, "w");
+    if (!file) {
+        Serial.printf("Modbus profiles: Cannot create %s\n", tempPath);
+        return false;
+    }
+    size_t expected = 0;
+    size_t written = 0;
+
+    uint16_t count = getRegisterCount();
+    uint8_t header[6];
+    memcpy(header, profileMagic, 4);
+    header[4] = count & 0xFF;
+    header[5] = count >> 8;
+    uint16_t crc = updateCrc16(0xFFFF, header, sizeof(header));
+    expected += sizeof(header);
+    written += file.write(header, sizeof(header));
+
+    for (uint16_t i = 0; i < count; i++) {
+        ModbusRegisterEntry entry;
+        copyRegisterEntry(i, &entry);
+        uint8_t record[12];
+        record[0] = entry.address & 0xFF;
+        record[1] = entry.address >> 8;
+        record[2] = entry.type;
+        record[3] = entry.order;
+        uint8_t valueSize = profileValueSize(entry.type);
+        for (uint8_t b = 0; b < valueSize; b++) {
+            record[4 + b] = (entry.raw >> (8 * b)) & 0xFF;
+        }
+        crc = updateCrc16(crc, record, 4 + valueSize);
+        expected += 4 + valueSize;
+        written += file.write(record, 4 + valueSize);
+    }
+
+    uint8_t trailer[2] = {(uint8_t)(crc & 0xFF), (uint8_t)(crc >> 8)};
+    expected += sizeof(trailer);
+    written += file.write(trailer, sizeof(trailer));
+    file.close();
+
+    if (written != expected || !LittleFS.rename(tempPath, path)) {
+        LittleFS.remove(tempPath);
+        Serial.printf("Modbus profiles: Cannot write %s\n", path);
+        return false;
+    }
+
+    Serial.printf("Modbus profile '%s' saved: %u registers\n", name, count);
+    return true;
+}
+
+/**
+ * Replace the register bank with a named profile
+ * The file is verified before the bank is touched.
+ */
+bool loadModbusProfile(const char* name) {
+    char path[32];
+    if (!profilesMounted || !profilePath(name, path, sizeof(path))) {
+        Serial.println("Modbus profiles: Invalid profile name or filesystem not mounted");
+        return false;
+    }
+
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        Serial.printf("Modbus profiles: '%s' not found\n", name);
+        return false;
+    }
+
+    // Read the whole image; profiles are at most ~14 KB
+    size_t size = file.size();
+    uint8_t* image = (uint8_t*)malloc(size);
+    if (!image) {
+        file.close();
+        Serial.println("Modbus profiles: Out of memory");
+        return false;
+    }
+    size_t readBytes = file.read(image, size);
+    file.close();
+
+    bool version1 = size >= 8 && memcmp(image, profileMagicV1, 4) == 0;
+    bool valid = readBytes == size && size >= 8 && (version1 || memcmp(image, profileMagic, 4) == 0) &&
+                 updateCrc16(0xFFFF, image, size - 2) == (uint16_t)(image[size - 2] | (image[size - 1] << 8));
+    if (!valid) {
+        free(image);
+        Serial.printf("Modbus profiles: '%s' is corrupt\n", name);
+        return false;
+    }
+
+    // Swapped in under the Modbus lock so a master never sees half a profile
+    lockModbus();
+    clearRegisterBank();
+    uint16_t count = image[4] | (image[5] << 8);
+    size_t pos = 6;
+    size_t headerSize = version1 ? 3 : 4;
+    uint16_t loaded = 0;
+    for (uint16_t i = 0; i < count && pos + headerSize <= size - 2; i++) {
+        uint16_t address = image[pos] | (image[pos + 1] << 8);
+        char type = image[pos + 2];
+        uint8_t order = version1 ? (uint8_t)MB_ORDER_ABCD : image[pos + 3];
+        uint8_t valueSize = profileValueSize(type);
+        if (version1 && type == 'U') {
+            valueSize = 0; // Not a version 1 type
+        }
+        pos += headerSize;
+        if (valueSize == 0 || pos + valueSize > size - 2) {
+            break;
+        }
+        uint64_t raw = 0;
+        for (uint8_t b = 0; b < valueSize; b++) {
+            raw |= (uint64_t)image[pos + b] << (8 * b);
+        }
+        pos += valueSize;
+        if (version1 && type == 'I') {
+            // Version 1 'I' was a 2-register value stored in 8 bytes; keep its layout
+            type = 'U';
+            raw &= 0xFFFFFFFF;
+        }
+        if (defineRegister(address, type, raw, order)) {
+            loaded++;
+        }
+    }
+    unlockModbus();
+    free(image);
+
+    Serial.printf("Modbus profile '%s' loaded: %u registers\n", name, loaded);
+    return loaded == count;
+}
+
+/**
+ * Delete a named profile
+ */
+bool deleteModbusProfile(const char* name) {
+    char path[32];
+    if (!profilesMounted || !profilePath(name, path, sizeof(path)) || !LittleFS.exists(path)) {
+        return false;
+    }
+    return LittleFS.remove(path);
+}
+
+/**
+ * Print stored profiles to the USB serial port
+ */
+void listModbusProfiles() {
+    if (!profilesMounted) {
+        Serial.println("Modbus profiles: Filesystem not mounted");
+        return;
+    }
+
+    char defaultName[MB_PROFILE_NAME_MAX + 1] = {0};
+    Preferences prefs;
+    prefs.begin("modbus", true);
+    prefs.getString("profile", defaultName, sizeof(defaultName));
+    prefs.end();
+
+    Serial.println("Modbus profiles:");
+    File dir = LittleFS.open("/profiles");
+    File file = dir.openNextFile();
+    while (file) {
+        Serial.printf("  %s (%u bytes)\n", file.name(), (unsigned)file.size());
+        file = dir.openNextFile();
+    }
+    Serial.printf("Default: %s\n", defaultName[0] ? defaultName : "(none)");
+}
+
+/**
+ * Select the profile loaded at boot
+ */
+bool setDefaultModbusProfile(const char* name) {
+    char path[32];
+    if (name[0] != '\0' && !profilePath(name, path, sizeof(path))) {
+        Serial.println("Modbus profiles: Invalid profile name");
+        return false;
+    }
+
+    Preferences prefs;
+    prefs.begin("modbus", false);
+    if (name[0] == '\0') {
+        prefs.remove("profile");
+    } else {
+        prefs.putString("profile", name);
+    }
+    prefs.end();
+    Serial.printf("Default Modbus profile: %s\n", name[0] ? name : "(none)");
+    return true;
+}
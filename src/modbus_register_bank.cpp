@@ -0,0 +1,450 @@
+#include "modbus_register_bank.h"
+#include "modbus_handler.h"
+#include "text_command.h"
+
+// Sorted entry storage
+static ModbusRegisterEntry registerBank[MB_BANK_CAPACITY];
+static uint16_t registerCount = 0;
+
+// Guards entry values between producers and the snapshot swap
+static portMUX_TYPE bankMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool bankDirty = false;
+
+static const char* const wordOrderNames[] = {"ABCD", "CDAB", "BADC", "DCBA"};
+
+/**
+ * Initialize register bank (empty)
+ */
+void initRegisterBank() {
+    registerCount = 0;
+}
+
+/**
+ * Get number of holding registers used by a type
+ */
+uint8_t registerTypeWords(char type) {
+    switch (type) {
+        case 'I': return 4;
+        case 'U': return 2;
+        case 'F': return 2;
+        case 'S': return 1;
+        default:  return 0;
+    }
+}
+
+/**
+ * Parse a word order name
+ */
+bool parseWordOrder(const char* text, uint8_t* order) {
+    for (uint8_t i = 0; i < 4; i++) {
+        if (strcasecmp(text, wordOrderNames[i]) == 0) {
+            *order = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Get the name of a word order
+ */
+const char* wordOrderName(uint8_t order) {
+    return order < 4 ? wordOrderNames[order] : "?";
+}
+
+/**
+ * Binary search for the first entry with address >= target
+ * @return Position in registerBank
+ */
+static uint16_t lowerBound(uint16_t address) {
+    uint16_t lo = 0;
+    uint16_t hi = registerCount;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        if (registerBank[mid].address < address) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * Find the entry at an address
+ */
+ModbusRegisterEntry* findRegister(uint16_t address) {
+    uint16_t pos = lowerBound(address);
+    if (pos < registerCount && registerBank[pos].address == address) {
+        return &registerBank[pos];
+    }
+    return nullptr;
+}
+
+/**
+ * Encode an entry's value into holding register words in its word order
+ * Word 0 of ABCD carries the most significant 16 bits.
+ */
+void encodeRegisterWords(const ModbusRegisterEntry* entry, uint16_t* words) {
+    uint8_t count = entry->words;
+    bool swapWords = entry->order == MB_ORDER_CDAB || entry->order == MB_ORDER_DCBA;
+    bool swapBytes = entry->order == MB_ORDER_BADC || entry->order == MB_ORDER_DCBA;
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t significance = swapWords ? i : count - 1 - i;
+        uint16_t word = (uint16_t)(entry->raw >> (16 * significance));
+        words[i] = swapBytes ? (uint16_t)((word << 8) | (word >> 8)) : word;
+    }
+}
+
+/**
+ * Find the entry covering a holding register
+ * @return Entry, or nullptr if the word is not part of any entry
+ */
+static ModbusRegisterEntry* findRegisterCovering(uint16_t address) {
+    uint16_t pos = lowerBound(address + 1);
+    if (pos == 0) {
+        return nullptr;
+    }
+    ModbusRegisterEntry* entry = &registerBank[pos - 1];
+    return (uint32_t)entry->address + entry->words > address ? entry : nullptr;
+}
+
+/**
+ * Replace one holding register word of an entry's value
+ * The word is mapped back through the entry's word order, the inverse of
+ * encodeRegisterWords().
+ */
+static void writeRegisterWord(ModbusRegisterEntry* entry, uint8_t index, uint16_t word) {
+    bool swapWords = entry->order == MB_ORDER_CDAB || entry->order == MB_ORDER_DCBA;
+    bool swapBytes = entry->order == MB_ORDER_BADC || entry->order == MB_ORDER_DCBA;
+    uint8_t significance = swapWords ? index : entry->words - 1 - index;
+    if (swapBytes) {
+        word = (uint16_t)((word << 8) | (word >> 8));
+    }
+    uint64_t raw = entry->raw;
+    if (entry->type == 'S') {
+        raw = (uint64_t)(int64_t)(int16_t)word;
+    } else {
+        raw &= ~(0xFFFFull << (16 * significance));
+        raw |= (uint64_t)word << (16 * significance);
+    }
+    setRegisterRaw(entry, raw);
+}
+
+/**
+ * Set an entry's value bits
+ */
+void setRegisterRaw(ModbusRegisterEntry* entry, uint64_t raw) {
+    portENTER_CRITICAL(&bankMux);
+    entry->raw = raw;
+    entry->dirty = true;
+    bankDirty = true;
+    portEXIT_CRITICAL(&bankMux);
+}
+
+/**
+ * Publish changed entries to the master
+ * Runs between master transactions, so every request sees each value
+ * either entirely before or entirely after an update.
+ */
+uint16_t commitRegisterBank() {
+    if (!bankDirty) {
+        return 0;
+    }
+    bankDirty = false; // Updates from here on are picked up by the next commit
+
+    uint16_t published = 0;
+    for (uint16_t i = 0; i < registerCount; i++) {
+        if (!registerBank[i].dirty) {
+            continue;
+        }
+        portENTER_CRITICAL(&bankMux);
+        registerBank[i].front = registerBank[i].raw;
+        registerBank[i].dirty = false;
+        portEXIT_CRITICAL(&bankMux);
+        published++;
+    }
+    return published;
+}
+
+/**
+ * Decode an entry's value as a number
+ */
+double getRegisterNumber(const ModbusRegisterEntry* entry) {
+    switch (entry->type) {
+        case 'F': {
+            float value;
+            uint32_t bits = (uint32_t)entry->raw;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+        case 'S':
+            return (int16_t)entry->raw;
+        default:
+            return (double)entry->raw;
+    }
+}
+
+/**
+ * Set an entry's value from a number, saturating to the type's range
+ */
+void setRegisterNumber(ModbusRegisterEntry* entry, double value) {
+    uint64_t raw;
+    switch (entry->type) {
+        case 'F': {
+            float f = (float)value;
+            uint32_t bits;
+            memcpy(&bits, &f, sizeof(bits));
+            raw = bits;
+            break;
+        }
+        case 'S':
+            if (value < -32768.0) value = -32768.0;
+            if (value > 32767.0) value = 32767.0;
+            raw = (uint64_t)(int64_t)(int16_t)lround(value);
+            break;
+        case 'U':
+            if (value > 4294967295.0) value = 4294967295.0;
+            raw = value < 0 ? 0 : (uint32_t)value;
+            break;
+        default:
+            if (value >= 18446744073709551615.0) {
+                raw = UINT64_MAX;
+            } else {
+                raw = value < 0 ? 0 : (uint64_t)value;
+            }
+            break;
+    }
+    setRegisterRaw(entry, raw);
+}
+
+/**
+ * Define a register or update an existing one
+ */
+bool defineRegister(uint16_t address, char type, uint64_t raw, uint8_t order) {
+    uint8_t words = registerTypeWords(type);
+    if (words == 0 || order > MB_ORDER_DCBA) {
+        return false;
+    }
+    if ((uint32_t)address + words > MB_CTRL_BASE) {
+        Serial.printf("Modbus: Address %u is reserved for the control map\n", address);
+        return false;
+    }
+
+    uint16_t pos = lowerBound(address);
+
+    // Update in place
+    if (pos < registerCount && registerBank[pos].address == address) {
+        if (registerBank[pos].type != type) {
+            Serial.printf("Modbus: Address %u already defined as type %c\n", address, registerBank[pos].type);
+            return false;
+        }
+        registerBank[pos].order = order;
+        setRegisterRaw(&registerBank[pos], raw);
+        return true;
+    }
+
+    // New entry: check overlap with neighbours and capacity
+    if (pos > 0) {
+        const ModbusRegisterEntry& prev = registerBank[pos - 1];
+        if ((uint32_t)prev.address + prev.words > address) {
+            Serial.printf("Modbus: Address %u overlaps register at %u\n", address, prev.address);
+            return false;
+        }
+    }
+    if (pos < registerCount && (uint32_t)address + words > registerBank[pos].address) {
+        Serial.printf("Modbus: Address %u overlaps register at %u\n", address, registerBank[pos].address);
+        return false;
+    }
+    if (registerCount >= MB_BANK_CAPACITY) {
+        Serial.println("Modbus: Register bank full");
+        return false;
+    }
+
+    memmove(&registerBank[pos + 1], &registerBank[pos], (registerCount - pos) * sizeof(ModbusRegisterEntry));
+    ModbusRegisterEntry& entry = registerBank[pos];
+    entry.address = address;
+    entry.type = type;
+    entry.words = words;
+    entry.order = order;
+    entry.dirty = false;
+    entry.raw = raw;
+    entry.front = raw; // No previous value to tear, so it is published directly
+    registerCount++;
+    return true;
+}
+
+/**
+ * Parse a text value for a register type
+ */
+bool parseRegisterValue(char type, const char* text, uint64_t* raw) {
+    switch (type) {
+        case 'I': {
+            char* end;
+            *raw = strtoull(text, &end, 0);
+            return *text != '\0' && *text != '-' && *end == '\0';
+        }
+        case 'U': {
+            uint32_t value;
+            if (!parseTextUint(text, &value)) {
+                return false;
+            }
+            *raw = value;
+            return true;
+        }
+        case 'F': {
+            // strtof goes through newlib's allocating strtod
+            float value;
+            if (!parseTextFloat(text, &value)) {
+                return false;
+            }
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            *raw = bits;
+            return true;
+        }
+        case 'S': {
+            // Signed, or the raw 16-bit pattern (e.g. 0xFFFF)
+            int32_t value;
+            if (!parseTextInt(text, &value) || value < INT16_MIN || value > UINT16_MAX) {
+                return false;
+            }
+            *raw = (uint64_t)(int64_t)(int16_t)value;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+/**
+ * Remove the entry at an address
+ */
+bool removeRegister(uint16_t address) {
+    uint16_t pos = lowerBound(address);
+    if (pos >= registerCount || registerBank[pos].address != address) {
+        return false;
+    }
+    memmove(&registerBank[pos], &registerBank[pos + 1], (registerCount - pos - 1) * sizeof(ModbusRegisterEntry));
+    registerCount--;
+    return true;
+}
+
+/**
+ * Remove every entry
+ */
+void clearRegisterBank() {
+    registerCount = 0;
+}
+
+/**
+ * Get number of entries
+ */
+uint16_t getRegisterCount() {
+    return registerCount;
+}
+
+/**
+ * Get entry by position (ascending address order)
+ */
+ModbusRegisterEntry* getRegisterEntry(uint16_t index) {
+    return index < registerCount ? &registerBank[index] : nullptr;
+}
+
+/**
+ * Copy an entry by position with a consistent value
+ */
+bool copyRegisterEntry(uint16_t index, ModbusRegisterEntry* out) {
+    if (index >= registerCount) {
+        return false;
+    }
+    portENTER_CRITICAL(&bankMux);
+    *out = registerBank[index];
+    portEXIT_CRITICAL(&bankMux);
+    return true;
+}
+
+/**
+ * Answer a holding register request from the bank (Modbus task, raw hook)
+ * Only requests that lie entirely below the control map are taken; every
+ * word must belong to an entry, as with the library's own registers.
+ */
+Modbus::ResultCode serveRegisterBankRequest(uint8_t* pdu, uint8_t length, bool broadcast) {
+    if (length < 5) {
+        return Modbus::EX_PASSTHROUGH;
+    }
+    uint8_t fc = pdu[0];
+    uint16_t first = (pdu[1] << 8) | pdu[2];
+    uint16_t count = (pdu[3] << 8) | pdu[4];
+    if (fc == Modbus::FC_WRITE_REG || fc == Modbus::FC_MASKWRITE_REG) {
+        count = 1;
+    } else if (fc != Modbus::FC_READ_REGS && fc != Modbus::FC_WRITE_REGS) {
+        return Modbus::EX_PASSTHROUGH;
+    }
+    if (count == 0 || (uint32_t)first + count > MB_CTRL_BASE) {
+        return Modbus::EX_PASSTHROUGH;
+    }
+
+    if (fc == Modbus::FC_READ_REGS && (length != 5 || count > 125)) {
+        return Modbus::EX_ILLEGAL_VALUE;
+    }
+    if ((fc == Modbus::FC_WRITE_REG && length != 5) || (fc == Modbus::FC_MASKWRITE_REG && length != 7)) {
+        return Modbus::EX_ILLEGAL_VALUE;
+    }
+    if (fc == Modbus::FC_WRITE_REGS && (length < 6 || count > 123 || pdu[5] != count * 2 || length != 6 + count * 2)) {
+        return Modbus::EX_ILLEGAL_VALUE;
+    }
+
+    // Entries covering the range, walked in address order
+    ModbusRegisterEntry* entry = findRegisterCovering(first);
+    if (!entry) {
+        return Modbus::EX_ILLEGAL_ADDRESS;
+    }
+    uint16_t pos = entry - registerBank;
+    for (uint32_t address = entry->address + entry->words; address < (uint32_t)first + count; ) {
+        if (++pos >= registerCount || registerBank[pos].address != address) {
+            return Modbus::EX_ILLEGAL_ADDRESS;
+        }
+        address += registerBank[pos].words;
+    }
+
+    uint8_t response[2 + 125 * 2];
+    uint8_t responseLength = fc == Modbus::FC_MASKWRITE_REG ? 7 : 5;
+    memcpy(response, pdu, responseLength);
+    pos = entry - registerBank;
+    uint16_t index = first - entry->address;
+    for (uint16_t i = 0; i < count; i++) {
+        ModbusRegisterEntry* current = &registerBank[pos];
+        if (fc == Modbus::FC_READ_REGS) {
+            ModbusRegisterEntry published = *current;
+            published.raw = published.front;
+            uint16_t words[4];
+            encodeRegisterWords(&published, words);
+            response[2 + i * 2] = words[index] >> 8;
+            response[3 + i * 2] = words[index] & 0xFF;
+        } else if (fc == Modbus::FC_WRITE_REG) {
+            writeRegisterWord(current, index, (pdu[3] << 8) | pdu[4]);
+        } else if (fc == Modbus::FC_MASKWRITE_REG) {
+            uint16_t words[4];
+            encodeRegisterWords(current, words);
+            uint16_t andMask = (pdu[3] << 8) | pdu[4];
+            uint16_t orMask = (pdu[5] << 8) | pdu[6];
+            writeRegisterWord(current, index, (words[index] & andMask) | (orMask & ~andMask));
+        } else {
+            writeRegisterWord(current, index, (pdu[6 + i * 2] << 8) | pdu[7 + i * 2]);
+        }
+        if (++index >= current->words) {
+            index = 0;
+            pos++;
+        }
+    }
+    if (fc == Modbus::FC_READ_REGS) {
+        response[1] = count * 2;
+        responseLength = 2 + count * 2;
+    }
+
+    if (!broadcast) {
+        mb.rawResponce(getModbusSlaveAddress(), response, responseLength);
+    }
+    return Modbus::EX_SUCCESS;
+}
@@ -0,0 +1,209 @@
+#include "output_engine.h"
+#include <atomic>
+#include <freertos/task.h>
+#include "command_handler.h"
+#include "dac_controller.h"
+#include "relay_controller.h"
+#include "sine_wave_generator.h"
+#include "setpoint_stream.h"
+#include "event_trace.h"
+#include "profiler.h"
+
+static TaskHandle_t engineTask = nullptr;
+static hw_timer_t* engineTimer = nullptr;
+static volatile uint32_t timerFiredAt = 0;   // micros() in the timer interrupt
+
+// Command ring: producers on core 0 serialize among themselves, the engine
+// consumes without locking
+static OutputCommand commandRing[OUTPUT_COMMAND_RING_SIZE];
+static std::atomic<uint32_t> ringHead(0);    // Next slot to execute (engine)
+static std::atomic<uint32_t> ringTail(0);    // Next slot to fill (producers)
+static portMUX_TYPE producerMux = portMUX_INITIALIZER_UNLOCKED;
+
+static OutputEngineStats engineStats;
+static const uint32_t latencyBucketLimits[OUTPUT_JITTER_BUCKETS - 1] = {10, 25, 50, 100, 250};
+
+/**
+ * Timer interrupt: wake the engine task
+ */
+static void IRAM_ATTR onEngineTimer() {
+    BaseType_t woken = pdFALSE;
+    timerFiredAt = micros();
+    vTaskNotifyGiveFromISR(engineTask, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/**
+ * Check whether output functions may touch the hardware directly
+ */
+bool isOutputEngineContext() {
+    return engineTask == nullptr || xTaskGetCurrentTaskHandle() == engineTask;
+}
+
+/**
+ * Post an output operation to the engine
+ */
+bool postOutputCommand(const OutputCommand& command) {
+    bool queued = false;
+    portENTER_CRITICAL(&producerMux);
+    uint32_t tail = ringTail.load(std::memory_order_relaxed);
+    if (tail - ringHead.load(std::memory_order_acquire) < OUTPUT_COMMAND_RING_SIZE) {
+        commandRing[tail % OUTPUT_COMMAND_RING_SIZE] = command;
+        ringTail.store(tail + 1, std::memory_order_release);
+        queued = true;
+    } else {
+        engineStats.commandOverflow++;
+    }
+    portEXIT_CRITICAL(&producerMux);
+    return queued;
+}
+
+/**
+ * Run one posted command (engine task, so the output functions act directly)
+ */
+static void executeOutputCommand(const OutputCommand& command) {
+    switch (command.type) {
+        case OUT_CMD_SIGNAL_MODE:
+            setSignalMode(command.signalMode.sig, command.signalMode.mode);
+            break;
+        case OUT_CMD_SIGNAL_VALUE:
+            setSignalValue(command.signalValue.sig, command.signalValue.value);
+            break;
+        case OUT_CMD_VOLTAGE:
+            setVoltageOutput(command.level);
+            break;
+        case OUT_CMD_CURRENT:
+            setCurrentOutput(command.level);
+            break;
+        case OUT_CMD_RELAY:
+            setRelay(command.relay.number, command.relay.state);
+            break;
+        case OUT_CMD_SINE_START:
+            startSineWave(command.sine.amplitude, command.sine.period, command.sine.center,
+                          command.sine.signal, command.sine.mode);
+            break;
+        case OUT_CMD_SINE_STOP:
+            stopSineWave();
+            break;
+        case OUT_CMD_STREAM_PACKET:
+            pushStreamSetpoints(command.stream.sequence, command.stream.channelMask, command.stream.values);
+            break;
+        case OUT_CMD_STREAM_CONFIG:
+            configureSetpointStream(command.streamConfig.periodUs, command.streamConfig.prefill);
+            break;
+    }
+    engineStats.commands++;
+}
+
+/**
+ * Record the timing of one tick
+ */
+static void recordTick(uint32_t start, uint32_t interval, uint32_t missed) {
+    uint32_t latency = start - timerFiredAt;
+    engineStats.ticks++;
+    engineStats.missedTicks += missed;
+    engineStats.totalLatencyUs += latency;
+    if (latency > engineStats.maxLatencyUs) {
+        engineStats.maxLatencyUs = latency;
+    }
+
+    uint8_t bucket = 0;
+    while (bucket < OUTPUT_JITTER_BUCKETS - 1 && latency >= latencyBucketLimits[bucket]) {
+        bucket++;
+    }
+    engineStats.latencyHistogram[bucket]++;
+
+    if (missed == 0 && interval != 0) {
+        uint32_t jitter = interval > OUTPUT_ENGINE_PERIOD_US ? interval - OUTPUT_ENGINE_PERIOD_US
+                                                             : OUTPUT_ENGINE_PERIOD_US - interval;
+        if (jitter > engineStats.maxJitterUs) {
+            engineStats.maxJitterUs = jitter;
+        }
+    }
+}
+
+/**
+ * Output engine task (core 1)
+ * The timer is attached from this task so its interrupt is served on core 1.
+ */
+static void outputEngineTask(void* param) {
+    engineTimer = timerBegin(OUTPUT_ENGINE_TIMER, 80, true); // 1 MHz
+    timerAttachInterrupt(engineTimer, onEngineTimer, true);
+    timerAlarmWrite(engineTimer, OUTPUT_ENGINE_PERIOD_US, true);
+    timerAlarmEnable(engineTimer);
+
+    uint32_t lastStart = 0;
+    for (;;) {
+        uint32_t pending = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t start = micros();
+        uint32_t missed = pending > 1 ? pending - 1 : 0;
+        traceEvent(TRACE_TICK_BEGIN, missed > 0xFF ? 0xFF : missed, traceClampUs(start - timerFiredAt));
+        recordTick(start, lastStart ? start - lastStart : 0, missed);
+        lastStart = start;
+
+        // Posted operations first, so a stop or new setpoint wins this tick
+        uint32_t head = ringHead.load(std::memory_order_relaxed);
+        while (head != ringTail.load(std::memory_order_acquire)) {
+            executeOutputCommand(commandRing[head % OUTPUT_COMMAND_RING_SIZE]);
+            ringHead.store(++head, std::memory_order_release);
+        }
+
+        {
+            PROFILE_ZONE(PROFILE_STREAM);
+            updateSetpointStream();
+        }
+        {
+            PROFILE_ZONE(PROFILE_WAVE);
+            updateSineWave();
+        }
+
+        uint32_t runTime = micros() - start;
+        traceEvent(TRACE_TICK_END, 0, traceClampUs(runTime));
+        if (runTime > engineStats.maxRunUs) {
+            engineStats.maxRunUs = runTime;
+        }
+    }
+}
+
+/**
+ * Start the output engine task and its timer
+ */
+void initOutputEngine() {
+    resetOutputEngineStats();
+    xTaskCreatePinnedToCore(outputEngineTask, "outputs", OUTPUT_ENGINE_STACK, nullptr,
+                            OUTPUT_ENGINE_PRIORITY, &engineTask, OUTPUT_ENGINE_CORE);
+    Serial.printf("Output engine started on core %d, %u us tick\n", OUTPUT_ENGINE_CORE, OUTPUT_ENGINE_PERIOD_US);
+}
+
+/**
+ * Get tick timing statistics
+ */
+const OutputEngineStats* getOutputEngineStats() {
+    return &engineStats;
+}
+
+/**
+ * Clear tick timing statistics
+ */
+void resetOutputEngineStats() {
+    memset(&engineStats, 0, sizeof(engineStats));
+}
+
+/**
+ * Print tick timing statistics to the USB serial port
+ */
+void printOutputEngineStats() {
+    const OutputEngineStats& s = engineStats;
+    Serial.printf("Output engine: %lu ticks, %lu missed, latency avg %luus max %luus, jitter max %luus, run max %luus\n",
+                  (unsigned long)s.ticks, (unsigned long)s.missedTicks,
+                  (unsigned long)(s.ticks ? s.totalLatencyUs / s.ticks : 0), (unsigned long)s.maxLatencyUs,
+                  (unsigned long)s.maxJitterUs, (unsigned long)s.maxRunUs);
+    Serial.printf("  Latency: <10us %lu, <25us %lu, <50us %lu, <100us %lu, <250us %lu, >=250us %lu\n",
+                  (unsigned long)s.latencyHistogram[0], (unsigned long)s.latencyHistogram[1],
+                  (unsigned long)s.latencyHistogram[2], (unsigned long)s.latencyHistogram[3],
+                  (unsigned long)s.latencyHistogram[4], (unsigned long)s.latencyHistogram[5]);
+    Serial.printf("  Commands: %lu executed, %lu dropped (ring full)\n",
+                  (unsigned long)s.commands, (unsigned long)s.commandOverflow);
+}
@@ -0,0 +1,224 @@
+#include "output_journal.h"
+#include <Preferences.h>
+#include "command_handler.h"
+#include "relay_controller.h"
+#include "sine_wave_generator.h"
+#include "setpoint_stream.h"
+#include "scheduler.h"
+#include "debug_log.h"
+
+extern char signalModes[3];
+
+// Stored record
+struct JournalRecord {
+    uint32_t sequence;
+    OutputSnapshot state;
+    uint16_t crc;             // CRC-16 over sequence and state
+};
+
+static OutputSnapshot committedState;   // Last written (or restored) state
+static OutputSnapshot pendingState;     // Last observed state
+static uint32_t pendingSinceMs = 0;
+static uint32_t lastWriteMs = 0;
+static uint32_t nextSequence = 0;
+static uint32_t journalWrites = 0;
+static bool haveCommitted = false;
+
+/**
+ * CRC-16/MODBUS
+ */
+static uint16_t journalCrc(const uint8_t* data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+        }
+    }
+    return crc;
+}
+
+/**
+ * Key of a journal slot
+ */
+static void slotKey(uint8_t slot, char* key) {
+    key[0] = 's';
+    key[1] = '0' + slot;
+    key[2] = '\0';
+}
+
+/**
+ * Read the current output state
+ * While the waveform or setpoint stream drives the outputs, the DAC values
+ * (and the relays a digital wave toggles) are samples that never settle,
+ * so the last journaled setpoints are kept for them instead.
+ */
+static void captureOutputState(OutputSnapshot* state) {
+    bool generated = isSineWaveActive() || isSetpointStreamActive();
+    uint8_t heldRelays = 0;
+    if (isSineWaveActive() && getSineWaveMode() == 'd') {
+        heldRelays = 0x2A; // Voltage relays 2, 4 and 6
+    }
+
+    memset(state, 0, sizeof(*state)); // Padding included, states are compared with memcmp
+    for (uint8_t sig = 1; sig <= 3; sig++) {
+        state->modes[sig - 1] = signalModes[sig - 1];
+        state->values[sig - 1] = generated ? committedState.values[sig - 1] : getSignalValue(sig);
+    }
+    for (uint8_t relay = 1; relay <= 6; relay++) {
+        if (getRelayState(relay)) {
+            state->relays |= 1 << (relay - 1);
+        }
+    }
+    state->relays = (state->relays & ~heldRelays) | (committedState.relays & heldRelays);
+    state->waveActive = isSineWaveActive();
+    state->waveMode = getSineWaveMode();
+    state->wavePeriod = getSineWavePeriod();
+    state->waveAmplitude = getSineWaveAmplitude();
+    state->waveCenter = getSineWaveCenter();
+}
+
+/**
+ * Restore the newest valid journal record onto the outputs
+ */
+bool restoreOutputJournal() {
+    JournalRecord newest = {};
+    bool found = false;
+
+    Preferences prefs;
+    prefs.begin(JOURNAL_NAMESPACE, true);
+    for (uint8_t slot = 0; slot < JOURNAL_SLOTS; slot++) {
+        char key[3];
+        slotKey(slot, key);
+        JournalRecord record;
+        if (prefs.getBytes(key, &record, sizeof(record)) != sizeof(record)) {
+            continue;
+        }
+        if (record.crc != journalCrc((const uint8_t*)&record, offsetof(JournalRecord, crc))) {
+            continue;
+        }
+        if (!found || (int32_t)(record.sequence - newest.sequence) > 0) {
+            newest = record;
+            found = true;
+        }
+    }
+    prefs.end();
+
+    if (!found) {
+        // Default to three-channel voltage mode
+        for (uint8_t sig = 1; sig <= 3; sig++) {
+            setRelayMode(sig, 'v');
+        }
+        return false;
+    }
+
+    const OutputSnapshot& state = newest.state;
+    for (uint8_t sig = 1; sig <= 3; sig++) {
+        setSignalMode(sig, state.modes[sig - 1]);
+        setSignalValue(sig, state.values[sig - 1]);
+    }
+    for (uint8_t relay = 1; relay <= 6; relay++) {
+        setRelay(relay, state.relays & (1 << (relay - 1)));
+    }
+#if JOURNAL_RESTORE_WAVEFORM
+    if (state.waveActive) {
+        // The wave drives every signal in its mode; the signal argument only matters for v/c
+        uint8_t signal = 1;
+        while (signal < 3 && state.modes[signal - 1] != state.waveMode) {
+            signal++;
+        }
+        startSineWave(state.waveAmplitude, state.wavePeriod, state.waveCenter, signal, state.waveMode);
+    }
+#endif
+
+    nextSequence = newest.sequence + 1;
+    captureOutputState(&committedState);
+    haveCommitted = true;
+    return true;
+}
+
+/**
+ * Write the pending state to the next slot
+ */
+static void writeJournal(uint32_t now) {
+    JournalRecord record;
+    record.sequence = nextSequence;
+    record.state = pendingState;
+    record.crc = journalCrc((const uint8_t*)&record, offsetof(JournalRecord, crc));
+
+    char key[3];
+    slotKey(nextSequence % JOURNAL_SLOTS, key);
+    Preferences prefs;
+    prefs.begin(JOURNAL_NAMESPACE, false);
+    bool ok = prefs.putBytes(key, &record, sizeof(record)) == sizeof(record);
+    prefs.end();
+
+    lastWriteMs = now;
+    if (!ok) {
+        LOG_ERROR(LOG_CAT_SYSTEM, "Journal: write to %s failed", key);
+        return;
+    }
+    nextSequence++;
+    journalWrites++;
+    committedState = pendingState;
+    haveCommitted = true;
+}
+
+/**
+ * Journal job: write the output state once it has settled
+ */
+static void serviceOutputJournal() {
+    uint32_t now = millis();
+    OutputSnapshot state;
+    captureOutputState(&state);
+
+    if (memcmp(&state, &pendingState, sizeof(state)) != 0) {
+        pendingState = state;
+        pendingSinceMs = now;
+        return;
+    }
+    if (haveCommitted && memcmp(&pendingState, &committedState, sizeof(state)) == 0) {
+        return;
+    }
+    if (now - pendingSinceMs >= JOURNAL_SETTLE_MS && now - lastWriteMs >= JOURNAL_MIN_INTERVAL_MS) {
+        writeJournal(now);
+    }
+}
+
+/**
+ * Register the journal job
+ */
+void initOutputJournal() {
+    captureOutputState(&pendingState);
+    pendingSinceMs = millis();
+    lastWriteMs = pendingSinceMs - JOURNAL_MIN_INTERVAL_MS;
+    addSchedulerJob("journal", serviceOutputJournal, JOURNAL_CHECK_INTERVAL_MS * 1000, 100000, 0);
+}
+
+/**
+ * Erase all journal records
+ */
+void clearOutputJournal() {
+    Preferences prefs;
+    prefs.begin(JOURNAL_NAMESPACE, false);
+    prefs.clear();
+    prefs.end();
+    nextSequence = 0;
+    committedState = pendingState; // Nothing is rewritten until the outputs change
+    haveCommitted = true;
+}
+
+/**
+ * Print journal state
+ */
+void printOutputJournal() {
+    bool pending = !haveCommitted || memcmp(&pendingState, &committedState, sizeof(pendingState)) != 0;
+    Serial.printf("Journal: next seq %lu, %lu writes this boot, %s\n", (unsigned long)nextSequence,
+                  (unsigned long)journalWrites, pending ? "change pending" : "up to date");
+    if (haveCommitted) {
+        const OutputSnapshot& state = committedState;
+        Serial.printf("Committed: SIG1 %c %.2f, SIG2 %c %.2f, SIG3 %c %.2f, relays 0x%02X, wave %s\n",
+                      state.modes[0], state.values[0], state.modes[1], state.values[1],
+                      state.modes[2], state.values[2], state.relays, state.waveActive ? "on" : "off");
+    }
+}
@@ -0,0 +1,121 @@
+#include "profiler.h"
+
+struct ProfileZoneStats {
+    uint32_t count;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+    uint32_t histogram[PROFILE_HIST_BUCKETS];
+};
+
+static ProfileZoneStats zones[PROFILE_ZONE_COUNT];
+
+static const char* const zoneNames[PROFILE_ZONE_COUNT] = {
+    "usb", "rs485", "modbus_ctl", "generators", "telemetry", "modbus_poll", "stream", "wave"
+};
+
+/**
+ * Histogram bucket for a cycle count
+ * Values below 4 get their own bucket; above that each octave is split
+ * into PROFILE_SUB_BUCKETS equal parts by the two bits after the top one.
+ */
+static inline uint8_t bucketOf(uint32_t cycles) {
+    if (cycles < PROFILE_SUB_BUCKETS) {
+        return cycles;
+    }
+    uint8_t msb = 31 - __builtin_clz(cycles);
+    uint8_t sub = (cycles >> (msb - 2)) & (PROFILE_SUB_BUCKETS - 1);
+    return (msb - 1) * PROFILE_SUB_BUCKETS + sub;
+}
+
+/**
+ * Largest cycle count that falls in a bucket
+ */
+static uint32_t bucketUpperBound(uint8_t bucket) {
+    if (bucket < PROFILE_SUB_BUCKETS) {
+        return bucket;
+    }
+    uint8_t msb = bucket / PROFILE_SUB_BUCKETS + 1;
+    uint8_t sub = bucket % PROFILE_SUB_BUCKETS;
+    uint64_t lower = (uint64_t)(PROFILE_SUB_BUCKETS + sub) << (msb - 2);
+    return (uint32_t)(lower + ((uint64_t)1 << (msb - 2)) - 1);
+}
+
+/**
+ * Add one sample to a zone
+ */
+void profileRecord(uint8_t zone, uint32_t cycles) {
+    if (zone >= PROFILE_ZONE_COUNT) {
+        return;
+    }
+    ProfileZoneStats& stats = zones[zone];
+    if (stats.count == 0 || cycles < stats.minCycles) {
+        stats.minCycles = cycles;
+    }
+    if (cycles > stats.maxCycles) {
+        stats.maxCycles = cycles;
+    }
+    stats.totalCycles += cycles;
+    stats.histogram[bucketOf(cycles)]++;
+    stats.count++;
+}
+
+/**
+ * Get a zone name
+ */
+const char* getProfileZoneName(uint8_t zone) {
+    return zone < PROFILE_ZONE_COUNT ? zoneNames[zone] : nullptr;
+}
+
+/**
+ * Summarize a zone
+ */
+bool getProfileSummary(uint8_t zone, ProfileSummary* summary) {
+    if (zone >= PROFILE_ZONE_COUNT) {
+        return false;
+    }
+    const ProfileZoneStats& stats = zones[zone];
+    summary->count = stats.count;
+    summary->minCycles = stats.count ? stats.minCycles : 0;
+    summary->maxCycles = stats.maxCycles;
+    summary->avgCycles = stats.count ? (uint32_t)(stats.totalCycles / stats.count) : 0;
+
+    // Walk the histogram until 99% of the samples are covered
+    summary->p99Cycles = 0;
+    uint32_t target = stats.count - stats.count / 100;
+    uint32_t seen = 0;
+    for (uint8_t bucket = 0; bucket < PROFILE_HIST_BUCKETS && stats.count; bucket++) {
+        seen += stats.histogram[bucket];
+        if (seen >= target) {
+            summary->p99Cycles = bucketUpperBound(bucket);
+            if (summary->p99Cycles > stats.maxCycles) {
+                summary->p99Cycles = stats.maxCycles;
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+/**
+ * Clear all zones
+ */
+void resetProfiler() {
+    memset(zones, 0, sizeof(zones));
+}
+
+/**
+ * Print all zones to the USB serial port
+ */
+void printProfiler() {
+    float mhz = getCpuFrequencyMhz();
+    Serial.printf("=== PROFILE (us, %.0f MHz) ===\n", mhz);
+    Serial.println("zone           calls      min      avg      max      p99");
+    for (uint8_t zone = 0; zone < PROFILE_ZONE_COUNT; zone++) {
+        ProfileSummary summary;
+        getProfileSummary(zone, &summary);
+        Serial.printf("%-12s %8lu %8.1f %8.1f %8.1f %8.1f\n", zoneNames[zone], (unsigned long)summary.count,
+                      summary.minCycles / mhz, summary.avgCycles / mhz,
+                      summary.maxCycles / mhz, summary.p99Cycles / mhz);
+    }
+}
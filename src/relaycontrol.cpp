@@ -1,4 +1,8 @@
 #include "relay_controller.h"
+#include "debug_log.h"
+#include "event_trace.h"
+#include "change_notify.h"
+#include "output_engine.h"
 
 // Solid state relay pin definitions
 #define SW11 2   // SIG1 current
@@ -8,6 +12,9 @@
 #define SW31 25  // SIG3 current
 #define SW32 33  // SIG3 voltage
 
+// Global variables to track relay states
+static bool relayStates[7] = {false, false, false, false, false, false, false}; // Index 0 unused, 1-6 for relays
+
 /**
  * Initialize solid state relays
  */
@@ -28,7 +35,7 @@ void initRelayController() {
     digitalWrite(SW31, LOW);
     digitalWrite(SW32, LOW);
 
-    Serial.println("Relay Controller Initialized");
+    LOG_INFO(LOG_CAT_RELAY, "Relay Controller Initialized");
 }
 
 /**
@@ -54,15 +61,17 @@ void setRelayMode(uint8_t sig, char mode) {
             break;
 
         default:
-            Serial.println("Invalid signal number. Use 1 to 3.");
+            LOG_WARN(LOG_CAT_RELAY, "Invalid signal number. Use 1 to 3.");
             return;
     }
 
-    Serial.printf("Relay mode set: SIG%d -> %c\n", sig, mode);
-}
+    // Keep tracked states in line with the pins (relay 2*sig-1 = current, 2*sig = voltage)
+    relayStates[sig * 2 - 1] = (mode != 'c');
+    relayStates[sig * 2] = (mode != 'v');
+    markStateChanged(CHANGE_RELAYS);
 
-// Global variables to track relay states
-static bool relayStates[6] = {false, false, false, false, false, false}; // Index 0 unused, 1-6 for relays
+    LOG_INFO(LOG_CAT_RELAY, "Relay mode set: SIG%d -> %c", sig, mode);
+}
 
 /**
  * Set relay state
@@ -71,7 +80,15 @@ static bool relayStates[6] = {false, false, false, false, false, false}; // Inde
  */
 void setRelay(uint8_t relayNumber, bool state) {
     if (relayNumber < 1 || relayNumber > 6) {
-        Serial.printf("Invalid relay number: %d (use 1-6)\n", relayNumber);
+        LOG_WARN(LOG_CAT_RELAY, "Invalid relay number: %d (use 1-6)", relayNumber);
+        return;
+    }
+    if (!isOutputEngineContext()) {
+        OutputCommand command = {};
+        command.type = OUT_CMD_RELAY;
+        command.relay.number = relayNumber;
+        command.relay.state = state;
+        postOutputCommand(command);
         return;
     }
     
@@ -90,7 +107,9 @@ void setRelay(uint8_t relayNumber, bool state) {
     }
     
     digitalWrite(pin, state ? HIGH : LOW);
-    Serial.printf("Relay %d set to %s\n", relayNumber, state ? "ON" : "OFF");
+    traceEvent(TRACE_RELAY, relayNumber, state);
+    markStateChanged(CHANGE_RELAYS);
+    LOG_INFO(LOG_CAT_RELAY, "Relay %d set to %s", relayNumber, state ? "ON" : "OFF");
 }
 
 /**
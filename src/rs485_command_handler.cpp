@@ -3,6 +3,12 @@
 #include "relay_controller.h"
 #include "sine_wave_generator.h"
 #include "device_id.h"
+#include "setpoint_stream.h"
+#include "debug_log.h"
+#include "event_trace.h"
+#include "profiler.h"
+#include "telemetry.h"
+#include "change_notify.h"
 
 /**
  * Initialize RS-485 command handler
@@ -13,20 +19,104 @@ void initRS485CommandHandler() {
 
 /**
  * Process RS-485 commands and execute corresponding actions
- * @return true if a command was processed
+ * All commands received in the current read burst are executed in order.
+ * @return true if at least one command was processed
  */
 bool handleRS485Commands() {
-    if (processRS485Commands()) {
+    processRS485Commands();
+    
+    bool processed = false;
+    while (dequeueRS485Command()) {
         RS485Command* command = getLastCommand();
         if (command && command->valid) {
-            return executeRS485Command(command);
+            executeRS485Command(command);
+            processed = true;
         }
     }
-    return false;
+    return processed;
+}
+
+// RS-485 command table: opcode, name, handler, min/max payload length, flags
+static constexpr CommandSpec rs485CommandSpecs[] = {
+    {CMD_PING,             "ping",        handlePingCommand,            0, 0, CMD_FLAG_SAFE_DURING_WAVEFORM},
+    {CMD_GET_DEVICE_ID,    "id",          handleGetDeviceIDCommand,     0, 0, CMD_FLAG_SAFE_DURING_WAVEFORM},
+    {CMD_SET_GROUPS,       "groups",      handleSetGroupsCommand,       2, 2, CMD_FLAG_SAFE_DURING_WAVEFORM},
+    {CMD_GET_GROUPS,       "getgroups",   handleGetGroupsCommand,       0, 0, CMD_FLAG_SAFE_DURING_WAVEFORM},
+    {CMD_SET_VOLTAGE,      "voltage",     handleSetVoltageCommand,      2, 2, CMD_FLAG_MUTATES_OUTPUTS},
+    {CMD_SET_CURRENT,      "current",     handleSetCurrentCommand,      2, 2, CMD_FLAG_MUTATES_OUTPUTS},
+    {CMD_SET_RELAY,        "relay",       handleSetRelayCommand,        2, 2, CMD_FLAG_MUTATES_OUTPUTS | CMD_FLAG_SAFE_DURING_WAVEFORM},
+    {CMD_GET_STATUS,       "status",      handleGetStatusCommand,       0, 0, CMD_FLAG_SAFE_DURING_WAVEFORM},
+    {CMD_GET_STATS,        "stats",       handleGetStatsCommand,        0, 2, CMD_FLAG_SAFE_DURING_WAVEFORM},
+    {CMD_GET_TRACE,        "trace",       handleGetTraceCommand,        2, 3, CMD_FLAG_SAFE_DURING_WAVEFORM},
+    {CMD_GET_PROFILE,      "profile",     handleGetProfileCommand,      1, 2, CMD_FLAG_SAFE_DURING_WAVEFORM},
+    {CMD_GET_TELEMETRY,    "telemetry",   handleGetTelemetryCommand,    0, 0, CMD_FLAG_SAFE_DURING_WAVEFORM},
+    {CMD_SINE_WAVE,        "sine",        handleSineWaveCommand,        6, 6, CMD_FLAG_MUTATES_OUTPUTS | CMD_FLAG_SAFE_DURING_WAVEFORM},
+    {CMD_STOP_SINE,        "stop",        handleStopSineCommand,        0, 0, CMD_FLAG_MUTATES_OUTPUTS | CMD_FLAG_SAFE_DURING_WAVEFORM},
+    {CMD_STREAM_SETPOINTS, "stream",      handleStreamSetpointsCommand, 3, 9, CMD_FLAG_MUTATES_OUTPUTS | CMD_FLAG_NO_ACK},
+    {CMD_STREAM_STATS,     "streamstats", handleStreamStatsCommand,     0, 1, CMD_FLAG_SAFE_DURING_WAVEFORM},
+    {CMD_STREAM_CONFIG,    "streamcfg",   handleStreamConfigCommand,    3, 3, CMD_FLAG_SAFE_DURING_WAVEFORM},
+    {CMD_SUBSCRIBE,        "subscribe",   handleSubscribeCommand,       1, 2, CMD_FLAG_SAFE_DURING_WAVEFORM},
+    {CMD_POLL_CHANGES,     "poll",        handlePollChangesCommand,     0, 0, CMD_FLAG_SAFE_DURING_WAVEFORM | CMD_FLAG_NO_ACK},
+};
+
+static_assert(hasUniqueOpcodes(rs485CommandSpecs), "Duplicate opcode in RS-485 command table");
+
+static constexpr CommandTable<sizeof(rs485CommandSpecs) / sizeof(rs485CommandSpecs[0])> rs485Commands(rs485CommandSpecs);
+
+// Per-command latency histograms, indexed like rs485CommandSpecs
+struct CommandLatencyStats {
+    uint32_t count;
+    uint32_t maxUs;
+    uint16_t buckets[RS485_LATENCY_BUCKETS];
+};
+
+// Upper bound (exclusive, us) of each bucket except the last
+static const uint32_t latencyBucketLimits[RS485_LATENCY_BUCKETS - 1] = {250, 500, 1000, 2000, 5000, 10000, 20000};
+
+static CommandLatencyStats latencyStats[rs485Commands.size()];
+
+/**
+ * Record how long a command took from end of frame to start of reply
+ * @param index Command index in the command table
+ * @param latencyUs Latency in microseconds
+ */
+static void recordCommandLatency(size_t index, uint32_t latencyUs) {
+    CommandLatencyStats& stats = latencyStats[index];
+    uint8_t bucket = 0;
+    while (bucket < RS485_LATENCY_BUCKETS - 1 && latencyUs >= latencyBucketLimits[bucket]) {
+        bucket++;
+    }
+    if (stats.buckets[bucket] < 0xFFFF) {
+        stats.buckets[bucket]++;
+    }
+    stats.count++;
+    if (latencyUs > stats.maxUs) {
+        stats.maxUs = latencyUs;
+    }
+}
+
+/**
+ * Look up an RS-485 command descriptor
+ * @param opcode Command type byte
+ * @return Descriptor, or nullptr if the opcode is not registered
+ */
+const CommandSpec* findRS485Command(uint8_t opcode) {
+    return rs485Commands.find(opcode);
+}
+
+/**
+ * Look up an RS-485 command descriptor by name
+ * @param name Command name (case-insensitive)
+ * @return Descriptor, or nullptr if no command has that name
+ */
+const CommandSpec* findRS485CommandByName(const char* name) {
+    return rs485Commands.findByName(name);
 }
 
 /**
  * Execute a specific command
+ * Validation (opcode, payload length, waveform interlock) is shared for all
+ * commands; handlers only see payloads within their registered length range.
  * @param command Pointer to the command structure
  * @return true if command was executed successfully
  */
@@ -35,48 +125,43 @@ bool executeRS485Command(RS485Command* command) {
         return false;
     }
     
-    bool success = false;
-    
-    switch (command->commandType) {
-        case CMD_PING:
-            success = handlePingCommand(command->data, command->length);
-            break;
-            
-        case CMD_GET_DEVICE_ID:
-            success = handleGetDeviceIDCommand(command->data, command->length);
+    const CommandSpec* spec = rs485Commands.find(command->commandType);
+    switch (checkCommand(spec, command->length, isSineWaveActive())) {
+        case CMD_CHECK_OK:
             break;
             
-        case CMD_SET_VOLTAGE:
-            success = handleSetVoltageCommand(command->data, command->length);
-            break;
-            
-        case CMD_SET_CURRENT:
-            success = handleSetCurrentCommand(command->data, command->length);
-            break;
-            
-        case CMD_SET_RELAY:
-            success = handleSetRelayCommand(command->data, command->length);
-            break;
-            
-        case CMD_GET_STATUS:
-            success = handleGetStatusCommand(command->data, command->length);
-            break;
-            
-        case CMD_SINE_WAVE:
-            success = handleSineWaveCommand(command->data, command->length);
-            break;
+        case CMD_CHECK_UNKNOWN:
+            LOG_WARN(LOG_CAT_RS485, "Unknown command: 0x%02X", command->commandType);
+            sendAckResponse(false);
+            return false;
             
-        case CMD_STOP_SINE:
-            success = handleStopSineCommand(command->data, command->length);
-            break;
+        case CMD_CHECK_BAD_LENGTH:
+            LOG_WARN(LOG_CAT_RS485, "RS-485: Invalid %s command length: %d", spec->name, command->length);
+            if (!(spec->flags & CMD_FLAG_NO_ACK)) {
+                sendAckResponse(false);
+            }
+            return false;
             
-        default:
-            Serial.printf("Unknown command: 0x%02X\n", command->commandType);
-            sendAckResponse(false);
+        case CMD_CHECK_BUSY:
+            LOG_WARN(LOG_CAT_RS485, "RS-485: %s rejected while sine wave is active", spec->name);
+            if (!(spec->flags & CMD_FLAG_NO_ACK)) {
+                sendAckResponse(false);
+            }
             return false;
     }
     
-    sendAckResponse(success);
+    traceEvent(TRACE_CMD_BEGIN, spec->opcode, traceClampUs(micros() - command->timestamp));
+    bool success = spec->handler(command->data, command->length);
+    traceEvent(TRACE_CMD_END, spec->opcode, success);
+    
+    if (!(spec->flags & CMD_FLAG_NO_ACK)) {
+        sendAckResponse(success);
+    }
+    
+    // Commands that never reply are measured to handler completion
+    uint32_t replyStart = command->replyTimestamp ? command->replyTimestamp : micros();
+    recordCommandLatency(rs485Commands.indexOf(spec), replyStart - command->timestamp);
+    
     return success;
 }
 
@@ -87,7 +172,7 @@ bool executeRS485Command(RS485Command* command) {
  * @return true if successful
  */
 bool handlePingCommand(const uint8_t* data, uint8_t length) {
-    Serial.println("RS-485: Ping command received");
+    LOG_DEBUG(LOG_CAT_RS485, "RS-485: Ping command received");
     
     // Send pong response
     uint8_t response[] = {0x50, 0x4F, 0x4E, 0x47}; // "PONG"
@@ -103,7 +188,7 @@ bool handlePingCommand(const uint8_t* data, uint8_t length) {
  * @return true if successful
  */
 bool handleGetDeviceIDCommand(const uint8_t* data, uint8_t length) {
-    Serial.println("RS-485: Get device ID command received");
+    LOG_DEBUG(LOG_CAT_RS485, "RS-485: Get device ID command received");
     
     uint8_t deviceID = getCurrentDeviceID();
     sendDataResponse(&deviceID, 1);
@@ -111,6 +196,37 @@ bool handleGetDeviceIDCommand(const uint8_t* data, uint8_t length) {
     return true;
 }
 
+/**
+ * Handle set groups command
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleSetGroupsCommand(const uint8_t* data, uint8_t length) {
+    uint16_t mask = (data[0] << 8) | data[1];
+    LOG_INFO(LOG_CAT_RS485, "RS-485: Set groups command: 0x%04X", mask);
+    
+    setRS485GroupMask(mask, true);
+    
+    return true;
+}
+
+/**
+ * Handle get groups command
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleGetGroupsCommand(const uint8_t* data, uint8_t length) {
+    LOG_DEBUG(LOG_CAT_RS485, "RS-485: Get groups command received");
+    
+    uint16_t mask = getRS485GroupMask();
+    uint8_t response[2] = {(uint8_t)(mask >> 8), (uint8_t)(mask & 0xFF)};
+    sendDataResponse(response, 2);
+    
+    return true;
+}
+
 /**
  * Handle set voltage command
  * @param data Command data
@@ -118,16 +234,11 @@ bool handleGetDeviceIDCommand(const uint8_t* data, uint8_t length) {
  * @return true if successful
  */
 bool handleSetVoltageCommand(const uint8_t* data, uint8_t length) {
-    if (length != 2) {
-        Serial.println("RS-485: Invalid voltage command length");
-        return false;
-    }
-    
     // Extract voltage value (2 bytes, big endian)
     uint16_t voltageRaw = (data[0] << 8) | data[1];
     float voltage = voltageRaw / 100.0f; // Convert from centivolts
     
-    Serial.printf("RS-485: Set voltage command: %.2fV\n", voltage);
+    LOG_INFO(LOG_CAT_RS485, "RS-485: Set voltage command: %.2fV", voltage);
     
     // Set voltage output
     setVoltageOutput(voltage);
@@ -142,16 +253,11 @@ bool handleSetVoltageCommand(const uint8_t* data, uint8_t length) {
  * @return true if successful
  */
 bool handleSetCurrentCommand(const uint8_t* data, uint8_t length) {
-    if (length != 2) {
-        Serial.println("RS-485: Invalid current command length");
-        return false;
-    }
-    
     // Extract current value (2 bytes, big endian)
     uint16_t currentRaw = (data[0] << 8) | data[1];
     float current = currentRaw / 100.0f; // Convert from centiamperes
     
-    Serial.printf("RS-485: Set current command: %.2fmA\n", current);
+    LOG_INFO(LOG_CAT_RS485, "RS-485: Set current command: %.2fmA", current);
     
     // Set current output
     setCurrentOutput(current);
@@ -166,15 +272,10 @@ bool handleSetCurrentCommand(const uint8_t* data, uint8_t length) {
  * @return true if successful
  */
 bool handleSetRelayCommand(const uint8_t* data, uint8_t length) {
-    if (length != 2) {
-        Serial.println("RS-485: Invalid relay command length");
-        return false;
-    }
-    
     uint8_t relayNumber = data[0];
     uint8_t relayState = data[1];
     
-    Serial.printf("RS-485: Set relay command: Relay=%d, State=%d\n", relayNumber, relayState);
+    LOG_INFO(LOG_CAT_RS485, "RS-485: Set relay command: Relay=%d, State=%d", relayNumber, relayState);
     
     // Set relay state
     if (relayState == 0) {
@@ -193,7 +294,7 @@ bool handleSetRelayCommand(const uint8_t* data, uint8_t length) {
  * @return true if successful
  */
 bool handleGetStatusCommand(const uint8_t* data, uint8_t length) {
-    Serial.println("RS-485: Get status command received");
+    LOG_DEBUG(LOG_CAT_RS485, "RS-485: Get status command received");
     
     // Create status response
     uint8_t status[8];
@@ -234,24 +335,180 @@ bool handleGetStatusCommand(const uint8_t* data, uint8_t length) {
 }
 
 /**
- * Handle sine wave command
+ * Write a uint32 big endian
+ */
+static void putUint32BE(uint8_t* out, uint32_t value) {
+    out[0] = (value >> 24) & 0xFF;
+    out[1] = (value >> 16) & 0xFF;
+    out[2] = (value >> 8) & 0xFF;
+    out[3] = value & 0xFF;
+}
+
+/**
+ * Handle get stats command
  * @param data Command data
  * @param length Data length
  * @return true if successful
  */
-bool handleSineWaveCommand(const uint8_t* data, uint8_t length) {
-    if (length != 6) {
-        Serial.println("RS-485: Invalid sine wave command length");
+bool handleGetStatsCommand(const uint8_t* data, uint8_t length) {
+    uint8_t selector = length > 0 ? data[0] : STATS_SELECT_LINK;
+    uint8_t flags = length > 1 ? data[1] : 0;
+    
+    uint8_t response[25];
+    uint8_t responseLength = 0;
+    response[responseLength++] = selector;
+    
+    if (selector == STATS_SELECT_LINK) {
+        const RS485LinkStats* link = getRS485LinkStats();
+        uint32_t counters[6] = {
+            link->bytesReceived, link->framesReceived, link->rejected,
+            link->notForMe, link->overflow, link->dropped
+        };
+        for (int i = 0; i < 6; i++) {
+            putUint32BE(&response[responseLength], counters[i]);
+            responseLength += 4;
+        }
+    } else {
+        const CommandSpec* spec = rs485Commands.find(selector);
+        if (!spec) {
+            LOG_WARN(LOG_CAT_RS485, "RS-485: No stats for unknown command 0x%02X", selector);
+            return false;
+        }
+        const CommandLatencyStats& stats = latencyStats[rs485Commands.indexOf(spec)];
+        putUint32BE(&response[responseLength], stats.count);
+        responseLength += 4;
+        putUint32BE(&response[responseLength], stats.maxUs);
+        responseLength += 4;
+        for (int i = 0; i < RS485_LATENCY_BUCKETS; i++) {
+            response[responseLength++] = (stats.buckets[i] >> 8) & 0xFF;
+            response[responseLength++] = stats.buckets[i] & 0xFF;
+        }
+    }
+    
+    sendDataResponse(response, responseLength);
+    
+    if (flags & STATS_FLAG_RESET) {
+        resetRS485LinkStats();
+        memset(latencyStats, 0, sizeof(latencyStats));
+        LOG_INFO(LOG_CAT_RS485, "RS-485: Statistics reset");
+    }
+    
+    return true;
+}
+
+/**
+ * Handle get trace command
+ * The 16-bit sequence window is widened against the current head, which is
+ * always less than 64k records ahead of anything still in the ring.
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleGetTraceCommand(const uint8_t* data, uint8_t length) {
+    uint16_t from16 = (data[0] << 8) | data[1];
+    uint8_t flags = length > 2 ? data[2] : 0;
+    
+    if (flags & TRACE_FLAG_FREEZE) {
+        setTraceEnabled(false);
+    }
+    
+    uint32_t head = getTraceHead();
+    uint32_t from = head - (uint16_t)((uint16_t)head - from16);
+    
+    TraceRecord records[TRACE_RECORDS_PER_REPLY];
+    uint32_t first = 0;
+    uint8_t count = readTrace(from, records, TRACE_RECORDS_PER_REPLY, &first);
+    
+    uint8_t response[5 + TRACE_RECORDS_PER_REPLY * 8];
+    uint8_t responseLength = 0;
+    response[responseLength++] = (head >> 8) & 0xFF;
+    response[responseLength++] = head & 0xFF;
+    response[responseLength++] = (first >> 8) & 0xFF;
+    response[responseLength++] = first & 0xFF;
+    response[responseLength++] = count;
+    for (uint8_t i = 0; i < count; i++) {
+        putUint32BE(&response[responseLength], records[i].timestamp);
+        responseLength += 4;
+        response[responseLength++] = records[i].event;
+        response[responseLength++] = records[i].arg8;
+        response[responseLength++] = (records[i].arg16 >> 8) & 0xFF;
+        response[responseLength++] = records[i].arg16 & 0xFF;
+    }
+    
+    sendDataResponse(response, responseLength);
+    
+    if (flags & TRACE_FLAG_RESTART) {
+        clearTrace();
+        setTraceEnabled(true);
+    }
+    
+    return true;
+}
+
+/**
+ * Handle get profile command
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleGetProfileCommand(const uint8_t* data, uint8_t length) {
+    uint8_t zone = data[0];
+    uint8_t flags = length > 1 ? data[1] : 0;
+    
+    ProfileSummary summary;
+    if (!getProfileSummary(zone, &summary)) {
+        LOG_WARN(LOG_CAT_RS485, "RS-485: No profile zone %d", zone);
         return false;
     }
     
+    uint8_t response[23];
+    uint8_t responseLength = 0;
+    uint16_t mhz = getCpuFrequencyMhz();
+    response[responseLength++] = zone;
+    response[responseLength++] = (mhz >> 8) & 0xFF;
+    response[responseLength++] = mhz & 0xFF;
+    uint32_t values[5] = {summary.count, summary.minCycles, summary.avgCycles, summary.maxCycles, summary.p99Cycles};
+    for (int i = 0; i < 5; i++) {
+        putUint32BE(&response[responseLength], values[i]);
+        responseLength += 4;
+    }
+    
+    sendDataResponse(response, responseLength);
+    
+    if (flags & STATS_FLAG_RESET) {
+        resetProfiler();
+    }
+    
+    return true;
+}
+
+/**
+ * Handle get telemetry command
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleGetTelemetryCommand(const uint8_t* data, uint8_t length) {
+    uint8_t frame[TELEMETRY_FRAME_SIZE];
+    uint8_t packed[RS485_PACKED_SIZE(TELEMETRY_FRAME_SIZE)];
+    sendDataResponse(packed, packRS485Payload(frame, buildTelemetryFrame(frame), packed));
+    return true;
+}
+
+/**
+ * Handle sine wave command
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleSineWaveCommand(const uint8_t* data, uint8_t length) {
     // Extract parameters: [mode][center][amplitude][period_low][period_high][reserved]
     uint8_t mode = data[0];
     uint8_t center = data[1];
     uint8_t amplitude = data[2];
     uint16_t period = (data[3] << 8) | data[4];
     
-    Serial.printf("RS-485: Sine wave command: Mode=%c, Center=%d, Amplitude=%d, Period=%dms\n", 
+    LOG_INFO(LOG_CAT_RS485, "RS-485: Sine wave command: Mode=%c, Center=%d, Amplitude=%d, Period=%dms", 
                   mode, center, amplitude, period);
     
     // Start sine wave generation
@@ -261,7 +518,7 @@ bool handleSineWaveCommand(const uint8_t* data, uint8_t length) {
         case 1: modeChar = 'c'; break; // Current
         case 2: modeChar = 'd'; break; // Digital
         default:
-            Serial.println("RS-485: Invalid sine wave mode");
+            LOG_WARN(LOG_CAT_RS485, "RS-485: Invalid sine wave mode");
             return false;
     }
     
@@ -277,9 +534,118 @@ bool handleSineWaveCommand(const uint8_t* data, uint8_t length) {
  * @return true if successful
  */
 bool handleStopSineCommand(const uint8_t* data, uint8_t length) {
-    Serial.println("RS-485: Stop sine wave command received");
+    LOG_INFO(LOG_CAT_RS485, "RS-485: Stop sine wave command received");
     
     stopSineWave();
     
     return true;
-} 
\ No newline at end of file
+}
+
+/**
+ * Handle stream setpoints command
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleStreamSetpointsCommand(const uint8_t* data, uint8_t length) {
+    // Payload bytes are 0xC0 | 6 bits so they can never look like 0x55/0xAA
+    uint16_t sequence;
+    if (!decodeStreamField(&data[0], &sequence) || (data[2] & 0xC0) != STREAM_GROUP_MARK) {
+        return false;
+    }
+    uint8_t channelMask = data[2] & 0x07;
+    
+    uint16_t values[3];
+    uint8_t valueCount = 0;
+    for (int ch = 0; ch < 3; ch++) {
+        if (channelMask & (1 << ch)) {
+            valueCount++;
+        }
+    }
+    if (length != 3 + valueCount * 2) {
+        return false;
+    }
+    for (int i = 0; i < valueCount; i++) {
+        if (!decodeStreamField(&data[3 + i * 2], &values[i])) {
+            return false;
+        }
+    }
+    
+    return pushStreamSetpoints(sequence, channelMask, values);
+}
+
+/**
+ * Handle stream stats command
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleStreamStatsCommand(const uint8_t* data, uint8_t length) {
+    const StreamStats* stats = getStreamStats();
+    uint32_t counters[6] = {
+        stats->received, stats->applied, stats->lost,
+        stats->late, stats->overflow, stats->underrun
+    };
+    
+    uint8_t response[24];
+    for (int i = 0; i < 6; i++) {
+        putUint32BE(&response[i * 4], counters[i]);
+    }
+    sendDataResponse(response, 24);
+    
+    if (length == 1 && data[0] == 0x01) {
+        resetStreamStats();
+    }
+    
+    return true;
+}
+
+/**
+ * Handle stream config command
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleStreamConfigCommand(const uint8_t* data, uint8_t length) {
+    uint16_t periodUs = (data[0] << 8) | data[1];
+    uint8_t prefill = data[2];
+    
+    if (periodUs == 0 || prefill == 0 || prefill > STREAM_BUFFER_SIZE) {
+        LOG_WARN(LOG_CAT_RS485, "RS-485: Invalid stream config parameters");
+        return false;
+    }
+    
+    configureSetpointStream(periodUs, prefill);
+    
+    return true;
+}
+
+/**
+ * Handle subscribe command
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handleSubscribeCommand(const uint8_t* data, uint8_t length) {
+    uint8_t heartbeat = length > 1 ? data[1] : CHANGE_HEARTBEAT_DEFAULT_S;
+    subscribeChanges(data[0], heartbeat);
+    LOG_INFO(LOG_CAT_RS485, "RS-485: Subscribed to changes 0x%02X, heartbeat %ds", data[0] & CHANGE_ALL, heartbeat);
+    return true;
+}
+
+/**
+ * Handle poll changes command
+ * Nodes with nothing to report stay silent, leaving their slot empty.
+ * @param data Command data
+ * @param length Data length
+ * @return true if successful
+ */
+bool handlePollChangesCommand(const uint8_t* data, uint8_t length) {
+    uint8_t notification[CHANGE_NOTIFY_MAX_SIZE];
+    uint8_t notificationLength = buildChangeNotification(notification);
+    if (notificationLength > 0) {
+        uint8_t packed[RS485_PACKED_SIZE(CHANGE_NOTIFY_MAX_SIZE)];
+        sendDataResponse(packed, packRS485Payload(notification, notificationLength, packed));
+    }
+    return true;
+}
@@ -1,14 +1,45 @@
 #include "rs485_serial.h"
 #include "device_id.h"
+#include "debug_log.h"
+#include "event_trace.h"
+#include <Preferences.h>
 
 // Global variables
 static uint8_t currentDeviceID = 0;
 static uint8_t rs485Buffer[RS485_BUFFER_SIZE];
 static uint8_t bufferIndex = 0;
-static RS485Command lastCommand;
+static bool discarding = false;    // Skipping bytes until the next start byte
+static RS485Command lastCommand;   // Command currently being executed
 
-// Forward declaration
-bool processCommand();
+// Parsed command ring, filled by processRS485Commands() and drained in order
+static RS485Command commandQueue[RS485_COMMAND_QUEUE_SIZE];
+static uint8_t queueHead = 0;      // Next slot to dequeue
+static uint8_t queueCount = 0;     // Number of queued commands
+
+// Link statistics
+static RS485LinkStats linkStats;
+
+// Group addressing and slotted replies
+static uint16_t groupMask = 0;            // Bit n = member of group 0xE0 + n
+
+// Multicast reply waiting for this device's slot
+struct SlottedReply {
+    uint32_t dueUs;                       // micros() at which the slot opens
+    uint8_t length;
+    uint8_t frame[RS485_MAX_REPLY_BYTES]; // One or more complete reply frames
+};
+static SlottedReply slottedReplies[RS485_SLOTTED_REPLIES];
+static uint8_t slottedHead = 0;
+static uint8_t slottedCount = 0;
+
+// RX event time, used to place frame ends on the line
+static volatile uint32_t rxEventUs = 0;
+static volatile bool rxEventFresh = false;
+static void (*rxCallback)() = nullptr;
+
+// Forward declarations
+static bool processCommand(uint32_t frameEndUs);
+static void onRS485RxEvent();
 
 // HardwareSerial instance for RS-485 interface
 HardwareSerial RS485Serial(RS485_SERIAL_NUM);  // Serial1 for work mode (receiving external RS-485 signals)
@@ -28,9 +59,42 @@ void initRS485Serial() {
     memset(rs485Buffer, 0, RS485_BUFFER_SIZE);
     bufferIndex = 0;
     lastCommand.valid = false;
+    queueHead = 0;
+    queueCount = 0;
+    resetRS485LinkStats();
+    slottedHead = 0;
+    slottedCount = 0;
+    
+    // The RX event fires RS485_RX_TIMEOUT_SYMBOLS after the last byte of a burst
+    RS485Serial.setRxTimeout(RS485_RX_TIMEOUT_SYMBOLS);
+    RS485Serial.onReceive(onRS485RxEvent, false);
+    
+    // Restore group membership from NVS
+    Preferences prefs;
+    prefs.begin("rs485", true);
+    groupMask = prefs.getUShort("groups", 0);
+    prefs.end();
     
     Serial.printf("Work Mode RS-485: GPIO %d(TX), %d(RX)\n", RS485_TX_PIN, RS485_RX_PIN);
-    Serial.printf("Device ID: %d, Baud Rate: %d\n", currentDeviceID, RS485_BAUDRATE);
+    Serial.printf("Device ID: %d, Baud Rate: %d, Groups: 0x%04X\n", currentDeviceID, RS485_BAUDRATE, groupMask);
+}
+
+/**
+ * UART RX event: note when the burst ended, then wake the consumer
+ */
+static void onRS485RxEvent() {
+    rxEventUs = micros();
+    rxEventFresh = true;
+    if (rxCallback) {
+        rxCallback();
+    }
+}
+
+/**
+ * Call a function whenever the RS-485 UART receives data
+ */
+void onRS485Receive(void (*callback)()) {
+    rxCallback = callback;
 }
 
 /**
@@ -40,14 +104,33 @@ void initRS485Serial() {
 bool processRS485Commands() {
     bool commandReceived = false;
     
+    serviceRS485Transmit();
+    
+    // Bytes already buffered ended before the last RX event, one character
+    // time apart; anything arriving while we read is stamped on arrival
+    int buffered = RS485Serial.available();
+    uint32_t lastByteEndUs = micros();
+    if (rxEventFresh) {
+        rxEventFresh = false;
+        lastByteEndUs = rxEventUs - RS485_RX_TIMEOUT_SYMBOLS * RS485_CHAR_US;
+    }
+    
     while (RS485Serial.available()) {
         uint8_t byte = RS485Serial.read();
+        linkStats.bytesReceived++;
+        uint32_t byteEndUs = buffered > 0 ? lastByteEndUs - (uint32_t)(--buffered) * RS485_CHAR_US : micros();
         
         // Simple command protocol: [START][DEVICE_ID][COMMAND][DATA...][END]
         // START = 0xAA, END = 0x55
         
         if (byte == 0xAA) {
+            if (bufferIndex > 0) {
+                // Start byte inside a frame: the partial frame is abandoned
+                linkStats.rejected++;
+                traceEvent(TRACE_FRAME_DROP, TRACE_DROP_FRAMING, bufferIndex > 2 ? rs485Buffer[2] : 0);
+            }
             // Start of new command
+            discarding = false;
             bufferIndex = 0;
             rs485Buffer[bufferIndex++] = byte;
         } else if (bufferIndex > 0 && bufferIndex < RS485_BUFFER_SIZE - 1) {
@@ -57,13 +140,24 @@ bool processRS485Commands() {
             // Check for end of command
             if (byte == 0x55 && bufferIndex >= 4) {
                 // Process complete command
-                if (processCommand()) {
+                linkStats.framesReceived++;
+                if (processCommand(byteEndUs)) {
                     commandReceived = true;
                 }
                 bufferIndex = 0; // Reset for next command
             }
         } else {
-            // Invalid state, reset
+            // Invalid state, reset and skip to the next start byte
+            if (bufferIndex > 0) {
+                linkStats.overflow++; // Frame ran past the receive buffer
+                traceEvent(TRACE_FRAME_DROP, TRACE_DROP_TOO_LONG, rs485Buffer[2]);
+                discarding = true;
+            } else if (!discarding) {
+                // Bytes outside a frame, counted once per run
+                linkStats.rejected++;
+                traceEvent(TRACE_FRAME_DROP, TRACE_DROP_FRAMING, 0);
+                discarding = true;
+            }
             bufferIndex = 0;
         }
     }
@@ -73,39 +167,65 @@ bool processRS485Commands() {
 
 /**
  * Process a complete command from buffer
+ * @param frameEndUs micros() at which the end byte finished on the line
  * @return true if command is valid and for this device
  */
-bool processCommand() {
+static bool processCommand(uint32_t frameEndUs) {
     if (bufferIndex < 4) return false; // Minimum command length
     
-    // Check start and end bytes
-    if (rs485Buffer[0] != 0xAA || rs485Buffer[bufferIndex - 1] != 0x55) {
+    // Extract device ID and command type
+    uint8_t targetDeviceID = rs485Buffer[1];
+    uint8_t commandType = rs485Buffer[2] & ~RS485_NO_REPLY_FLAG;
+    uint8_t flags = (rs485Buffer[2] & RS485_NO_REPLY_FLAG) ? RS485_FLAG_NO_REPLY : 0;
+    
+    // Check if command is for this device, one of its groups, or broadcast
+    if (targetDeviceID == RS485_BROADCAST_ID) {
+        flags |= RS485_FLAG_MULTICAST;
+    } else if (targetDeviceID >= RS485_GROUP_BASE && targetDeviceID < RS485_GROUP_BASE + RS485_GROUP_COUNT) {
+        if (!(groupMask & (1 << (targetDeviceID - RS485_GROUP_BASE)))) {
+            linkStats.notForMe++;
+            return false;
+        }
+        flags |= RS485_FLAG_MULTICAST;
+    } else if (targetDeviceID != currentDeviceID) {
+        linkStats.notForMe++;
         return false;
     }
     
-    // Extract device ID and command type
-    uint8_t targetDeviceID = rs485Buffer[1];
-    uint8_t commandType = rs485Buffer[2];
+    uint8_t dataLength = bufferIndex - 4; // Exclude start, device ID, command, end
+    if (dataLength > RS485_MAX_COMMAND_LENGTH - 2) {
+        linkStats.overflow++; // Payload does not fit in a command slot
+        traceEvent(TRACE_FRAME_DROP, TRACE_DROP_TOO_LONG, commandType);
+        return false;
+    }
     
-    // Check if command is for this device (0xFF = broadcast)
-    if (targetDeviceID != currentDeviceID && targetDeviceID != 0xFF) {
+    if (queueCount >= RS485_COMMAND_QUEUE_SIZE) {
+        linkStats.dropped++;
+        traceEvent(TRACE_FRAME_DROP, TRACE_DROP_QUEUE_FULL, commandType);
+        LOG_WARN(LOG_CAT_RS485, "RS-485: Command queue full, dropped Type=0x%02X", commandType);
         return false;
     }
     
-    // Store command
-    lastCommand.deviceID = targetDeviceID;
-    lastCommand.commandType = commandType;
-    lastCommand.length = bufferIndex - 4; // Exclude start, device ID, command, end
+    // Store command in the next free slot
+    RS485Command* slot = &commandQueue[(queueHead + queueCount) % RS485_COMMAND_QUEUE_SIZE];
+    slot->deviceID = targetDeviceID;
+    slot->commandType = commandType;
+    slot->length = dataLength;
+    slot->flags = flags;
+    slot->timestamp = frameEndUs;
+    slot->replyTimestamp = 0;
     
     // Copy data
-    if (lastCommand.length > 0 && lastCommand.length < RS485_MAX_COMMAND_LENGTH - 2) {
-        memcpy(lastCommand.data, &rs485Buffer[3], lastCommand.length);
+    if (dataLength > 0) {
+        memcpy(slot->data, &rs485Buffer[3], dataLength);
     }
     
-    lastCommand.valid = true;
+    slot->valid = true;
+    queueCount++;
+    traceEvent(TRACE_FRAME_RX, commandType, dataLength);
     
     // Log received command
-    Serial.printf("Work Mode RS-485 Command received: Device=%d, Type=0x%02X, Length=%d\n", targetDeviceID, commandType, lastCommand.length);
+    LOG_DEBUG(LOG_CAT_RS485, "Work Mode RS-485 Command received: Device=%d, Type=0x%02X, Length=%d", targetDeviceID, commandType, dataLength);
     
     return true;
 }
@@ -118,10 +238,11 @@ bool processCommand() {
  * @param length Data length
  */
 void sendRS485Response(uint8_t deviceID, uint8_t commandType, const uint8_t* data, uint8_t length) {
-    if (length > RS485_MAX_COMMAND_LENGTH - 2) {
-        Serial.println("RS-485: Response too long");
+    if (length > RS485_MAX_REPLY_DATA) {
+        LOG_WARN(LOG_CAT_RS485, "RS-485: Response too long");
         return;
     }
+    traceEvent(TRACE_REPLY_TX, commandType, length);
     // Send response: [START][DEVICE_ID][COMMAND][DATA...][END]
     RS485Serial.write(0xAA); // Start byte
     RS485Serial.write(deviceID);
@@ -131,12 +252,51 @@ void sendRS485Response(uint8_t deviceID, uint8_t commandType, const uint8_t* dat
     }
     RS485Serial.write(0x55); // End byte
     RS485Serial.flush(); // Ensure all data is sent
-    Serial.printf("Work Mode RS-485 Response sent: Device=%d, Type=0x%02X, Length=%d\n", deviceID, commandType, length);
+    LOG_DEBUG(LOG_CAT_RS485, "Work Mode RS-485 Response sent: Device=%d, Type=0x%02X, Length=%d", deviceID, commandType, length);
+}
+
+/**
+ * Take the oldest queued command and make it the current command
+ * @return true if a command was dequeued
+ */
+bool dequeueRS485Command() {
+    if (queueCount == 0) {
+        return false;
+    }
+    
+    lastCommand = commandQueue[queueHead];
+    commandQueue[queueHead].valid = false;
+    queueHead = (queueHead + 1) % RS485_COMMAND_QUEUE_SIZE;
+    queueCount--;
+    return true;
+}
+
+/**
+ * Get number of commands waiting in the queue
+ * @return Queued command count
+ */
+uint8_t getRS485QueuedCount() {
+    return queueCount;
 }
 
 /**
- * Get the last received command
- * @return Pointer to the last received command
+ * Get link statistics
+ * @return Pointer to the link counters
+ */
+const RS485LinkStats* getRS485LinkStats() {
+    return &linkStats;
+}
+
+/**
+ * Reset link statistics
+ */
+void resetRS485LinkStats() {
+    memset(&linkStats, 0, sizeof(linkStats));
+}
+
+/**
+ * Get the current command (the one most recently dequeued)
+ * @return Pointer to the current command
  */
 RS485Command* getLastCommand() {
     return &lastCommand;
@@ -167,13 +327,119 @@ uint8_t getCurrentDeviceID() {
     return currentDeviceID;
 }
 
+/**
+ * Set group membership mask
+ * @param mask Group membership bitmask
+ * @param persist true to store the mask in NVS
+ */
+void setRS485GroupMask(uint16_t mask, bool persist) {
+    groupMask = mask;
+    if (persist) {
+        Preferences prefs;
+        prefs.begin("rs485", false);
+        prefs.putUShort("groups", mask);
+        prefs.end();
+    }
+    Serial.printf("RS-485 Group mask set to: 0x%04X%s\n", mask, persist ? " (saved)" : "");
+}
+
+/**
+ * Get group membership mask
+ * @return Group membership bitmask
+ */
+uint16_t getRS485GroupMask() {
+    return groupMask;
+}
+
+/**
+ * Send slotted replies whose transmit slot has arrived
+ */
+void serviceRS485Transmit() {
+    while (slottedCount > 0) {
+        SlottedReply& reply = slottedReplies[slottedHead];
+        if ((int32_t)(micros() - reply.dueUs) < 0) {
+            return;
+        }
+        RS485Serial.write(reply.frame, reply.length);
+        RS485Serial.flush();
+        LOG_DEBUG(LOG_CAT_RS485, "Work Mode RS-485 Slotted reply sent: %d bytes", reply.length);
+        slottedHead = (slottedHead + 1) % RS485_SLOTTED_REPLIES;
+        slottedCount--;
+    }
+}
+
+/**
+ * Time until the next queued slotted reply is due
+ */
+uint32_t getRS485TransmitWaitUs() {
+    if (slottedCount == 0) {
+        return UINT32_MAX;
+    }
+    int32_t wait = (int32_t)(slottedReplies[slottedHead].dueUs - micros());
+    return wait > 0 ? (uint32_t)wait : 0;
+}
+
+/**
+ * Reply to the current command, honouring no-reply and multicast slotting
+ * @param data Response data
+ * @param length Data length
+ */
+static void replyToCurrentCommand(const uint8_t* data, uint8_t length) {
+    if (lastCommand.flags & RS485_FLAG_NO_REPLY) {
+        return;
+    }
+    if (lastCommand.replyTimestamp == 0) {
+        lastCommand.replyTimestamp = micros() | 1; // 0 means "not replied yet"
+    }
+    
+    // Replies always carry our own ID so multicast answers can be told apart
+    if (!(lastCommand.flags & RS485_FLAG_MULTICAST)) {
+        sendRS485Response(currentDeviceID, lastCommand.commandType, data, length);
+        return;
+    }
+    if (length > RS485_MAX_REPLY_DATA) {
+        LOG_WARN(LOG_CAT_RS485, "RS-485: Response too long");
+        return;
+    }
+    
+    // Multicast: hold the frame until our slot after this request opens.
+    // Frames answering the same request share one entry; each request gets
+    // its own due time, so a second multicast never rides on the first one's slot.
+    uint32_t dueUs = lastCommand.timestamp + (uint32_t)currentDeviceID * RS485_REPLY_SLOT_US;
+    SlottedReply* reply = nullptr;
+    if (slottedCount > 0) {
+        SlottedReply& last = slottedReplies[(slottedHead + slottedCount - 1) % RS485_SLOTTED_REPLIES];
+        if (last.dueUs == dueUs && last.length + length + 4 <= RS485_MAX_REPLY_BYTES) {
+            reply = &last;
+        }
+    }
+    if (!reply) {
+        if (slottedCount >= RS485_SLOTTED_REPLIES) {
+            LOG_WARN(LOG_CAT_RS485, "RS-485: Slotted reply queue full, reply dropped");
+            return;
+        }
+        reply = &slottedReplies[(slottedHead + slottedCount) % RS485_SLOTTED_REPLIES];
+        reply->dueUs = dueUs;
+        reply->length = 0;
+        slottedCount++;
+    }
+    reply->frame[reply->length++] = 0xAA;
+    reply->frame[reply->length++] = currentDeviceID;
+    reply->frame[reply->length++] = lastCommand.commandType;
+    if (length > 0 && data != nullptr) {
+        memcpy(&reply->frame[reply->length], data, length);
+        reply->length += length;
+    }
+    reply->frame[reply->length++] = 0x55;
+}
+
 /**
  * Send acknowledgment response
  * @param success true for success, false for error
  */
 void sendAckResponse(bool success) {
     uint8_t response = success ? 0x01 : 0x00;
-    sendRS485Response(lastCommand.deviceID, lastCommand.commandType, &response, 1);
+    replyToCurrentCommand(&response, 1);
 }
 
 /**
@@ -182,5 +448,47 @@ void sendAckResponse(bool success) {
  * @param length Data length
  */
 void sendDataResponse(const uint8_t* data, uint8_t length) {
-    sendRS485Response(lastCommand.deviceID, lastCommand.commandType, data, length);
+    replyToCurrentCommand(data, length);
+}
+
+/**
+ * Pack binary reply data so it cannot contain frame delimiters
+ */
+uint8_t packRS485Payload(const uint8_t* data, uint8_t length, uint8_t* out) {
+    uint8_t packed = 0;
+    uint16_t bits = 0;
+    uint8_t bitCount = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        bits = (bits << 8) | data[i];
+        bitCount += 8;
+        while (bitCount >= 6) {
+            bitCount -= 6;
+            out[packed++] = RS485_PACKED_MARK | ((bits >> bitCount) & 0x3F);
+        }
+    }
+    if (bitCount > 0) {
+        out[packed++] = RS485_PACKED_MARK | ((bits << (6 - bitCount)) & 0x3F);
+    }
+    return packed;
+}
+
+/**
+ * Unpack reply data packed by packRS485Payload()
+ */
+uint8_t unpackRS485Payload(const uint8_t* data, uint8_t length, uint8_t* out) {
+    uint8_t unpacked = 0;
+    uint16_t bits = 0;
+    uint8_t bitCount = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        if ((data[i] & 0xC0) != RS485_PACKED_MARK) {
+            return 0;
+        }
+        bits = (bits << 6) | (data[i] & 0x3F);
+        bitCount += 6;
+        if (bitCount >= 8) {
+            bitCount -= 8;
+            out[unpacked++] = (bits >> bitCount) & 0xFF;
+        }
+    }
+    return unpacked; // Leftover bits are padding
 } 
\ No newline at end of file
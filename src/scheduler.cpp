@@ -0,0 +1,212 @@
+#include "scheduler.h"
+#include <freertos/task.h>
+
+// Job table entry
+struct SchedulerJob {
+    SchedulerJobFn fn;
+    uint32_t nextRelease;          // micros() of the next periodic release
+    volatile bool signalled;       // Released by signalSchedulerJob()
+    volatile uint32_t signalTime;  // micros() of the signal
+    SchedulerJobStats stats;
+};
+
+static SchedulerJob jobs[SCHEDULER_MAX_JOBS];
+static uint8_t jobCount = 0;
+static TaskHandle_t schedulerTask = nullptr;
+
+/**
+ * Initialize the scheduler for the calling task
+ */
+void initScheduler() {
+    jobCount = 0;
+    schedulerTask = xTaskGetCurrentTaskHandle();
+}
+
+/**
+ * Add a job
+ */
+int8_t addSchedulerJob(const char* name, SchedulerJobFn fn, uint32_t periodUs, uint32_t deadlineUs, uint8_t priority) {
+    if (jobCount >= SCHEDULER_MAX_JOBS) {
+        Serial.printf("Scheduler: Job table full, '%s' not added\n", name);
+        return -1;
+    }
+    SchedulerJob& job = jobs[jobCount];
+    memset(&job.stats, 0, sizeof(job.stats));
+    job.fn = fn;
+    job.nextRelease = micros();
+    job.signalled = false;
+    job.stats.name = name;
+    job.stats.periodUs = periodUs;
+    job.stats.deadlineUs = deadlineUs;
+    job.stats.priority = priority;
+    return jobCount++;
+}
+
+/**
+ * Release a job now
+ */
+void signalSchedulerJob(int8_t id) {
+    if (id < 0 || id >= jobCount) {
+        return;
+    }
+    if (!jobs[id].signalled) {
+        jobs[id].signalTime = micros();
+        jobs[id].signalled = true;
+    }
+    if (schedulerTask) {
+        xTaskNotifyGive(schedulerTask);
+    }
+}
+
+/**
+ * Change a job's period
+ */
+void setSchedulerJobPeriod(int8_t id, uint32_t periodUs) {
+    if (id < 0 || id >= jobCount) {
+        return;
+    }
+    jobs[id].stats.periodUs = periodUs;
+    jobs[id].nextRelease = micros() + periodUs;
+}
+
+/**
+ * Release time of a job if it is ready to run
+ * @return true if released
+ */
+static bool jobRelease(const SchedulerJob& job, uint32_t now, uint32_t* release) {
+    bool periodicDue = job.stats.periodUs != SCHEDULER_EVENT_ONLY && (int32_t)(now - job.nextRelease) >= 0;
+    if (job.signalled && (!periodicDue || (int32_t)(job.signalTime - job.nextRelease) < 0)) {
+        *release = job.signalTime;
+        return true;
+    }
+    if (periodicDue) {
+        *release = job.nextRelease;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Run one job and account for its timing
+ */
+static void runJob(SchedulerJob& job, uint32_t release) {
+    SchedulerJobStats& stats = job.stats;
+    job.signalled = false; // Signals arriving while it runs release it again
+
+    uint32_t start = micros();
+    job.fn();
+    uint32_t finish = micros();
+
+    uint32_t latency = start - release;
+    uint32_t runTime = finish - start;
+    stats.runs++;
+    stats.totalRunUs += runTime;
+    if (latency > stats.maxLatencyUs) {
+        stats.maxLatencyUs = latency;
+    }
+    if (runTime > stats.maxRunUs) {
+        stats.maxRunUs = runTime;
+    }
+    if (finish - release > stats.deadlineUs) {
+        stats.overruns++;
+    }
+
+    // Advance the periodic release, skipping periods that have already passed
+    if (stats.periodUs != SCHEDULER_EVENT_ONLY && (int32_t)(finish - job.nextRelease) >= 0) {
+        uint32_t behind = finish - job.nextRelease;
+        uint32_t periods = behind / stats.periodUs + 1;
+        stats.skipped += periods - 1;
+        job.nextRelease += periods * stats.periodUs;
+    }
+}
+
+/**
+ * Run the most urgent released job, or sleep until the next release or event
+ */
+void runScheduler() {
+    uint32_t now = micros();
+    int8_t best = -1;
+    uint32_t bestRelease = 0;
+    uint32_t bestDeadline = 0;
+    uint32_t sleepUs = UINT32_MAX;
+
+    for (uint8_t i = 0; i < jobCount; i++) {
+        const SchedulerJob& job = jobs[i];
+        uint32_t release;
+        if (jobRelease(job, now, &release)) {
+            uint32_t deadline = release + job.stats.deadlineUs;
+            if (best < 0 || job.stats.priority > jobs[best].stats.priority ||
+                (job.stats.priority == jobs[best].stats.priority && (int32_t)(deadline - bestDeadline) < 0)) {
+                best = i;
+                bestRelease = release;
+                bestDeadline = deadline;
+            }
+        } else if (job.stats.periodUs != SCHEDULER_EVENT_ONLY) {
+            uint32_t wait = job.nextRelease - now;
+            if (wait < sleepUs) {
+                sleepUs = wait;
+            }
+        }
+    }
+
+    if (best >= 0) {
+        runJob(jobs[best], bestRelease);
+        return;
+    }
+
+    // Nothing ready: block until the next release or an event. The wait is
+    // rounded up to whole ticks (at least one) so the task never spins.
+    TickType_t ticks = portMAX_DELAY;
+    if (sleepUs != UINT32_MAX) {
+        ticks = pdMS_TO_TICKS((sleepUs + 999) / 1000);
+        if (ticks == 0) {
+            ticks = 1;
+        }
+    }
+    ulTaskNotifyTake(pdTRUE, ticks);
+}
+
+/**
+ * Get job statistics
+ */
+const SchedulerJobStats* getSchedulerJobStats(int8_t id) {
+    return id >= 0 && id < jobCount ? &jobs[id].stats : nullptr;
+}
+
+/**
+ * Get number of jobs
+ */
+uint8_t getSchedulerJobCount() {
+    return jobCount;
+}
+
+/**
+ * Clear all job statistics
+ */
+void resetSchedulerStats() {
+    for (uint8_t i = 0; i < jobCount; i++) {
+        SchedulerJobStats& stats = jobs[i].stats;
+        stats.runs = 0;
+        stats.overruns = 0;
+        stats.skipped = 0;
+        stats.maxLatencyUs = 0;
+        stats.maxRunUs = 0;
+        stats.totalRunUs = 0;
+    }
+}
+
+/**
+ * Print job statistics to the USB serial port
+ */
+void printSchedulerStats() {
+    Serial.println("Job          Prio  Period(us)  Runs      Overruns  Skipped  MaxLat(us)  AvgRun(us)  MaxRun(us)");
+    for (uint8_t i = 0; i < jobCount; i++) {
+        const SchedulerJobStats& stats = jobs[i].stats;
+        Serial.printf("%-12s %4u  %10lu  %-8lu  %-8lu  %-7lu  %10lu  %10lu  %10lu\n",
+                      stats.name, stats.priority, (unsigned long)stats.periodUs,
+                      (unsigned long)stats.runs, (unsigned long)stats.overruns, (unsigned long)stats.skipped,
+                      (unsigned long)stats.maxLatencyUs,
+                      (unsigned long)(stats.runs ? stats.totalRunUs / stats.runs : 0),
+                      (unsigned long)stats.maxRunUs);
+    }
+}
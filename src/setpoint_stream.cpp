@@ -0,0 +1,246 @@
+#include "setpoint_stream.h"
+#include "command_handler.h"
+#include "output_engine.h"
+#include "debug_log.h"
+
+// Buffered setpoint packet
+struct StreamPacket {
+    uint16_t sequence;
+    uint8_t channelMask;
+    uint16_t values[3];
+};
+
+// Jitter buffer, kept sorted by sequence number
+static StreamPacket streamBuffer[STREAM_BUFFER_SIZE];
+static uint8_t streamCount = 0;
+
+// Playback state
+static bool streamPlaying = false;      // Prefill reached, timer running
+static uint16_t nextSequence = 0;       // Sequence expected at the next tick
+static uint32_t lastTickTime = 0;       // micros() of the last apply tick
+static unsigned long lastPacketTime = 0; // millis() of the last packet received
+static uint32_t streamPeriodUs = STREAM_DEFAULT_PERIOD_US;
+static uint8_t streamPrefill = STREAM_DEFAULT_PREFILL;
+
+static StreamStats streamStats;
+
+/**
+ * Compare sequence numbers with 12-bit wraparound
+ * @return Signed distance from b to a
+ */
+static int16_t sequenceDiff(uint16_t a, uint16_t b) {
+    int16_t diff = (a - b) & STREAM_SEQUENCE_MASK;
+    return diff > STREAM_SEQUENCE_MASK / 2 ? diff - (STREAM_SEQUENCE_MASK + 1) : diff;
+}
+
+/**
+ * Decode one 12-bit field sent as two 6-bit groups (0xC0 | bits, high first)
+ * @param bytes Two encoded bytes
+ * @param out Receives the value
+ * @return false if a byte lacks the 0xC0 marker
+ */
+bool decodeStreamField(const uint8_t* bytes, uint16_t* out) {
+    if ((bytes[0] & 0xC0) != STREAM_GROUP_MARK || (bytes[1] & 0xC0) != STREAM_GROUP_MARK) {
+        return false;
+    }
+    *out = ((bytes[0] & 0x3F) << 6) | (bytes[1] & 0x3F);
+    return true;
+}
+
+/**
+ * Initialize setpoint stream
+ */
+void initSetpointStream() {
+    streamCount = 0;
+    streamPlaying = false;
+    resetStreamStats();
+    LOG_INFO(LOG_CAT_STREAM, "Setpoint stream initialized");
+}
+
+/**
+ * Check whether the stream is playing
+ */
+bool isSetpointStreamActive() {
+    return streamPlaying;
+}
+
+/**
+ * Queue a setpoint packet
+ * @param sequence Packet sequence number (wraps at STREAM_SEQUENCE_MASK)
+ * @param channelMask Bit n set = packet carries a value for channel n+1
+ * @param values Raw values (centi-units) for each set bit, in channel order
+ * @return true if the packet was buffered
+ */
+bool pushStreamSetpoints(uint16_t sequence, uint8_t channelMask, const uint16_t* values) {
+    if (!isOutputEngineContext()) {
+        OutputCommand command = {};
+        command.type = OUT_CMD_STREAM_PACKET;
+        command.stream.sequence = sequence;
+        command.stream.channelMask = channelMask & 0x07;
+        uint8_t valueCount = 0;
+        for (uint8_t ch = 0; ch < 3; ch++) {
+            if (command.stream.channelMask & (1 << ch)) {
+                command.stream.values[valueCount] = values[valueCount];
+                valueCount++;
+            }
+        }
+        return postOutputCommand(command);
+    }
+
+    sequence &= STREAM_SEQUENCE_MASK;
+
+    if (streamPlaying) {
+        int16_t ahead = sequenceDiff(sequence, nextSequence);
+        if (ahead < -STREAM_RESYNC_DISTANCE || ahead > STREAM_RESYNC_DISTANCE) {
+            // Sender restarted or jumped: drop the buffer and prime again
+            streamPlaying = false;
+            streamCount = 0;
+        } else if (ahead < 0) {
+            // Already past its slot
+            streamStats.late++;
+            return false;
+        }
+    }
+
+    // Find sorted insert position, rejecting duplicates
+    uint8_t pos = streamCount;
+    for (uint8_t i = 0; i < streamCount; i++) {
+        int16_t diff = sequenceDiff(sequence, streamBuffer[i].sequence);
+        if (diff == 0) {
+            streamStats.late++;
+            return false;
+        }
+        if (diff < 0) {
+            pos = i;
+            break;
+        }
+    }
+
+    if (streamCount >= STREAM_BUFFER_SIZE) {
+        streamStats.overflow++;
+        return false;
+    }
+
+    for (uint8_t i = streamCount; i > pos; i--) {
+        streamBuffer[i] = streamBuffer[i - 1];
+    }
+
+    StreamPacket& packet = streamBuffer[pos];
+    packet.sequence = sequence;
+    packet.channelMask = channelMask & 0x07;
+    uint8_t valueIndex = 0;
+    for (uint8_t ch = 0; ch < 3; ch++) {
+        packet.values[ch] = (packet.channelMask & (1 << ch)) ? values[valueIndex++] : 0;
+    }
+    streamCount++;
+    streamStats.received++;
+    lastPacketTime = millis();
+
+    // Start playback once the prefill depth is reached
+    if (!streamPlaying && streamCount >= streamPrefill) {
+        streamPlaying = true;
+        nextSequence = streamBuffer[0].sequence;
+        lastTickTime = micros();
+    }
+    return true;
+}
+
+/**
+ * Write a packet's values to the outputs according to each channel's mode
+ */
+static void applyStreamPacket(const StreamPacket& packet) {
+    for (uint8_t ch = 0; ch < 3; ch++) {
+        if (packet.channelMask & (1 << ch)) {
+            writeSignalOutput(ch + 1, packet.values[ch] / 100.0f);
+        }
+    }
+}
+
+/**
+ * Apply buffered setpoints that are due (called by the output engine each tick)
+ * When the loop falls behind, every elapsed tick still consumes its packet
+ * but only the newest one is written to the DACs.
+ */
+void updateSetpointStream() {
+    if (!streamPlaying) {
+        return;
+    }
+
+    // Stream stopped: drop back to prefill so the next burst re-primes
+    if (millis() - lastPacketTime > STREAM_TIMEOUT_MS && streamCount == 0) {
+        streamPlaying = false;
+        return;
+    }
+
+    const StreamPacket* latest = nullptr;
+    StreamPacket applied;
+    while ((uint32_t)(micros() - lastTickTime) >= streamPeriodUs) {
+        lastTickTime += streamPeriodUs;
+
+        if (streamCount == 0) {
+            streamStats.underrun++;
+            nextSequence = (nextSequence + 1) & STREAM_SEQUENCE_MASK;
+            continue;
+        }
+
+        int16_t gap = sequenceDiff(streamBuffer[0].sequence, nextSequence);
+        if (gap > 0) {
+            // Hold the head for its own slot; the missing sequence is lost
+            streamStats.lost++;
+            nextSequence = (nextSequence + 1) & STREAM_SEQUENCE_MASK;
+            continue;
+        }
+
+        applied = streamBuffer[0];
+        latest = &applied;
+        for (uint8_t i = 1; i < streamCount; i++) {
+            streamBuffer[i - 1] = streamBuffer[i];
+        }
+        streamCount--;
+        streamStats.applied++;
+        nextSequence = (applied.sequence + 1) & STREAM_SEQUENCE_MASK;
+    }
+
+    if (latest) {
+        applyStreamPacket(*latest);
+    }
+}
+
+/**
+ * Configure playback timing
+ * @param periodUs Apply period in microseconds
+ * @param prefill Packets buffered before playback starts (1-STREAM_BUFFER_SIZE)
+ */
+void configureSetpointStream(uint32_t periodUs, uint8_t prefill) {
+    if (!isOutputEngineContext()) {
+        OutputCommand command = {};
+        command.type = OUT_CMD_STREAM_CONFIG;
+        command.streamConfig.periodUs = periodUs;
+        command.streamConfig.prefill = prefill;
+        postOutputCommand(command);
+        return;
+    }
+    if (periodUs == 0) periodUs = STREAM_DEFAULT_PERIOD_US;
+    if (prefill < 1) prefill = 1;
+    if (prefill > STREAM_BUFFER_SIZE) prefill = STREAM_BUFFER_SIZE;
+    streamPeriodUs = periodUs;
+    streamPrefill = prefill;
+    streamCount = 0;
+    streamPlaying = false;
+    LOG_INFO(LOG_CAT_STREAM, "Setpoint stream: period %luus, prefill %d", (unsigned long)periodUs, prefill);
+}
+
+/**
+ * Get stream counters
+ * @return Pointer to the stream counters
+ */
+const StreamStats* getStreamStats() {
+    return &streamStats;
+}
+
+/**
+ * Reset stream counters
+ */
+void resetStreamStats() {
+    memset(&streamStats, 0, sizeof(streamStats));
+}
@@ -1,10 +1,14 @@
 #include "sine_wave_generator.h"
+#include "debug_log.h"
+#include "change_notify.h"
+#include "text_command.h"
 #include "dac_controller.h"
 #include "relay_controller.h"
 #include "utils.h"
+#include "output_engine.h"
 
 // Global variables for sine wave generation
-bool sineWaveActive = false;
+volatile bool sineWaveActive = false; // Read from other tasks
 unsigned long lastUpdateTime = 0;
 const unsigned long UPDATE_INTERVAL = 250; // 0.25 seconds in milliseconds
 
@@ -32,7 +36,7 @@ SineSignalMap sineSignalMap[3] = {
 void initSineWaveGenerator() {
     sineWaveActive = false;
     lastUpdateTime = 0;
-    Serial.println("Sine Wave Generator initialized (experimental feature)");
+    LOG_INFO(LOG_CAT_WAVE, "Sine Wave Generator initialized (experimental feature)");
 }
 
 /**
@@ -45,20 +49,32 @@ void initSineWaveGenerator() {
  * @param overshoot: Whether to allow overshoot beyond safe ranges
  */
 void startSineWave(float amplitude, float period, float center, uint8_t signal, char mode, bool overshoot) {
+    if (!isOutputEngineContext()) {
+        OutputCommand command = {};
+        command.type = OUT_CMD_SINE_START;
+        command.sine.amplitude = amplitude;
+        command.sine.period = period;
+        command.sine.center = center;
+        command.sine.signal = signal;
+        command.sine.mode = mode;
+        postOutputCommand(command);
+        return;
+    }
+
     if (signal < 1 || signal > 3) {
-        Serial.println("Invalid signal number. Use 1-3.");
+        LOG_WARN(LOG_CAT_WAVE, "Invalid signal number. Use 1-3.");
         return;
     }
     
     if (mode != 'v' && mode != 'c' && mode != 'd') {
-        Serial.println("Invalid mode. Use 'v' for voltage, 'c' for current, or 'd' for digital.");
+        LOG_WARN(LOG_CAT_WAVE, "Invalid mode. Use 'v' for voltage, 'c' for current, or 'd' for digital.");
         return;
     }
     
     // Validate amplitude and center point based on mode
     if (mode == 'v') {
         if (amplitude < 0) {
-            Serial.println("Invalid voltage amplitude. Use 0 or higher.");
+            LOG_WARN(LOG_CAT_WAVE, "Invalid voltage amplitude. Use 0 or higher.");
             return;
         }
         
@@ -68,14 +84,14 @@ void startSineWave(float amplitude, float period, float center, uint8_t signal,
         
         // Warn if output range exceeds safe limits (but don't block - will be clamped at runtime)
         if (minOutput < 0 || maxOutput > 10.0) {
-            Serial.printf("Warning: Output range %.1f-%.1fV exceeds 0-10V safe range.\n", minOutput, maxOutput);
-            Serial.println("Values will be clamped to safe boundaries during generation.");
+            LOG_WARN(LOG_CAT_WAVE, "Warning: Output range %.1f-%.1fV exceeds 0-10V safe range.", minOutput, maxOutput);
+            LOG_WARN(LOG_CAT_WAVE, "Values will be clamped to safe boundaries during generation.");
         }
     }
     
         if (mode == 'c') {
         if (amplitude < 0) {
-            Serial.println("Invalid current amplitude. Use 0 or higher.");
+            LOG_WARN(LOG_CAT_WAVE, "Invalid current amplitude. Use 0 or higher.");
         return;
     }
     
@@ -85,14 +101,14 @@ void startSineWave(float amplitude, float period, float center, uint8_t signal,
         
         // Warn if output range exceeds safe limits (but don't block - will be clamped at runtime)
         if (minOutput < 0 || maxOutput > 25.0) {
-            Serial.printf("Warning: Output range %.1f-%.1fmA exceeds 0-25mA safe range.\n", minOutput, maxOutput);
-            Serial.println("Values will be clamped to safe boundaries during generation.");
+            LOG_WARN(LOG_CAT_WAVE, "Warning: Output range %.1f-%.1fmA exceeds 0-25mA safe range.", minOutput, maxOutput);
+            LOG_WARN(LOG_CAT_WAVE, "Values will be clamped to safe boundaries during generation.");
         }
     }
     
     if (mode == 'd') {
         if (amplitude < 0) {
-            Serial.println("Invalid digital amplitude. Use 0 or higher.");
+            LOG_WARN(LOG_CAT_WAVE, "Invalid digital amplitude. Use 0 or higher.");
         return;
         }
         
@@ -101,13 +117,13 @@ void startSineWave(float amplitude, float period, float center, uint8_t signal,
         float minOutput = center - amplitude;
         float maxOutput = center + amplitude;
         
-        Serial.printf("Digital mode: Threshold center=%.2f, amplitude=%.2f\n", center, amplitude);
-        Serial.printf("Digital range: %.2f-%.2f (values > 0.5 = HIGH, <= 0.5 = LOW)\n", minOutput, maxOutput);
+        LOG_INFO(LOG_CAT_WAVE, "Digital mode: Threshold center=%.2f, amplitude=%.2f", center, amplitude);
+        LOG_INFO(LOG_CAT_WAVE, "Digital range: %.2f-%.2f (values > 0.5 = HIGH, <= 0.5 = LOW)", minOutput, maxOutput);
     }
     
     // Validate period
     if (period < 1.0 || period > 60.0) {
-        Serial.println("Invalid period. Use 1-60 seconds.");
+        LOG_WARN(LOG_CAT_WAVE, "Invalid period. Use 1-60 seconds.");
         return;
     }
     
@@ -120,6 +136,7 @@ void startSineWave(float amplitude, float period, float center, uint8_t signal,
     startTime = millis();
     lastUpdateTime = 0;
     sineWaveActive = true;
+    markStateChanged(CHANGE_WAVE);
     
     // Set signal mode (only for analog modes)
     if (mode != 'd') {
@@ -130,16 +147,16 @@ void startSineWave(float amplitude, float period, float center, uint8_t signal,
     const char* modeStr = (mode == 'v') ? "voltage" : (mode == 'c') ? "current" : "digital";
     const char* unitStr = (mode == 'v') ? "V" : (mode == 'c') ? "mA" : "";
     
-    Serial.printf("Sine wave started: Signal %d, %s mode\n", signal, modeStr);
-    Serial.printf("Amplitude: %.2f%s, Center: %.2f%s, Period: %.1fs\n", 
+    LOG_INFO(LOG_CAT_WAVE, "Sine wave started: Signal %d, %s mode", signal, modeStr);
+    LOG_INFO(LOG_CAT_WAVE, "Amplitude: %.2f%s, Center: %.2f%s, Period: %.1fs", 
                   amplitude, unitStr, 
                   center, unitStr, 
                   period);
     
     if (mode == 'd') {
-        Serial.printf("Digital threshold: %.2f (values > 0.5 = HIGH, <= 0.5 = LOW)\n", center);
+        LOG_INFO(LOG_CAT_WAVE, "Digital threshold: %.2f (values > 0.5 = HIGH, <= 0.5 = LOW)", center);
     } else {
-        Serial.printf("Output range: %.1f-%.1f%s (will be clamped to safe boundaries)\n", 
+        LOG_INFO(LOG_CAT_WAVE, "Output range: %.1f-%.1f%s (will be clamped to safe boundaries)", 
                       center - amplitude, center + amplitude, unitStr);
     }
 }
@@ -148,20 +165,28 @@ void startSineWave(float amplitude, float period, float center, uint8_t signal,
  * Stop sine wave generation
  */
 void stopSineWave() {
+    if (!isOutputEngineContext()) {
+        OutputCommand command = {};
+        command.type = OUT_CMD_SINE_STOP;
+        postOutputCommand(command);
+        return;
+    }
+
     if (sineWaveActive) {
         sineWaveActive = false;
-        Serial.println("Sine wave stopped.");
+        markStateChanged(CHANGE_WAVE);
+        LOG_INFO(LOG_CAT_WAVE, "Sine wave stopped.");
         
         // Reset all outputs to 0 for safety
         initializeDACs();
-        Serial.println("All outputs reset to 0.");
+        LOG_INFO(LOG_CAT_WAVE, "All outputs reset to 0.");
     } else {
-        Serial.println("No sine wave is currently active.");
+        LOG_WARN(LOG_CAT_WAVE, "No sine wave is currently active.");
     }
 }
 
 /**
- * Update sine wave output (call this in main loop)
+ * Update sine wave output (called by the output engine each tick)
  */
 void updateSineWave() {
     if (!sineWaveActive) {
@@ -197,8 +222,12 @@ void updateSineWave() {
         // Output digital signal to the active signal
         for (int sig = 1; sig <= 3; sig++) {
             if (signalModes[sig - 1] == 'v' || signalModes[sig - 1] == 'c') {
-                // Use voltage channel for digital output (easier to control)
-                digitalWrite(sig == 1 ? 15 : (sig == 2 ? 26 : 33), digitalOutput ? HIGH : LOW);
+                // Use voltage relay for digital output (easier to control), switched
+                // through setRelay() on edges so the relay state and notifications follow
+                uint8_t relay = sig * 2;
+                if (getRelayState(relay) != digitalOutput) {
+                    setRelay(relay, digitalOutput);
+                }
             }
         }
         
@@ -207,7 +236,7 @@ void updateSineWave() {
         updateCounter++;
         if (updateCounter >= 4) {
             updateCounter = 0;
-            Serial.printf("Digital sine wave: %s at %.1fs (%.1f%% complete)\n", 
+            LOG_DEBUG(LOG_CAT_WAVE, "Digital sine wave: %s at %.1fs (%.1f%% complete)", 
                           digitalOutput ? "HIGH" : "LOW",
                           timeInSeconds,
                           (timeInSeconds / sinePeriod) * 100.0);
@@ -241,7 +270,7 @@ void updateSineWave() {
     updateCounter++;
     if (updateCounter >= 4) {
         updateCounter = 0;
-            Serial.printf("Sine wave: %.2f%s at %.1fs (%.1f%% complete)\n", 
+            LOG_DEBUG(LOG_CAT_WAVE, "Sine wave: %.2f%s at %.1fs (%.1f%% complete)", 
                           outputValue,
                           (sineWaveMode == 'v') ? "V" : "mA",
                       timeInSeconds,
@@ -260,6 +289,34 @@ bool isSineWaveActive() {
     return sineWaveActive;
 }
 
+/**
+ * Get the mode of the current (or last) sine wave
+ */
+char getSineWaveMode() {
+    return sineWaveMode;
+}
+
+/**
+ * Get the period of the current (or last) sine wave
+ */
+float getSineWavePeriod() {
+    return sinePeriod;
+}
+
+/**
+ * Get the amplitude of the current (or last) sine wave
+ */
+float getSineWaveAmplitude() {
+    return sineAmplitude;
+}
+
+/**
+ * Get the center of the current (or last) sine wave
+ */
+float getSineWaveCenter() {
+    return sineOffset;
+}
+
 /**
  * Get sine wave status
  */
@@ -288,42 +345,39 @@ void getSineWaveStatus() {
  * Parse sine wave commands
  * Format: SINE START/STOP/STATUS [amplitude] [period] [signal] [mode]
  */
-void parseSineWaveCommand(String input) {
-    input.trim();
-    input.toUpperCase();
+void parseSineWaveCommand(char* input) {
+    TextCursor cursor = {input};
+    char* keyword = nextToken(&cursor);
+    char* action = nextToken(&cursor);
+    if (!tokenEquals(keyword, "SINE")) {
+        action = nullptr; // Falls through to the usage text
+    }
     
-    if (input.startsWith("SINE START")) {
+    if (tokenEquals(action, "START")) {
         // Parse: SINE START amplitude period center signal mode
         // Example: SINE START 5.0 2.0 5.0 1 V
         // Example: SINE START 3.0 1.5 2.5 2 C
-        String params = input.substring(11); // Remove "SINE START "
-        params.trim();
-        
-        // Parse parameters
-        int space1 = params.indexOf(' ');
-        int space2 = params.indexOf(' ', space1 + 1);
-        int space3 = params.indexOf(' ', space2 + 1);
-        int space4 = params.indexOf(' ', space3 + 1);
+        float amplitude, period, center;
+        int32_t signal;
+        bool valid = parseTextFloat(nextToken(&cursor), &amplitude);
+        valid = valid && parseTextFloat(nextToken(&cursor), &period);
+        valid = valid && parseTextFloat(nextToken(&cursor), &center);
+        valid = valid && parseTextInt(nextToken(&cursor), &signal);
+        char* modeText = nextToken(&cursor);
         
-        if (space1 == -1 || space2 == -1 || space3 == -1 || space4 == -1) {
+        if (!valid || !modeText || signal < 0 || signal > 255) {
             Serial.println("Invalid SINE START format. Use: SINE START amplitude period center signal mode");
             Serial.println("Example: SINE START 5.0 2.0 5.0 1 V");
             Serial.println("Example: SINE START 3.0 1.5 2.5 2 C");
             return;
         }
         
-        float amplitude = params.substring(0, space1).toFloat();
-        float period = params.substring(space1 + 1, space2).toFloat();
-        float center = params.substring(space2 + 1, space3).toFloat();
-        uint8_t signal = params.substring(space3 + 1, space4).toInt();
-        char mode = toLowerCase(params.substring(space4 + 1).charAt(0));
-        
-        startSineWave(amplitude, period, center, signal, mode, false);
+        startSineWave(amplitude, period, center, (uint8_t)signal, toLowerCase(modeText[0]), false);
         
-    } else if (input.startsWith("SINE STOP")) {
+    } else if (tokenEquals(action, "STOP")) {
         stopSineWave();
         
-    } else if (input.startsWith("SINE STATUS")) {
+    } else if (tokenEquals(action, "STATUS")) {
         getSineWaveStatus();
         
     } else {
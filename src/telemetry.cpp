@@ -0,0 +1,153 @@
+#include "telemetry.h"
+#include "command_handler.h"
+#include "relay_controller.h"
+#include "sine_wave_generator.h"
+#include "rs485_command_handler.h"
+#include "rs485_serial.h"
+#include "modbus_diagnostics.h"
+#include "output_engine.h"
+#include "setpoint_stream.h"
+#include "debug_log.h"
+#include "scheduler.h"
+#include "profiler.h"
+
+extern char signalModes[3];
+
+static_assert(RS485_PACKED_SIZE(TELEMETRY_FRAME_SIZE) <= RS485_MAX_REPLY_DATA, "Packed telemetry frame exceeds a reply");
+
+static int8_t telemetryJob = -1;
+static uint32_t telemetryIntervalMs = 0;
+
+/**
+ * Write a uint16 big endian
+ */
+static void putUint16BE(uint8_t* out, uint16_t value) {
+    out[0] = (value >> 8) & 0xFF;
+    out[1] = value & 0xFF;
+}
+
+/**
+ * Write a counter sum as a saturating uint16 big endian
+ */
+static void putCounter(uint8_t* out, uint32_t value) {
+    putUint16BE(out, value > 0xFFFF ? 0xFFFF : (uint16_t)value);
+}
+
+/**
+ * Build a telemetry frame
+ */
+uint8_t buildTelemetryFrame(uint8_t* frame) {
+    uint8_t length = 0;
+    frame[length++] = TELEMETRY_VERSION;
+    frame[length++] = getCurrentDeviceID();
+
+    uint32_t uptime = millis() / 1000;
+    frame[length++] = (uptime >> 24) & 0xFF;
+    frame[length++] = (uptime >> 16) & 0xFF;
+    frame[length++] = (uptime >> 8) & 0xFF;
+    frame[length++] = uptime & 0xFF;
+
+    for (uint8_t sig = 1; sig <= 3; sig++) {
+        frame[length++] = signalModes[sig - 1];
+        putUint16BE(&frame[length], (uint16_t)(getSignalValue(sig) * 100 + 0.5f));
+        length += 2;
+    }
+
+    frame[length++] = isSineWaveActive() ? TELEMETRY_WAVE_ACTIVE : 0;
+    frame[length++] = getSineWaveMode();
+    putUint16BE(&frame[length], (uint16_t)(getSineWavePeriod() * 10 + 0.5f));
+    length += 2;
+
+    uint8_t relays = 0;
+    for (uint8_t relay = 1; relay <= 6; relay++) {
+        if (getRelayState(relay)) {
+            relays |= 1 << (relay - 1);
+        }
+    }
+    frame[length++] = relays;
+
+    const RS485LinkStats* link = getRS485LinkStats();
+    const ModbusDiagnostics* modbus = getModbusDiagnostics();
+    const OutputEngineStats* engine = getOutputEngineStats();
+    const StreamStats* stream = getStreamStats();
+    putCounter(&frame[length], link->rejected + link->overflow + link->dropped);
+    length += 2;
+    putCounter(&frame[length], modbus->crcErrors + modbus->exceptions);
+    length += 2;
+    putCounter(&frame[length], engine->missedTicks + engine->commandOverflow);
+    length += 2;
+    putCounter(&frame[length], stream->lost + stream->underrun);
+    length += 2;
+    putCounter(&frame[length], getLogDroppedCount());
+    length += 2;
+
+    return length;
+}
+
+/**
+ * Send one frame to the USB subscriber
+ */
+static void sendTelemetryJob() {
+    PROFILE_ZONE(PROFILE_TELEMETRY);
+    // Framed in one buffer so the USB driver gets a single write per frame
+    uint8_t frame[TELEMETRY_FRAME_SIZE];
+    uint8_t packet[RS485_PACKED_SIZE(TELEMETRY_FRAME_SIZE) + 4];
+    uint8_t length = packRS485Payload(frame, buildTelemetryFrame(frame), &packet[3]);
+    packet[0] = 0xAA;
+    packet[1] = getCurrentDeviceID();
+    packet[2] = CMD_GET_TELEMETRY;
+    packet[3 + length] = 0x55;
+    length += 4;
+    if (Serial.availableForWrite() < length) {
+        return; // Skip a frame rather than block on a slow host
+    }
+    Serial.write(packet, length);
+}
+
+/**
+ * Set up the telemetry job
+ */
+void initTelemetry() {
+    telemetryJob = addSchedulerJob("telemetry", sendTelemetryJob, SCHEDULER_EVENT_ONLY, 20000, 0);
+}
+
+/**
+ * Set the USB subscription rate
+ */
+bool setTelemetryInterval(uint32_t intervalMs) {
+    if (intervalMs != 0 && intervalMs < TELEMETRY_MIN_INTERVAL_MS) {
+        return false;
+    }
+    telemetryIntervalMs = intervalMs;
+    setSchedulerJobPeriod(telemetryJob, intervalMs ? intervalMs * 1000 : SCHEDULER_EVENT_ONLY);
+    return true;
+}
+
+/**
+ * Get the USB subscription rate
+ */
+uint32_t getTelemetryInterval() {
+    return telemetryIntervalMs;
+}
+
+/**
+ * Print the current frame decoded as text
+ */
+void printTelemetry() {
+    uint8_t frame[TELEMETRY_FRAME_SIZE];
+    buildTelemetryFrame(frame);
+
+    Serial.printf("Device %u, up %lus, telemetry %s\n", frame[1],
+                  (unsigned long)(((uint32_t)frame[2] << 24) | ((uint32_t)frame[3] << 16) | (frame[4] << 8) | frame[5]),
+                  telemetryIntervalMs ? "subscribed" : "on request");
+    for (uint8_t i = 0; i < 3; i++) {
+        const uint8_t* ch = &frame[6 + i * 3];
+        Serial.printf("SIG%u: %c %.2f%s\n", i + 1, ch[0], ((ch[1] << 8) | ch[2]) / 100.0f, ch[0] == 'c' ? "mA" : "V");
+    }
+    Serial.printf("Wave: %s, mode %c, period %.1fs\n", (frame[15] & TELEMETRY_WAVE_ACTIVE) ? "ACTIVE" : "off",
+                  frame[16], ((frame[17] << 8) | frame[18]) / 10.0f);
+    Serial.printf("Relays: 0x%02X\n", frame[19]);
+    Serial.printf("Errors: rs485 %u, modbus %u, engine %u, stream %u, log %u\n",
+                  (frame[20] << 8) | frame[21], (frame[22] << 8) | frame[23], (frame[24] << 8) | frame[25],
+                  (frame[26] << 8) | frame[27], (frame[28] << 8) | frame[29]);
+}
@@ -0,0 +1,216 @@
+#include "text_command.h"
+
+/**
+ * Whitespace test for trimming
+ */
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * Collect bytes already received on a stream
+ */
+LineStatus assembleLine(LineAssembler* assembler, Stream& stream) {
+    while (stream.available() > 0) {
+        char c = (char)stream.read();
+        if (c != '\n') {
+            if (assembler->length < TEXT_LINE_MAX - 1) {
+                assembler->line[assembler->length++] = c;
+            } else {
+                assembler->overflow = true;
+            }
+            continue;
+        }
+
+        // End of line: trim and hand it out
+        bool overflow = assembler->overflow;
+        uint16_t end = assembler->length;
+        assembler->length = 0;
+        assembler->overflow = false;
+        if (overflow) {
+            assembler->line[0] = '\0';
+            return LINE_TOO_LONG;
+        }
+        while (end > 0 && isBlank(assembler->line[end - 1])) {
+            end--;
+        }
+        uint16_t start = 0;
+        while (start < end && isBlank(assembler->line[start])) {
+            start++;
+        }
+        memmove(assembler->line, assembler->line + start, end - start);
+        assembler->line[end - start] = '\0';
+        return LINE_READY;
+    }
+    return LINE_PENDING;
+}
+
+/**
+ * Get the next token, terminating it in place
+ */
+char* nextToken(TextCursor* cursor, const char* separators) {
+    char* p = cursor->pos;
+    while (*p && strchr(separators, *p)) {
+        p++;
+    }
+    if (*p == '\0') {
+        cursor->pos = p;
+        return nullptr;
+    }
+    char* token = p;
+    while (*p && !strchr(separators, *p)) {
+        p++;
+    }
+    if (*p) {
+        *p++ = '\0';
+    }
+    cursor->pos = p;
+    return token;
+}
+
+/**
+ * Get the rest of the line with surrounding whitespace removed
+ */
+char* remainingText(TextCursor* cursor) {
+    char* start = cursor->pos;
+    while (isBlank(*start)) {
+        start++;
+    }
+    char* end = start + strlen(start);
+    while (end > start && isBlank(end[-1])) {
+        end--;
+    }
+    *end = '\0';
+    cursor->pos = end;
+    return start;
+}
+
+/**
+ * Compare a token with a keyword, ignoring case
+ */
+bool tokenEquals(const char* token, const char* word) {
+    return token && strcasecmp(token, word) == 0;
+}
+
+/**
+ * Parse an unsigned integer
+ */
+bool parseTextUint(const char* text, uint32_t* value, uint8_t base) {
+    if (!text) {
+        return false;
+    }
+    if ((base == 0 || base == 16) && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        text += 2;
+        base = 16;
+    } else if (base == 0) {
+        base = 10;
+    }
+    if (*text == '\0') {
+        return false;
+    }
+
+    uint32_t result = 0;
+    for (; *text; text++) {
+        char c = *text;
+        uint8_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        if (digit >= base || result > (UINT32_MAX - digit) / base) {
+            return false;
+        }
+        result = result * base + digit;
+    }
+    *value = result;
+    return true;
+}
+
+/**
+ * Parse a signed integer
+ */
+bool parseTextInt(const char* text, int32_t* value) {
+    if (!text) {
+        return false;
+    }
+    bool negative = *text == '-';
+    if (*text == '-' || *text == '+') {
+        text++;
+    }
+    uint32_t magnitude;
+    if (!parseTextUint(text, &magnitude) || magnitude > (negative ? 0x80000000u : 0x7FFFFFFFu)) {
+        return false;
+    }
+    *value = negative ? (int32_t)(0u - magnitude) : (int32_t)magnitude;
+    return true;
+}
+
+/**
+ * Parse a decimal floating point number
+ * Up to 19 significant digits are kept; the scaling is done in double.
+ */
+bool parseTextFloat(const char* text, float* value) {
+    if (!text) {
+        return false;
+    }
+    bool negative = *text == '-';
+    if (*text == '-' || *text == '+') {
+        text++;
+    }
+
+    uint64_t mantissa = 0;
+    int16_t exponent = 0;
+    uint8_t significant = 0;
+    bool anyDigit = false;
+    bool fraction = false;
+    for (; *text; text++) {
+        char c = *text;
+        if (c == '.' && !fraction) {
+            fraction = true;
+        } else if (c >= '0' && c <= '9') {
+            anyDigit = true;
+            if (significant < 19) {
+                mantissa = mantissa * 10 + (c - '0');
+                if (mantissa) {
+                    significant++;
+                }
+                if (fraction) {
+                    exponent--;
+                }
+            } else if (!fraction) {
+                exponent++;
+            }
+        } else {
+            break;
+        }
+    }
+    if (!anyDigit) {
+        return false;
+    }
+
+    if (*text == 'e' || *text == 'E') {
+        int32_t power;
+        if (!parseTextInt(text + 1, &power) || power < -100 || power > 100) {
+            return false;
+        }
+        exponent += power;
+    } else if (*text) {
+        return false;
+    }
+
+    double result = (double)mantissa;
+    double scale = 10.0;
+    for (uint16_t e = exponent < 0 ? -exponent : exponent; e; e >>= 1) {
+        if (e & 1) {
+            result = exponent < 0 ? result / scale : result * scale;
+        }
+        scale *= scale;
+    }
+    *value = (float)(negative ? -result : result);
+    return true;
+}
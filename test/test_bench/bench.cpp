@@ -0,0 +1,159 @@
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+
+// Recorded result
+struct BenchResult {
+    char group[24];
+    char name[40];
+    char unit[16];
+    double value;
+    BenchStats stats;
+};
+
+static BenchResult results[BENCH_MAX_RESULTS];
+static uint16_t resultCount = 0;
+static double samplesNs[BENCH_MAX_SAMPLES];
+static double clockOverheadNs = 0;
+
+/**
+ * Current monotonic time in ns
+ */
+static inline int64_t benchNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Value at a fraction of a sorted sample set
+ */
+static double percentile(const double* sorted, uint32_t count, double fraction) {
+    uint32_t index = (uint32_t)(fraction * (count - 1) + 0.5);
+    return sorted[index < count ? index : count - 1];
+}
+
+/**
+ * Measure the clock read overhead
+ */
+double benchCalibrate() {
+    const uint32_t count = 10000;
+    for (uint32_t i = 0; i < count; i++) {
+        int64_t start = benchNowNs();
+        samplesNs[i] = (double)(benchNowNs() - start);
+    }
+    std::sort(samplesNs, samplesNs + count);
+    clockOverheadNs = percentile(samplesNs, count, 0.5);
+    return clockOverheadNs;
+}
+
+/**
+ * Time a body once per sample
+ */
+BenchStats benchRun(const BenchBody& body, uint32_t samples, uint32_t warmup, const BenchBody& between) {
+    if (samples > BENCH_MAX_SAMPLES) {
+        samples = BENCH_MAX_SAMPLES;
+    }
+    for (uint32_t i = 0; i < warmup; i++) {
+        body(i);
+        if (between) {
+            between(i);
+        }
+    }
+
+    BenchStats stats = {};
+    for (uint32_t i = 0; i < samples; i++) {
+        int64_t start = benchNowNs();
+        body(i);
+        double elapsed = (double)(benchNowNs() - start) - clockOverheadNs;
+        samplesNs[i] = elapsed > 0 ? elapsed : 0;
+        stats.totalNs += samplesNs[i];
+        if (between) {
+            between(i);
+        }
+    }
+    if (samples == 0) {
+        return stats;
+    }
+
+    std::sort(samplesNs, samplesNs + samples);
+    stats.samples = samples;
+    stats.minNs = samplesNs[0];
+    stats.medianNs = percentile(samplesNs, samples, 0.5);
+    stats.p99Ns = percentile(samplesNs, samples, 0.99);
+    stats.meanNs = stats.totalNs / samples;
+    return stats;
+}
+
+/**
+ * Record a result
+ */
+void benchRecord(const char* group, const char* name, const char* unit, double value, const BenchStats& stats) {
+    if (resultCount >= BENCH_MAX_RESULTS) {
+        fprintf(stderr, "bench: result table full, %s/%s not recorded\n", group, name);
+        return;
+    }
+    BenchResult& result = results[resultCount++];
+    snprintf(result.group, sizeof(result.group), "%s", group);
+    snprintf(result.name, sizeof(result.name), "%s", name);
+    snprintf(result.unit, sizeof(result.unit), "%s", unit);
+    result.value = value;
+    result.stats = stats;
+}
+
+/**
+ * Print all recorded results
+ */
+void benchPrintSummary() {
+    printf("\n%-14s %-28s %16s %-10s %10s %10s %10s\n", "group", "name", "value", "unit", "min ns", "median ns", "p99 ns");
+    for (uint16_t i = 0; i < resultCount; i++) {
+        const BenchResult& result = results[i];
+        printf("%-14s %-28s %16.1f %-10s %10.0f %10.0f %10.0f\n", result.group, result.name, result.value,
+               result.unit, result.stats.minNs, result.stats.medianNs, result.stats.p99Ns);
+    }
+    printf("(clock overhead %.0f ns subtracted)\n\n", clockOverheadNs);
+}
+
+/**
+ * Write all recorded results as JSON
+ */
+bool benchWriteJson(const char* path) {
+    if (!path) {
+        path = getenv("BENCH_OUTPUT");
+    }
+    if (!path || !*path) {
+        path = BENCH_DEFAULT_OUTPUT;
+    }
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "bench: cannot write %s\n", path);
+        return false;
+    }
+
+#ifdef __OPTIMIZE__
+    const bool optimized = true;
+#else
+    const bool optimized = false;
+#endif
+    fprintf(file, "{\n  \"schema\": 1,\n  \"suite\": \"inputmodule-host-bench\",\n");
+    fprintf(file, "  \"timestamp\": %lld,\n", (long long)time(nullptr));
+    fprintf(file, "  \"compiler\": \"%s\",\n  \"optimized\": %s,\n", __VERSION__, optimized ? "true" : "false");
+    fprintf(file, "  \"clock_overhead_ns\": %.1f,\n  \"results\": [\n", clockOverheadNs);
+    for (uint16_t i = 0; i < resultCount; i++) {
+        const BenchResult& result = results[i];
+        fprintf(file, "    {\"group\": \"%s\", \"name\": \"%s\", \"unit\": \"%s\", \"value\": %.3f, "
+                      "\"samples\": %lu, \"min_ns\": %.1f, \"median_ns\": %.1f, \"p99_ns\": %.1f, \"mean_ns\": %.1f}%s\n",
+                result.group, result.name, result.unit, result.value, (unsigned long)result.stats.samples,
+                result.stats.minNs, result.stats.medianNs, result.stats.p99Ns, result.stats.meanNs,
+                i + 1 < resultCount ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    bool ok = fclose(file) == 0;
+    if (ok) {
+        printf("Benchmark results written to %s\n", path);
+    }
+    return ok;
+}
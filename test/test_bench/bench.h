@@ -0,0 +1,81 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <functional>
+
+// Host Benchmark Harness
+// Times firmware code paths in the native build on the host monotonic
+// clock. Every sample times one call; the clock read overhead is measured
+// once and subtracted. Results are collected in memory, printed as a table
+// and written as JSON (see benchWriteJson) so runs can be compared by
+// scripts across commits.
+//
+// Host numbers are relative: they track regressions in the firmware's own
+// code, not ESP32 timings. I2C/UART costs are those of the simulated devices.
+
+#define BENCH_MAX_RESULTS 96
+#define BENCH_MAX_SAMPLES 20000
+#define BENCH_DEFAULT_OUTPUT "bench_results.json"
+
+// Per-call timing of one benchmark
+struct BenchStats {
+    uint32_t samples;
+    double minNs;
+    double medianNs;
+    double p99Ns;
+    double meanNs;
+    double totalNs;           // Sum of all samples
+};
+
+// Timed body; iteration counts from 0
+typedef std::function<void(uint32_t iteration)> BenchBody;
+
+/**
+ * Measure the clock read overhead (call once before timing anything)
+ * @return Median overhead of one timestamp pair in ns
+ */
+double benchCalibrate();
+
+/**
+ * Time a body once per sample
+ * @param body Code under test
+ * @param samples Number of timed calls (at most BENCH_MAX_SAMPLES)
+ * @param warmup Untimed calls before the first sample
+ * @param between Untimed code run after every call (reset/drain), may be empty
+ * @return Per-call statistics
+ */
+BenchStats benchRun(const BenchBody& body, uint32_t samples, uint32_t warmup, const BenchBody& between = BenchBody());
+
+/**
+ * Keep a result the compiler could otherwise discard
+ * Also a memory barrier, so stores made by the timed body are not sunk out of it.
+ */
+template <typename T>
+inline void benchKeep(const T& value) {
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+/**
+ * Record a result
+ * @param group Benchmark group (e.g. "rs485_parse")
+ * @param name Case within the group
+ * @param unit Unit of value (e.g. "bytes/s", "ns/sample")
+ * @param value Headline value in that unit
+ * @param stats Per-call timing the value was derived from
+ */
+void benchRecord(const char* group, const char* name, const char* unit, double value, const BenchStats& stats);
+
+/**
+ * Print all recorded results as a table on stdout
+ */
+void benchPrintSummary();
+
+/**
+ * Write all recorded results as JSON
+ * @param path Output file, or nullptr for $BENCH_OUTPUT / BENCH_DEFAULT_OUTPUT
+ * @return true if the file was written
+ */
+bool benchWriteJson(const char* path = nullptr);
+
+#endif // BENCH_H
@@ -0,0 +1,473 @@
+// Host Benchmark Suite
+// Measures the firmware's hot paths in the native build:
+// - RS-485 frame parsing throughput (bytes/s) through processRS485Commands()
+// - command dispatch latency per registered RS-485 opcode
+// - waveform sample generation per channel mode
+// - text command parsing (line assembly, tokenizer, numbers, register definitions)
+// - packing of binary reply payloads (telemetry frames, change notifications)
+// - output journal restore (after journaling a running waveform)
+//
+// Run with: pio test -e native_bench
+// Results go to stdout and to $BENCH_OUTPUT (default bench_results.json).
+// Each benchmark also checks that the code under test did its job, so a
+// broken path fails the run instead of producing a fast number.
+//
+// The output engine task is not started: output calls run inline, as they
+// do inside the engine, so dispatch timings exclude the queue hand-off.
+
+#include <Arduino.h>
+#include <HardwareSerial.h>
+#include <hal_sim.h>
+#include <unity.h>
+#include "bench.h"
+#include "rs485_serial.h"
+#include "rs485_command_handler.h"
+#include "device_id.h"
+#include "relay_controller.h"
+#include "dac_controller.h"
+#include "command_handler.h"
+#include "sine_wave_generator.h"
+#include "setpoint_stream.h"
+#include "modbus_handler.h"
+#include "modbus_register_bank.h"
+#include "text_command.h"
+#include "telemetry.h"
+#include "change_notify.h"
+#include "output_journal.h"
+#include "scheduler.h"
+
+extern HardwareSerial RS485Serial;
+extern unsigned long lastUpdateTime;      // sine_wave_generator.cpp
+
+#define PARSE_SAMPLES 5000
+#define DISPATCH_SAMPLES 2000
+#define WAVE_SAMPLES 5000
+#define TEXT_SAMPLES 20000
+#define PACK_SAMPLES 20000
+#define RESTORE_SAMPLES 200
+#define WARMUP 100
+#define WAVE_DUE_MS 1000           // Past the generator's update interval
+
+static uint8_t deviceID = 0;
+static uint32_t rs485TxBytes = 0;
+static uint8_t rs485TxLog[RS485_MAX_REPLY_BYTES];  // Start of the bytes sent since the last clear
+static uint8_t rs485TxLogLength = 0;
+
+// Payloads for opcodes that need more than zero-filled bytes
+struct DispatchPayload {
+    const char* name;
+    uint8_t length;
+    uint8_t data[9];
+};
+
+static const DispatchPayload dispatchPayloads[] = {
+    {"groups",    2, {0x00, 0x00}},
+    {"voltage",   2, {0x01, 0xF4}},                 // 5.00 V
+    {"current",   2, {0x03, 0xE8}},                 // 10.00 mA
+    {"relay",     2, {1, 1}},
+    {"stats",     2, {STATS_SELECT_LINK, 0}},
+    {"trace",     3, {0x00, 0x00, 0}},
+    {"profile",   2, {0, 0}},
+    {"sine",      6, {0, 5, 2, 0x00, 0x0A, 0}},     // Voltage, 5 +/- 2, 10 s
+    {"stream",    9, {0xC0, 0xC1, 0xC7, 0xC7, 0xF4, 0xC7, 0xF4, 0xC7, 0xF4}},   // seq 1, 5.00 on all channels
+    {"streamcfg", 3, {0x03, 0xE8, 4}},              // 1000 us, prefill 4
+    {"subscribe", 2, {0x1F, 5}},
+};
+
+// Waveform cases: wave mode and the signal mode of each channel
+struct WaveCase {
+    const char* name;
+    char waveMode;
+    char channelModes[3];
+};
+
+static const WaveCase waveCases[] = {
+    {"voltage", 'v', {'v', 'v', 'v'}},
+    {"current", 'c', {'c', 'c', 'c'}},
+    {"mixed_vcv", 'v', {'v', 'c', 'v'}},
+    {"digital", 'd', {'v', 'v', 'v'}},
+};
+
+// Stream over a fixed string, rewound for every sample
+class TextSource : public Stream {
+public:
+    explicit TextSource(const char* text) : text(text), length(strlen(text)) {}
+    void rewind() { pos = 0; }
+    size_t size() const { return length; }
+    int available() override { return (int)(length - pos); }
+    int read() override { return pos < length ? (uint8_t)text[pos++] : -1; }
+    int peek() override { return pos < length ? (uint8_t)text[pos] : -1; }
+    size_t write(uint8_t c) override { return 0; }
+
+private:
+    const char* text;
+    size_t length;
+    size_t pos = 0;
+};
+
+/**
+ * Build an RS-485 frame
+ * @return Frame length
+ */
+static uint8_t buildFrame(uint8_t* out, uint8_t id, uint8_t opcode, const uint8_t* data, uint8_t length) {
+    uint8_t n = 0;
+    out[n++] = 0xAA;
+    out[n++] = id;
+    out[n++] = opcode;
+    if (length) {
+        memcpy(&out[n], data, length);
+        n += length;
+    }
+    out[n++] = 0x55;
+    return n;
+}
+
+/**
+ * Throughput in units per second
+ */
+static double perSecond(double units, const BenchStats& stats) {
+    return stats.totalNs > 0 ? units * 1e9 / stats.totalNs : 0;
+}
+
+/**
+ * Bring up the modules under test without the output engine or comms task
+ */
+static void initBench() {
+    Serial.begin(115200);
+    Serial.simSetTxHandler([](const uint8_t*, size_t) {});
+    halResetStorage();
+
+    initDeviceIDPins();
+    initRelayController();
+    initDACControllers();
+    initSineWaveGenerator();
+    initSetpointStream();
+    initRS485Serial();
+    initRS485CommandHandler();
+    initModbus();
+
+    RS485Serial.simSetTxHandler([](const uint8_t* data, size_t length) {
+        rs485TxBytes += length;
+        for (size_t i = 0; i < length && rs485TxLogLength < sizeof(rs485TxLog); i++) {
+            rs485TxLog[rs485TxLogLength++] = data[i];
+        }
+    });
+    deviceID = calculateDeviceID();
+    printf("Clock overhead: %.0f ns\n", benchCalibrate());
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+/**
+ * RS-485 frame parsing: bursts of one queue's worth of mixed frames
+ */
+void test_rs485_parse_throughput() {
+    static const uint8_t voltage[] = {0x01, 0xF4};
+    static const uint8_t stream[] = {0xC0, 0xC1, 0xC7, 0xC7, 0xF4, 0xC7, 0xF4, 0xC7, 0xF4};
+
+    // Six frames for us and two for another node fill the queue exactly
+    uint8_t burst[RS485_COMMAND_QUEUE_SIZE * RS485_MAX_COMMAND_LENGTH];
+    uint16_t burstLength = 0;
+    uint8_t otherID = deviceID ^ 0x01;
+    burstLength += buildFrame(&burst[burstLength], deviceID, CMD_PING, nullptr, 0);
+    burstLength += buildFrame(&burst[burstLength], deviceID, CMD_SET_VOLTAGE, voltage, sizeof(voltage));
+    burstLength += buildFrame(&burst[burstLength], otherID, CMD_SET_VOLTAGE, voltage, sizeof(voltage));
+    burstLength += buildFrame(&burst[burstLength], deviceID, CMD_STREAM_SETPOINTS, stream, sizeof(stream));
+    burstLength += buildFrame(&burst[burstLength], deviceID, CMD_GET_STATUS, nullptr, 0);
+    burstLength += buildFrame(&burst[burstLength], otherID, CMD_PING, nullptr, 0);
+    burstLength += buildFrame(&burst[burstLength], deviceID, CMD_STREAM_SETPOINTS, stream, sizeof(stream));
+    burstLength += buildFrame(&burst[burstLength], deviceID, CMD_GET_TELEMETRY, nullptr, 0);
+    const uint32_t framesPerBurst = 8;
+    const uint32_t queuedPerBurst = 6;
+
+    resetRS485LinkStats();
+    uint32_t queued = 0;
+    RS485Serial.simReceive(burst, burstLength);
+    BenchStats stats = benchRun(
+        [](uint32_t) { processRS485Commands(); },
+        PARSE_SAMPLES, WARMUP,
+        [&](uint32_t) {
+            while (dequeueRS485Command()) {
+                queued++;
+            }
+            RS485Serial.simReceive(burst, burstLength);
+        });
+    processRS485Commands();
+    while (dequeueRS485Command()) {
+        queued++;
+    }
+
+    const RS485LinkStats* link = getRS485LinkStats();
+    uint32_t bursts = PARSE_SAMPLES + WARMUP + 1;
+    TEST_ASSERT_EQUAL_UINT32(bursts * burstLength, link->bytesReceived);
+    TEST_ASSERT_EQUAL_UINT32(bursts * framesPerBurst, link->framesReceived);
+    TEST_ASSERT_EQUAL_UINT32(bursts * (framesPerBurst - queuedPerBurst), link->notForMe);
+    TEST_ASSERT_EQUAL_UINT32(0, link->dropped + link->rejected + link->overflow);
+    TEST_ASSERT_EQUAL_UINT32(bursts * queuedPerBurst, queued);
+
+    benchRecord("rs485_parse", "mixed_frames", "bytes/s", perSecond((double)burstLength * stats.samples, stats), stats);
+    benchRecord("rs485_parse", "mixed_frames_per_frame", "ns/frame", stats.medianNs / framesPerBurst, stats);
+}
+
+/**
+ * Dispatch latency of every registered opcode, from a dequeued frame to its reply
+ */
+void test_dispatch_latency() {
+    uint8_t measured = 0;
+    for (uint16_t opcode = 0; opcode < 0x80; opcode++) {
+        const CommandSpec* spec = findRS485Command(opcode);
+        if (!spec) {
+            continue;
+        }
+
+        uint8_t payload[RS485_MAX_COMMAND_LENGTH - 2] = {};
+        uint8_t length = spec->minLength;
+        for (const DispatchPayload& entry : dispatchPayloads) {
+            if (strcmp(entry.name, spec->name) == 0) {
+                memcpy(payload, entry.data, entry.length);
+                length = entry.length;
+            }
+        }
+
+        // Make the frame the current command, as handleRS485Commands() does
+        uint8_t frame[RS485_MAX_COMMAND_LENGTH + 4];
+        RS485Serial.simReceive(frame, buildFrame(frame, deviceID, opcode, payload, length));
+        processRS485Commands();
+        TEST_ASSERT_TRUE_MESSAGE(dequeueRS485Command(), spec->name);
+        RS485Command* command = getLastCommand();
+
+        bool success = true;
+        uint32_t txBefore = rs485TxBytes;
+        BenchStats stats = benchRun(
+            [&](uint32_t) { success &= executeRS485Command(command); },
+            DISPATCH_SAMPLES, WARMUP,
+            [&](uint32_t) {
+                // Undo state the command leaves behind so every call takes the same path
+                if (opcode == CMD_SINE_WAVE) {
+                    stopSineWave();
+                } else if (opcode == CMD_STREAM_SETPOINTS) {
+                    initSetpointStream();
+                }
+                command->timestamp = micros();
+                command->replyTimestamp = 0;
+            });
+        TEST_ASSERT_TRUE_MESSAGE(success, spec->name);
+        if (!(spec->flags & CMD_FLAG_NO_ACK)) {
+            TEST_ASSERT_TRUE_MESSAGE(rs485TxBytes > txBefore, spec->name);
+        }
+
+        benchRecord("dispatch", spec->name, "ns", stats.medianNs, stats);
+        measured++;
+    }
+    TEST_ASSERT_TRUE(measured > 0);
+}
+
+/**
+ * Waveform generation: one sample of the running wave on all three channels
+ */
+void test_waveform_generation() {
+    for (const WaveCase& waveCase : waveCases) {
+        for (uint8_t sig = 1; sig <= 3; sig++) {
+            TEST_ASSERT_TRUE(setSignalMode(sig, waveCase.channelModes[sig - 1]));
+        }
+        startSineWave(2.0f, 10.0f, waveCase.waveMode == 'd' ? 0.5f : 5.0f, 1, waveCase.waveMode);
+        TEST_ASSERT_TRUE_MESSAGE(isSineWaveActive(), waveCase.name);
+
+        uint32_t dacWritesBefore = halGetDacWriteCount();
+        lastUpdateTime = millis() - WAVE_DUE_MS;
+        BenchStats stats = benchRun(
+            [](uint32_t) { updateSineWave(); },
+            WAVE_SAMPLES, WARMUP,
+            [](uint32_t) { lastUpdateTime = millis() - WAVE_DUE_MS; });
+        uint32_t dacWrites = halGetDacWriteCount() - dacWritesBefore;
+        stopSineWave();
+
+        if (waveCase.waveMode == 'd') {
+            TEST_ASSERT_EQUAL_UINT32(0, dacWrites);
+        } else {
+            TEST_ASSERT_EQUAL_UINT32((WAVE_SAMPLES + WARMUP) * 3, dacWrites);
+        }
+
+        char name[40];
+        benchRecord("waveform", waveCase.name, "ns/sample", stats.medianNs, stats);
+        snprintf(name, sizeof(name), "%s_per_channel", waveCase.name);
+        benchRecord("waveform", name, "ns/sample", stats.medianNs / 3, stats);
+    }
+
+    // The simulated DAC write alone, to separate it from sample synthesis
+    BenchStats stats = benchRun([](uint32_t i) { gp8413_1.setVoltage((i & 1) ? 2.5f : 7.5f, 0); }, WAVE_SAMPLES, WARMUP);
+    benchRecord("waveform", "dac_write", "ns", stats.medianNs, stats);
+}
+
+/**
+ * Text command parsing
+ */
+void test_text_parsing() {
+    static const char* line = "modbus 1000,F/CDAB,3.14159";
+    char buffer[TEXT_LINE_MAX];
+
+    // Line assembly from a stream
+    TextSource source("  modbus 1000,F/CDAB,3.14159  \r\n");
+    LineAssembler assembler = {};
+    bool ready = true;
+    BenchStats stats = benchRun(
+        [&](uint32_t) { ready &= assembleLine(&assembler, source) == LINE_READY; },
+        TEXT_SAMPLES, WARMUP,
+        [&](uint32_t) { source.rewind(); });
+    TEST_ASSERT_TRUE(ready);
+    TEST_ASSERT_EQUAL_STRING(line, assembler.line);
+    benchRecord("text", "assemble_line", "bytes/s", perSecond((double)source.size() * stats.samples, stats), stats);
+
+    // Tokenizer (the copy restores the line it terminates in place)
+    uint32_t tokens = 0;
+    stats = benchRun(
+        [&](uint32_t) {
+            strcpy(buffer, line);
+            TextCursor cursor = {buffer};
+            while (nextToken(&cursor, ", \t")) {
+                tokens++;
+            }
+        },
+        TEXT_SAMPLES, WARMUP);
+    TEST_ASSERT_EQUAL_UINT32((TEXT_SAMPLES + WARMUP) * 4, tokens);
+    benchRecord("text", "tokenize", "ns/line", stats.medianNs, stats);
+
+    // Number parsers (inputs read through volatile pointers so the calls are not folded)
+    static const char* volatile uintText = "0x1F40";
+    static const char* volatile intText = "-32768";
+    static const char* volatile floatText = "-12.345e-2";
+    uint32_t uintValue = 0;
+    stats = benchRun([&](uint32_t) { benchKeep(parseTextUint(uintText, &uintValue)); }, TEXT_SAMPLES, WARMUP);
+    TEST_ASSERT_EQUAL_UINT32(0x1F40, uintValue);
+    benchRecord("text", "parse_uint", "ns", stats.medianNs, stats);
+
+    int32_t intValue = 0;
+    stats = benchRun([&](uint32_t) { benchKeep(parseTextInt(intText, &intValue)); }, TEXT_SAMPLES, WARMUP);
+    TEST_ASSERT_EQUAL_INT32(-32768, intValue);
+    benchRecord("text", "parse_int", "ns", stats.medianNs, stats);
+
+    float floatValue = 0;
+    stats = benchRun([&](uint32_t) { benchKeep(parseTextFloat(floatText, &floatValue)); }, TEXT_SAMPLES, WARMUP);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, -0.12345f, floatValue);
+    benchRecord("text", "parse_float", "ns", stats.medianNs, stats);
+
+    // Register definition through the Modbus text front end
+    stats = benchRun(
+        [&](uint32_t) {
+            strcpy(buffer, "1000,F/CDAB,3.14159");
+            processInput(buffer);
+        },
+        TEXT_SAMPLES / 4, WARMUP);
+    ModbusRegisterEntry* entry = findRegister(1000);
+    TEST_ASSERT_TRUE(entry != nullptr);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5, 3.14159, getRegisterNumber(entry));
+    benchRecord("text", "register_define", "ns/line", stats.medianNs, stats);
+}
+
+/**
+ * Reply packing: a telemetry frame whose setpoint bytes include 0x55
+ */
+void test_reply_packing() {
+    stopSineWave();
+    TEST_ASSERT_TRUE(setSignalMode(1, 'v'));
+    TEST_ASSERT_TRUE(setSignalValue(1, 0.85f));  // 85 = 0x0055
+
+    uint8_t frame[TELEMETRY_FRAME_SIZE];
+    uint8_t length = buildTelemetryFrame(frame);
+    TEST_ASSERT_TRUE(memchr(frame, 0x55, length) != nullptr);
+
+    uint8_t packed[RS485_PACKED_SIZE(TELEMETRY_FRAME_SIZE)];
+    uint8_t packedLength = 0;
+    BenchStats stats = benchRun([&](uint32_t) { packedLength = packRS485Payload(frame, length, packed); },
+                                PACK_SAMPLES, WARMUP);
+    TEST_ASSERT_EQUAL_UINT32(RS485_PACKED_SIZE(TELEMETRY_FRAME_SIZE), packedLength);
+    TEST_ASSERT_TRUE(packedLength <= RS485_MAX_REPLY_DATA);
+    TEST_ASSERT_TRUE(memchr(packed, 0x55, packedLength) == nullptr);
+    TEST_ASSERT_TRUE(memchr(packed, 0xAA, packedLength) == nullptr);
+
+    uint8_t unpacked[TELEMETRY_FRAME_SIZE];
+    TEST_ASSERT_EQUAL_UINT32(length, unpackRS485Payload(packed, packedLength, unpacked));
+    TEST_ASSERT_TRUE(memcmp(frame, unpacked, length) == 0);
+    benchRecord("reply", "pack_telemetry", "ns", stats.medianNs, stats);
+
+    // A change notification for the same setpoint, as sent on the bus
+    subscribeChanges(CHANGE_SIG1, 0);
+    uint8_t poll[8];
+    RS485Serial.simReceive(poll, buildFrame(poll, deviceID, CMD_POLL_CHANGES, nullptr, 0));
+    processRS485Commands();
+    TEST_ASSERT_TRUE(dequeueRS485Command());
+    rs485TxLogLength = 0;
+    TEST_ASSERT_TRUE(executeRS485Command(getLastCommand()));
+    subscribeChanges(0, 0);
+
+    // [0xAA][ID][CMD][seq][mask][mode][value u16] packs to 3 + 7 + 1 bytes
+    TEST_ASSERT_EQUAL_UINT32(3 + RS485_PACKED_SIZE(5) + 1, rs485TxLogLength);
+    TEST_ASSERT_EQUAL_UINT32(0xAA, rs485TxLog[0]);
+    TEST_ASSERT_EQUAL_UINT32(0x55, rs485TxLog[rs485TxLogLength - 1]);
+    TEST_ASSERT_TRUE(memchr(&rs485TxLog[3], 0x55, rs485TxLogLength - 4) == nullptr);
+    TEST_ASSERT_TRUE(memchr(&rs485TxLog[3], 0xAA, rs485TxLogLength - 4) == nullptr);
+    uint8_t notification[CHANGE_NOTIFY_MAX_SIZE];
+    TEST_ASSERT_EQUAL_UINT32(5, unpackRS485Payload(&rs485TxLog[3], rs485TxLogLength - 4, notification));
+    TEST_ASSERT_EQUAL_UINT32(CHANGE_SIG1, notification[1]);
+    TEST_ASSERT_EQUAL_UINT32(0x55, notification[4]);
+}
+
+/**
+ * Output journal: a running wave is committed, and restore brings it back
+ */
+void test_journal_restore() {
+    for (uint8_t sig = 1; sig <= 3; sig++) {
+        TEST_ASSERT_TRUE(setSignalMode(sig, 'v'));
+    }
+    TEST_ASSERT_TRUE(setSignalValue(1, 5.0f));
+
+    // The samples move on every update; the journal job must still settle
+    initScheduler();
+    initOutputJournal();
+    startSineWave(2.0f, 3.0f, 5.0f, 1, 'v');
+    uint32_t start = millis();
+    while (millis() - start < JOURNAL_SETTLE_MS + 3 * JOURNAL_CHECK_INTERVAL_MS) {
+        lastUpdateTime = millis() - WAVE_DUE_MS;
+        updateSineWave();
+        runScheduler();
+    }
+    stopSineWave();
+    TEST_ASSERT_TRUE(!isSineWaveActive());
+
+    bool restored = true;
+    BenchStats stats = benchRun(
+        [&](uint32_t) { restored &= restoreOutputJournal(); },
+        RESTORE_SAMPLES, WARMUP / 10,
+        [](uint32_t) { stopSineWave(); });
+    TEST_ASSERT_TRUE(restored);
+    TEST_ASSERT_TRUE(restoreOutputJournal());
+    TEST_ASSERT_TRUE(isSineWaveActive());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 3.0f, getSineWavePeriod());
+    stopSineWave();
+    benchRecord("journal", "restore", "ns", stats.medianNs, stats);
+}
+
+/**
+ * Write the collected results
+ */
+void test_write_results() {
+    benchPrintSummary();
+    TEST_ASSERT_TRUE(benchWriteJson());
+}
+
+int main(int argc, char** argv) {
+    initBench();
+    UNITY_BEGIN();
+    RUN_TEST(test_rs485_parse_throughput);
+    RUN_TEST(test_dispatch_latency);
+    RUN_TEST(test_waveform_generation);
+    RUN_TEST(test_text_parsing);
+    RUN_TEST(test_reply_packing);
+    RUN_TEST(test_journal_restore);
+    RUN_TEST(test_write_results);
+    return UNITY_END();
+}